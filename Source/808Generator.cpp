@@ -1,4 +1,38 @@
 #include "808Generator.h"
+#include "FastMath.h"
+#include "CounterRng.h"
+#include "StageTimers.h"
+
+namespace
+{
+    // Full renders stay on libm so every seed keeps sounding exactly as it did;
+    // drafts are only drawn, so they take FastMath's draft tier.
+    struct LibmMath
+    {
+        static double sin(double x) { return std::sin(x); }
+        static double exp(double x) { return std::exp(x); }
+        static double exp2(double x) { return std::pow(2.0, x); }
+        static double tanh(double x) { return std::tanh(x); }
+        static float tanh(float x) { return std::tanh(x); }
+    };
+
+    struct DraftMath
+    {
+        static double sin(double x) { return FastMath::sin<FastMath::draftAccuracy>((float)x); }
+        static double exp(double x) { return FastMath::exp<FastMath::draftAccuracy>((float)x); }
+        static double exp2(double x) { return FastMath::exp2<FastMath::draftAccuracy>((float)x); }
+        static double tanh(double x) { return FastMath::tanh<FastMath::draftAccuracy>((float)x); }
+        static float tanh(float x) { return FastMath::tanh<FastMath::draftAccuracy>(x); }
+    };
+
+    // The oversampled saturation and soft clip have no older output to match and call tanh two or
+    // four times per sample, so they take the final tier: cheaper than libm by more than it costs
+    struct FinalMath
+    {
+        static double tanh(double x) { return FastMath::tanh<FastMath::finalAccuracy>((float)x); }
+        static float tanh(float x) { return FastMath::tanh<FastMath::finalAccuracy>(x); }
+    };
+}
 
 void Generator808::fillOsc(double phaseInc, double& phase, float* dest, int numSamples)
 {
@@ -10,65 +44,375 @@ void Generator808::fillOsc(double phaseInc, double& phase, float* dest, int numS
     }
 }
 
+const std::vector<Generator808::EngineVersion>& Generator808::getEngineVersions()
+{
+    // append only: once a version has shipped, its output must never change
+    static const std::vector<EngineVersion> versions {
+        { 1, "original: analog noise continues the seed's mt19937_64 stream, one draw per sample" },
+        { 2, "analog noise from CounterRng keyed by seed and sample index, independent of block size, thread and SIMD width" },
+    };
+    return versions;
+}
+
+int Generator808::resolveEngineVersion(int requested)
+{
+    return juce::jlimit(getEngineVersions().front().number, GeneratorParams::latestEngineVersion, requested);
+}
+
+juce::String Generator808::formatSeed(int64_t seed, int engineVersion)
+{
+    return "Seed: " + juce::String((juce::int64)seed) + " (engine v" + juce::String(engineVersion) + ")";
+}
+
+bool Generator808::parseSeed(const juce::String& text, int64_t& seed)
+{
+    const bool negative = text.startsWithChar('-');
+    const auto digits = negative ? text.substring(1) : text;
+    if (digits.isEmpty() || !digits.containsOnly("0123456789") || digits.length() > 19
+        || (digits.length() == 19 && digits.compare(negative ? "9223372036854775808" : "9223372036854775807") > 0))
+        return false;
+
+    seed = (int64_t)text.getLargeIntValue();
+    return true;
+}
+
 juce::AudioBuffer<float> Generator808::renderToBuffer(const GeneratorParams& params)
 {
     int numSamples = (int)std::lround(params.lengthSeconds * params.sampleRate);
-    juce::AudioBuffer<float> buf(2, numSamples);
-    buf.clear();
-    render(params, buf);
+    juce::AudioBuffer<float> buf(getNumOutputChannels(params), numSamples);
+    render(params, buf); // writes every sample, so no clear first
+
+    // auto length keeps the allocation when it trims; this buffer is the caller's to keep
+    if (buf.getNumSamples() < numSamples)
+        releaseUnusedMemory(buf);
+    return buf;
+}
+
+juce::AudioBuffer<float> Generator808::renderDraft(const GeneratorParams& params, double maxSeconds)
+{
+    juce::AudioBuffer<float> buf;
+    renderDraft(params, buf, maxSeconds);
     return buf;
 }
 
+void Generator808::renderDraft(const GeneratorParams& params, juce::AudioBuffer<float>& outBuffer, double maxSeconds)
+{
+    renderDraft(params, state, outBuffer, maxSeconds);
+}
+
+void Generator808::renderDraft(const GeneratorParams& params, State& state, juce::AudioBuffer<float>& outBuffer, double maxSeconds)
+{
+    STAGE_TIMER(draft);
+    const auto p = makeDraftParams(params, maxSeconds);
+    outBuffer.setSize(1, (int)std::lround(p.lengthSeconds * p.sampleRate), false, false, true);
+    renderStages<DraftMath>(p, state, outBuffer, false);
+}
+
+int Generator808::getDraftNumSamples(const GeneratorParams& params, double maxSeconds)
+{
+    const auto p = makeDraftParams(params, maxSeconds);
+    return (int)std::lround(p.lengthSeconds * p.sampleRate);
+}
+
+GeneratorParams Generator808::makeDraftParams(const GeneratorParams& params, double maxSeconds)
+{
+    GeneratorParams p = params;
+    p.sampleRate = juce::jmax(8000.0, params.sampleRate / draftDecimation);
+    p.lengthSeconds = juce::jmin(params.lengthSeconds, maxSeconds);
+    p.oversampling = 1;
+    p.autoLength = false;
+    return p;
+}
+
 void Generator808::render(const GeneratorParams& params, juce::AudioBuffer<float>& outBuffer)
 {
-    // seed
-    rng.seed((uint64_t)params.seed ^ 0x9E3779B97F4A7C15ULL);
+    render(params, state, outBuffer);
+}
+
+void Generator808::render(const GeneratorParams& params, State& state, juce::AudioBuffer<float>& outBuffer)
+{
+    STAGE_TIMER(render);
+    renderStages<LibmMath>(params, state, outBuffer, true);
+}
 
-    // create a mono buffer first
-    int numSamples = outBuffer.getNumSamples();
-    juce::AudioBuffer<float> mono(1, numSamples);
-    mono.clear();
+template <typename Math>
+void Generator808::renderStages(const GeneratorParams& params, State& state, juce::AudioBuffer<float>& outBuffer, bool withStereoWidth)
+{
+    // Runs every stage on one blockSize chunk before moving to the next, so the working set stays in
+    // L1 instead of each stage streaming full-length buffers through memory. Same arithmetic in the
+    // same order as the stage functions below, so the output is identical to running those in turn.
+    // without width the output is a single channel (see getNumOutputChannels)
+    juce::ScopedNoDenormals noDenormals;
+    const bool widthOn = withStereoWidth && getNumOutputChannels(params) == 2;
+    const int numSamples = outBuffer.getNumSamples();
+    outBuffer.setSize(widthOn ? 2 : 1, numSamples, false, false, true);
+
+    // the width stage reads mono up to maxDelay samples either side of the current one, so the
+    // mono chain runs ahead into a ring big enough for a block plus that window on both sides
+    const int maxDelay = widthOn ? getMaxWidthDelay(params) : 0;
+
+    int ringSize = blockSize;
+    while (ringSize < 2 * (blockSize + maxDelay))
+        ringSize <<= 1;
+    if ((int)state.monoRing.size() < ringSize)
+        state.monoRing.resize((size_t)ringSize);
+
+    float* ring = state.monoRing.data();
+    const int ringMask = ringSize - 1;
+
+    if ((int)state.chainBlock.size() < blockSize)
+        state.chainBlock.resize((size_t)blockSize);
+
+    float* block = state.chainBlock.data();
+
+    startOscillator(state, params);
+    startFilter(state, params);
+    state.clipOversamplers[0].setFactor(params.oversampling);
+    state.clipOversamplers[1].setFactor(params.oversampling);
+
+    const float gain = GeneratorVoiceUtils::dBToGain(params.masterGainDb);
+    float* left = outBuffer.getWritePointer(0);
+    float* right = widthOn ? outBuffer.getWritePointer(1) : nullptr;
+    int numRendered = 0, numMono = 0, numOut = 0;
+
+    TailDetector tail(params);
+
+    for (int start = 0; start < numSamples; start += blockSize)
+    {
+        const int num = juce::jmin(blockSize, numSamples - start);
 
+        // oscillator + filter/saturation. The chain runs a block at a time and only the samples the
+        // filter stage has finished go into the ring (oversampled, the first ones come out late)
+        const int monoNeeded = juce::jmin(numSamples, start + num + maxDelay);
+        while (numMono < monoNeeded)
+        {
+            int ready;
+            if (numRendered < numSamples)
+            {
+                const int chunk = juce::jmin(blockSize, numSamples - numRendered);
+                {
+                    STAGE_TIMER(oscillator);
+                    renderOscillator<Math>(state, params, block, numRendered, chunk);
+                }
+                {
+                    STAGE_TIMER(filter);
+                    ready = renderFilter<Math>(state, params, block, chunk);
+                }
+                numRendered += chunk;
+            }
+            else
+            {
+                STAGE_TIMER(filter);
+                ready = flushFilter(state, block);
+            }
+
+            for (int k = 0; k < ready; ++k)
+                ring[(numMono + k) & ringMask] = block[k];
+            numMono += ready;
+        }
+
+        // copy out + width
+        {
+            STAGE_TIMER(width);
+            for (int i = start; i < start + num; ++i)
+                left[i] = ring[i & ringMask];
+
+            if (widthOn)
+                for (int i = start; i < start + num; ++i)
+                    right[i] = 0.6f * left[i] + 0.4f * ring[getWidthSourceIndex(params, i, numSamples) & ringMask];
+        }
+
+        // gain + soft clip, in place; oversampled, the output lags the block it was given
+        const int numFinished = numOut;
+        {
+            STAGE_TIMER(output);
+            if (widthOn)
+            {
+                applyGain(right + start, num, gain);
+                applySoftClip<Math>(state.clipOversamplers[1], right + start, right + numOut, num);
+            }
+            applyGain(left + start, num, gain);
+            numOut += applySoftClip<Math>(state.clipOversamplers[0], left + start, left + numOut, num);
+        }
+
+        // auto length: stop as soon as the 808 has ended, the rest is never rendered
+        if (params.autoLength)
+        {
+            STAGE_TIMER(trim);
+            if (tail.update(outBuffer, numFinished, numOut))
+            {
+                tail.trim(outBuffer);
+                return;
+            }
+        }
+    }
+
+    if (numOut < numSamples)
+    {
+        {
+            STAGE_TIMER(output);
+            if (widthOn)
+                flushSoftClip(state.clipOversamplers[1], right + numOut);
+            flushSoftClip(state.clipOversamplers[0], left + numOut);
+        }
+
+        if (params.autoLength)
+        {
+            STAGE_TIMER(trim);
+            if (tail.update(outBuffer, numOut, numSamples))
+                tail.trim(outBuffer);
+        }
+    }
+}
+
+void Generator808::trimToTail(const GeneratorParams& params, juce::AudioBuffer<float>& buffer)
+{
+    STAGE_TIMER(trim);
+    TailDetector tail(params);
+    if (params.autoLength && tail.update(buffer, 0, buffer.getNumSamples()))
+    {
+        tail.trim(buffer);
+        releaseUnusedMemory(buffer);
+    }
+}
+
+void Generator808::releaseUnusedMemory(juce::AudioBuffer<float>& buffer)
+{
+    // setSize never shrinks an allocation, a fresh copy is sized exactly
+    juce::AudioBuffer<float> exact;
+    exact.makeCopyOf(buffer);
+    buffer = std::move(exact);
+}
+
+Generator808::TailDetector::TailDetector(const GeneratorParams& p)
+    : floor(juce::Decibels::decibelsToGain(p.silenceFloorDb, -1000.0f)),
+      holdSamples(juce::jmax(1, (int)std::lround(tailHoldSeconds * p.sampleRate))),
+      fadeSamples(juce::jmax(1, (int)std::lround(tailFadeSeconds * p.sampleRate)))
+{
+}
+
+bool Generator808::TailDetector::update(const juce::AudioBuffer<float>& buffer, int startSample, int endSample)
+{
+    const float* left = buffer.getReadPointer(0);
+    const float* right = buffer.getReadPointer(buffer.getNumChannels() > 1 ? 1 : 0);
+
+    for (int i = startSample; i < endSample; ++i)
+    {
+        if (std::abs(left[i]) >= floor || std::abs(right[i]) >= floor)
+            quietStart = i + 1;
+        else if (i + 1 - quietStart >= holdSamples)
+            return true;
+    }
+
+    return false;
+}
+
+void Generator808::TailDetector::trim(juce::AudioBuffer<float>& buffer) const
+{
+    // a render that never rose above the floor still keeps one fade's worth of (silent) samples
+    const int length = juce::jmin(buffer.getNumSamples(), juce::jmax(quietStart, fadeSamples));
+    const int fade = juce::jmin(fadeSamples, length);
+
+    for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+        buffer.applyGainRamp(ch, length - fade, fade, 1.0f, 0.0f);
+
+    // keeps the allocation, so a reused buffer doesn't reallocate on every render
+    buffer.setSize(buffer.getNumChannels(), length, true, false, true);
+}
+
+void Generator808::renderOscillatorStage(const GeneratorParams& params, juce::AudioBuffer<float>& mono)
+{
     // generate raw waveform in mono
-    generateWaveform(params, mono);
+    juce::ScopedNoDenormals noDenormals;
+    STAGE_TIMER(oscillator);
+    startOscillator(state, params);
+    renderOscillator<LibmMath>(state, params, mono.getWritePointer(0), 0, mono.getNumSamples());
+}
 
+void Generator808::renderFilterStage(const GeneratorParams& params, juce::AudioBuffer<float>& mono)
+{
     // filtering / saturation / tone shaping
-    applyFilterAndSaturation(mono, params);
+    juce::ScopedNoDenormals noDenormals;
+    STAGE_TIMER(filter);
+    startFilter(state, params);
+    float* data = mono.getWritePointer(0);
+    const int ready = renderFilter<LibmMath>(state, params, data, mono.getNumSamples());
+    flushFilter(state, data + ready);
+}
 
-    // write into stereo with optional width processing
+void Generator808::renderWidthStage(const GeneratorParams& params, const juce::AudioBuffer<float>& mono,
+                                    juce::AudioBuffer<float>& outBuffer)
+{
+    // copy into the output layout (stereo only when there is width to add)
+    juce::ScopedNoDenormals noDenormals;
+    STAGE_TIMER(width);
+    int numSamples = mono.getNumSamples();
+    outBuffer.setSize(getNumOutputChannels(params), numSamples, false, false, true);
     outBuffer.clear();
-    outBuffer.addFrom(0, 0, mono, 0, 0, numSamples);
-    outBuffer.addFrom(1, 0, mono, 0, 0, numSamples);
+    for (int ch = 0; ch < outBuffer.getNumChannels(); ++ch)
+        outBuffer.addFrom(ch, 0, mono, 0, 0, numSamples);
 
     // stereo width (detune/chorus / keep below 120Hz mono-summed)
     applyStereoWidth(outBuffer, params);
+}
 
+void Generator808::renderOutputStage(const GeneratorParams& params, juce::AudioBuffer<float>& outBuffer)
+{
     // apply master gain and final limiter-ish normalization
+    juce::ScopedNoDenormals noDenormals;
+    STAGE_TIMER(output);
     float gain = GeneratorVoiceUtils::dBToGain(params.masterGainDb);
-    outBuffer.applyGain(gain);
+    auto& oversampler = state.clipOversamplers[0];
+    oversampler.setFactor(params.oversampling);
 
-    // quick soft clip to avoid hard digital clipping
     for (int ch = 0; ch < outBuffer.getNumChannels(); ++ch)
     {
         float* data = outBuffer.getWritePointer(ch);
-        for (int i = 0; i < numSamples; ++i)
-        {
-            // soft clip using tanh-like curve
-            float x = data[i];
-            // simple soft clip
-            float clipped = std::tanh(x * 1.2f);
-            data[i] = clipped;
-        }
+        applyGain(data, outBuffer.getNumSamples(), gain);
+
+        oversampler.reset();
+        const int ready = applySoftClip<LibmMath>(oversampler, data, data, outBuffer.getNumSamples());
+        flushSoftClip(oversampler, data + ready);
     }
 }
 
-void Generator808::generateWaveform(const GeneratorParams& p, juce::AudioBuffer<float>& bufMono)
+void Generator808::applyGain(float* data, int numSamples, float gain)
 {
-    int ns = bufMono.getNumSamples();
-    float* dst = bufMono.getWritePointer(0);
+    // same as AudioBuffer::applyGain: unity gain is skipped and zero gain clears
+    if (juce::approximatelyEqual(gain, 0.0f))
+        juce::FloatVectorOperations::clear(data, numSamples);
+    else if (!juce::approximatelyEqual(gain, 1.0f))
+        juce::FloatVectorOperations::multiply(data, gain, numSamples);
+}
+
+template <typename Math>
+float Generator808::softClip(float x)
+{
+    // quick soft clip to avoid hard digital clipping
+    return Math::tanh(x * 1.2f);
+}
+
+template <typename Math>
+int Generator808::applySoftClip(Oversampler& oversampler, const float* src, float* dest, int numSamples)
+{
+    if (oversampler.getFactor() == 1)
+        return oversampler.process(src, dest, numSamples, softClip<Math>);
+
+    return oversampler.process(src, dest, numSamples, softClip<FinalMath>);
+}
+
+int Generator808::flushSoftClip(Oversampler& oversampler, float* dest)
+{
+    return oversampler.flush(dest, softClip<FinalMath>);
+}
+
+void Generator808::startOscillator(State& state, const GeneratorParams& p)
+{
+    // seed: the note and glide are the first two draws in every engine version
+    state.rng.seed(rngSeedFor(p.seed));
 
     // pick a base MIDI note low in the 808 range: prefer 28-45 (~35–70 Hz)
-    double baseMidi = 32.0 + (random01() * 10.0); // 32..42
+    double baseMidi = 32.0 + (state.random01() * 10.0); // 32..42
     baseMidi += p.tuneSemitones;
     double freq = midiNoteToFreq(baseMidi);
 
@@ -76,62 +420,75 @@ void Generator808::generateWaveform(const GeneratorParams& p, juce::AudioBuffer<
     double subBias = (double)p.subAmount * -2.0; // lower by up to -2 semitones
     freq *= std::pow(2.0, subBias / 12.0);
 
-    // oscillator phases
-    double phase = 0.0;
-    double phase2 = 0.0;
+    auto& osc = state.chain.osc;
+    osc.freq = freq;
 
-    double sr = p.sampleRate;
-    double phi = juce::MathConstants<double>::twoPi * freq / sr;
-    double phi2 = juce::MathConstants<double>::twoPi * freq * 2.0 / sr; // 2nd harmonic
+    // oscillator phases
+    osc.phase = 0.0;
+    osc.phase2 = 0.0;
+    osc.phi2 = juce::MathConstants<double>::twoPi * freq * 2.0 / p.sampleRate; // 2nd harmonic
 
     // envelopes
     // base durations (in seconds)
     double baseDecay = 0.8;
     baseDecay *= (1.0 + 0.8 * (double)p.boomAmount); // boomy → longer
     baseDecay *= (0.4 + 0.6 * (1.0 - (double)p.shortness)); // shortness reduces decay
-    double attack = 0.002;
-    double release = baseDecay * 0.5;
+    osc.baseDecay = baseDecay;
 
     // pitch pitch glide for punch (fast downward)
-    double pitchGlideSec = 0.015 + 0.010 * random01();
-    double maxPitchDrop = 0.24 + 1.0 * p.punch; // in semitones downward
+    osc.pitchGlideSec = 0.015 + 0.010 * state.random01();
+    osc.maxPitchDrop = 0.24 + 1.0 * p.punch; // in semitones downward
+
+    // per-sample noise: v1 draws on from the rng, later versions are counter-based (renderOscillator)
+    osc.serialNoise = resolveEngineVersion(p.engineVersion) == 1;
+    osc.noiseKey = CounterRng::keyFor((uint64_t)p.seed, analogNoiseStream);
+}
+
+template <typename Math>
+void Generator808::renderOscillator(State& state, const GeneratorParams& p, float* dst, int startSample, int numSamples)
+{
+    auto& osc = state.chain.osc;
+    const double sr = p.sampleRate;
+    const double freq = osc.freq;
+    const double attack = 0.002;
 
     // amplitude envelope immediate values
-    for (int i = 0; i < ns; ++i)
+    for (int i = startSample; i < startSample + numSamples; ++i)
     {
         double t = (double)i / sr;
 
         // amp env (simple one-pole ADSR-ish)
         double env;
         if (t < attack) env = t / attack;
-        else env = std::exp(-(t - attack) / baseDecay);
+        else env = Math::exp(-(t - attack) / osc.baseDecay);
 
         // pitch envelope: exponential drop
         double pitchMult = 1.0;
-        if (t < pitchGlideSec)
+        if (t < osc.pitchGlideSec)
         {
-            double frac = t / pitchGlideSec;
-            double drop = maxPitchDrop * (1.0 - frac); // semitone drop that decays to 0
-            pitchMult = std::pow(2.0, -drop / 12.0);
+            double frac = t / osc.pitchGlideSec;
+            double drop = osc.maxPitchDrop * (1.0 - frac); // semitone drop that decays to 0
+            pitchMult = Math::exp2(-drop / 12.0);
         }
 
         // main osc
         double curPhi = juce::MathConstants<double>::twoPi * freq * pitchMult / sr;
-        double s1 = std::sin(phase);
-        phase += curPhi;
-        if (phase > juce::MathConstants<double>::twoPi) phase -= juce::MathConstants<double>::twoPi;
+        double s1 = Math::sin(osc.phase);
+        osc.phase += curPhi;
+        if (osc.phase > juce::MathConstants<double>::twoPi) osc.phase -= juce::MathConstants<double>::twoPi;
 
         // second harmonic for character
-        double s2 = std::sin(phase2);
-        phase2 += phi2;
-        if (phase2 > juce::MathConstants<double>::twoPi) phase2 -= juce::MathConstants<double>::twoPi;
+        double s2 = Math::sin(osc.phase2);
+        osc.phase2 += osc.phi2;
+        if (osc.phase2 > juce::MathConstants<double>::twoPi) osc.phase2 -= juce::MathConstants<double>::twoPi;
 
         // optional FM/growl (modulator simple)
         double fm = 0.0;
         if (p.growl > 0.001f)
         {
-            double modFreq = freq * (1.8 + 1.2 * random01());
-            double modPhase = std::sin(phase2 * 0.5 + 0.3);
+            if (osc.serialNoise)
+                state.random01(); // v1's modulator frequency draw; unused, but part of its noise sequence
+            double modPhase = Math::sin(osc.phase2 * 0.5 + 0.3);
             fm = p.growl * 0.25 * modPhase;
         }
 
@@ -143,95 +500,130 @@ void Generator808::generateWaveform(const GeneratorParams& p, juce::AudioBuffer<
         if (p.subAmount > 0.001f)
         {
             double subFreq = freq * 0.5; // 1 octave below partial
-            double subPhase = std::sin(juce::MathConstants<double>::twoPi * subFreq * ((double)i / sr));
+            double subPhase = Math::sin(juce::MathConstants<double>::twoPi * subFreq * ((double)i / sr));
             sub = p.subAmount * 0.8 * subPhase;
         }
 
         // combined
         double sample = (body * (1.0 - p.subAmount * 0.5)) + sub;
 
-        // random micro-analog noise
+        // random micro-analog noise, keyed by sample index so it doesn't depend on how the render is split
         if (p.analog > 0.001f)
-            sample += ((random01() - 0.5) * 0.002 * p.analog);
+        {
+            const double u = osc.serialNoise ? state.random01() : CounterRng::uniform01(osc.noiseKey, (uint64_t)i);
+            sample += ((u - 0.5) * 0.002 * p.analog);
+        }
 
         // apply amplitude env and a bit of compression by saturating follow
         double out = sample * env;
 
-        dst[i] = (float)out;
+        dst[i - startSample] = (float)out;
     }
 }
 
-void Generator808::applyFilterAndSaturation(juce::AudioBuffer<float>& bufMono, const GeneratorParams& p)
+void Generator808::startFilter(State& state, const GeneratorParams& p)
 {
-    using Filter = juce::dsp::IIR::Filter<float>;
-    juce::dsp::IIR::Coefficients<float>::Ptr lowpassCoeffs =
-        juce::dsp::IIR::Coefficients<float>::makeLowPass((float)p.sampleRate, 1400.0f, 0.7f);
-
-    Filter lp;
-    lp.coefficients = lowpassCoeffs;
+    auto& f = state.chain.filter;
 
-    // process in place
-    juce::dsp::AudioBlock<float> block(bufMono);
-    juce::dsp::ProcessContextReplacing<float> ctx(block);
-    lp.reset();
-    lp.process(ctx);
+    // lowpass coefficients from juce; the filter itself is run in renderFilter so its state
+    // carries across blocks (juce::dsp::IIR::Filter snaps its state to zero after every call).
+    // ArrayCoefficients is what Coefficients::makeLowPass wraps, without the heap allocation;
+    // a0 is 1, so the normalisation Coefficients does changes nothing
+    const auto c = juce::dsp::IIR::ArrayCoefficients<float>::makeLowPass((float)p.sampleRate, 1400.0f, 0.7f);
+    f.b0 = c[0]; f.b1 = c[1]; f.b2 = c[2]; f.a1 = c[4]; f.a2 = c[5];
+    f.lv1 = f.lv2 = 0.0f;
 
     // mild EQ boosts for 'boomy' and 'punchy' simulated as simple shelf & band gain via hand-coded processing
-    float* data = bufMono.getWritePointer(0);
-    int ns = bufMono.getNumSamples();
-
     float lowShelfCenter = 60.0f;
-    float lowShelfGain = 1.0f + p.boomAmount * 0.5f; // linear multiplier
-    float clickBoostGain = 1.0f + p.punch * 0.5f;
+    f.lowShelfGain = 1.0f + p.boomAmount * 0.5f; // linear multiplier
 
     // crude low-shelf: multiply low freq content by lowShelfGain
     // simple approach: apply sample-by-sample running lowpass to isolate lows and amplify
-    double a = 0.0;
     double rc = 1.0 / (2.0 * juce::MathConstants<double>::pi * lowShelfCenter);
     double dt = 1.0 / p.sampleRate;
-    double alpha = dt / (rc + dt);
-    float prevLow = 0.0f;
-    for (int i = 0; i < ns; ++i)
-    {
-        float s = data[i];
-        prevLow = (float)(prevLow + alpha * (s - prevLow));
-        // Boost lows
-        data[i] += (prevLow * (lowShelfGain - 1.0f));
-    }
+    f.alpha = dt / (rc + dt);
+    f.prevLow = 0.0f;
+
+    f.drive = 1.0 + p.analog * 0.5f;
 
+    state.saturationOversampler.setFactor(p.oversampling);
+}
+
+template <typename Math>
+float Generator808::saturate(float x, double drive)
+{
     // very light soft saturation to taste
-    for (int i = 0; i < ns; ++i)
+    return (float)((x < -1.0f) ? -1.0f : (x > 1.0f ? 1.0f : Math::tanh(x * drive)));
+}
+
+template <typename Math>
+int Generator808::renderFilter(State& state, const GeneratorParams&, float* data, int numSamples)
+{
+    auto& f = state.chain.filter;
+    float lv1 = f.lv1, lv2 = f.lv2, prevLow = f.prevLow;
+    const bool oversampled = state.saturationOversampler.getFactor() > 1;
+
+    for (int i = 0; i < numSamples; ++i)
     {
-        float x = data[i];
-        // soft clip curve
-        data[i] = (float)((x < -1.0f) ? -1.0f : (x > 1.0f ? 1.0f : std::tanh(x * (1.0 + p.analog * 0.5f))));
+        // biquad lowpass, transposed direct form II like juce::dsp::IIR::Filter
+        float input = data[i];
+        float s = (input * f.b0) + lv1;
+        lv1 = (input * f.b1) - (s * f.a1) + lv2;
+        lv2 = (input * f.b2) - (s * f.a2);
+
+        // Boost lows
+        prevLow = (float)(prevLow + f.alpha * (s - prevLow));
+        float x = s + (prevLow * (f.lowShelfGain - 1.0f));
+
+        data[i] = oversampled ? x : saturate<Math>(x, f.drive);
     }
+
+    f.lv1 = lv1;
+    f.lv2 = lv2;
+    f.prevLow = prevLow;
+
+    if (!oversampled)
+        return numSamples;
+
+    const double drive = f.drive;
+    return state.saturationOversampler.process(data, data, numSamples, [drive](float x) { return saturate<FinalMath>(x, drive); });
+}
+
+int Generator808::flushFilter(State& state, float* dest)
+{
+    const double drive = state.chain.filter.drive;
+    return state.saturationOversampler.flush(dest, [drive](float x) { return saturate<FinalMath>(x, drive); });
+}
+
+int Generator808::getMaxWidthDelay(const GeneratorParams& p)
+{
+    // |mod| <= 0.0005, see getWidthSourceIndex
+    return (int)std::ceil(0.0005 * p.sampleRate * p.detune * 20.0) + 1;
+}
+
+int Generator808::getWidthSourceIndex(const GeneratorParams& p, int i, int ns)
+{
+    // crude approach: mix a delayed, slightly pitch-shifted version into right channel
+    // We'll apply a simple small-sample delay modulation for illusion of detune (cheap chorus)
+    double mod = 0.0005 * std::sin(2.0 * juce::MathConstants<double>::pi * 0.8 * i / (double)ns); // tiny LFO
+    int delaySamples = (int)std::round(mod * p.sampleRate * p.detune * 20.0);
+    return juce::jlimit(0, ns - 1, i - delaySamples);
 }
 
 void Generator808::applyStereoWidth(juce::AudioBuffer<float>& bufStereo, const GeneratorParams& p)
 {
     // Keep sub below 120Hz mono. We will add a small stereo high-frequency component if detune > 0
-    int ns = bufStereo.getNumSamples();
-    auto left = bufStereo.getWritePointer(0);
-    auto right = bufStereo.getWritePointer(1);
-
-    if (p.detune < 0.001f)
+    if (p.detune < 0.001f || bufStereo.getNumChannels() < 2)
     {
-        // mono content already duplicated; nothing else
+        // mono: the buffer is a single channel (see getNumOutputChannels); nothing else
         return;
     }
 
-    // create tiny phase-shifted copy for right channel to simulate detune/width
-    double detuneCents = 5.0 + 15.0 * p.detune; // 5..20 cents
-    double detuneFactor = std::pow(2.0, detuneCents / 1200.0);
+    int ns = bufStereo.getNumSamples();
+    auto left = bufStereo.getWritePointer(0);
+    auto right = bufStereo.getWritePointer(1);
 
+    // create tiny phase-shifted copy for right channel to simulate detune/width
     for (int i = 0; i < ns; ++i)
-    {
-        // crude approach: mix a delayed, slightly pitch-shifted version into right channel
-        // We'll apply a simple small-sample delay modulation for illusion of detune (cheap chorus)
-        double mod = 0.0005 * std::sin(2.0 * juce::MathConstants<double>::pi * 0.8 * i / (double)ns); // tiny LFO
-        int delaySamples = (int)std::round(mod * p.sampleRate * p.detune * 20.0);
-        int idx = juce::jlimit(0, ns - 1, i - delaySamples);
-        right[i] = 0.6f * right[i] + 0.4f * left[idx];
-    }
+        right[i] = 0.6f * right[i] + 0.4f * left[getWidthSourceIndex(p, i, ns)];
 }
@@ -1,5 +1,6 @@
 #pragma once
 #include <JuceHeader.h>
+#include "Oversampler.h"
 #include <random>
 #include <map>
 #include <string>
@@ -21,6 +22,18 @@ struct GeneratorParams
     float detune = 0.0f;
     float analog = 0.0f;
     float clean = 0.0f;
+    // 1, 2 or 4: rate the saturation and the final soft clip run at, to keep them from aliasing
+    int oversampling = 1;
+    // auto length: lengthSeconds becomes the longest the render may be. It stops once the output has
+    // stayed below silenceFloorDb (dBFS) for Generator808::tailHoldSeconds, fades out and is trimmed there
+    bool autoLength = false;
+    float silenceFloorDb = -90.0f;
+    // the Generator808 engine that renders these params (see Generator808::getEngineVersions). A seed
+    // keeps sounding the same as long as it's rendered with the version it was made with. Left unset
+    // it is v1, the engine from before versions existed, so old seeds and requests that don't name a
+    // version keep their sound; whatever makes a new 808 sets latestEngineVersion
+    static constexpr int latestEngineVersion = 2;
+    int engineVersion = 1;
 };
 
 class GeneratorVoiceUtils
@@ -33,27 +46,182 @@ public:
 class Generator808
 {
 public:
+    // Everything a render writes besides its output: the RNG, the state the chain carries from block
+    // to block, the oversamplers and the look-ahead buffers. Owned by the caller; only the render
+    // functions look inside.
+    class State
+    {
+    public:
+        State() = default;
+
+    private:
+        friend class Generator808;
+
+        std::mt19937_64 rng;
+        std::uniform_real_distribution<double> uni{0.0, 1.0};
+
+        double random01() { return uni(rng); }
+
+        // state the oscillator and filter stages carry from one block to the next
+        struct
+        {
+            struct
+            {
+                double freq = 0.0, phi2 = 0.0, baseDecay = 1.0, pitchGlideSec = 0.0, maxPitchDrop = 0.0;
+                double phase = 0.0, phase2 = 0.0;
+                uint64_t noiseKey = 0;     // CounterRng stream of the analog noise
+                bool serialNoise = false;  // engine v1: the noise continues the rng stream instead
+            } osc;
+
+            struct
+            {
+                float b0 = 0.0f, b1 = 0.0f, b2 = 0.0f, a1 = 0.0f, a2 = 0.0f, lv1 = 0.0f, lv2 = 0.0f;
+                double alpha = 0.0, drive = 1.0;
+                float lowShelfGain = 1.0f, prevLow = 0.0f;
+            } filter;
+        } chain;
+
+        Oversampler saturationOversampler;
+        Oversampler clipOversamplers[2];  // left, right
+        std::vector<float> monoRing;      // renderStages' look-ahead buffer, reused between renders
+        std::vector<float> chainBlock;    // renderStages' oscillator + filter output before it goes into the ring
+
+        JUCE_DECLARE_NON_COPYABLE(State)
+    };
+
     Generator808() = default;
     ~Generator808() = default;
 
-    // Render method: fills a stereo buffer (mono sub summed into both channels appropriately)
+    // Engine versions. A change that alters the output of existing params ships as a new version,
+    // and the old ones keep rendering bit-identically, so shared seeds sound the same forever under
+    // the version they were made with. Versions before the first render as the first and versions
+    // after the latest as the latest; --check-engines keeps golden renders of every version
+    struct EngineVersion
+    {
+        int number;
+        const char* description;
+    };
+
+    static const std::vector<EngineVersion>& getEngineVersions();
+    static int resolveEngineVersion(int requested);
+
+    // how a seed is shown and copied everywhere, "Seed: N (engine vK)" (PluginEditor::parseSeed reads it back)
+    static juce::String formatSeed(int64_t seed, int engineVersion);
+
+    // a seed written as text: an optional minus sign, then digits, no more than an int64 holds.
+    // False for anything else ("", "-", "--5", "12a", out of range), leaving seed alone
+    static bool parseSeed(const juce::String& text, int64_t& seed);
+
+    // The reentrant core: renders params using only the given State, which it resets first, so
+    // the output depends on params alone. Nothing else is written (params are only read), so any
+    // number of threads can render at once, sharing params or not, each with a State of its own.
+    // --stress-threads checks this. A reused State keeps its buffers (see RenderContext).
+    // Every render runs with denormals flushed to zero (juce::ScopedNoDenormals, restored on return):
+    // the envelope, the biquad and the shelf all decay towards zero, and denormal arithmetic in those
+    // tails is many times slower on x86. --check-denormals times the tails
+    static void render(const GeneratorParams& params, State& state, juce::AudioBuffer<float>& outBuffer);
+    static void renderDraft(const GeneratorParams& params, State& state, juce::AudioBuffer<float>& outBuffer,
+                            double maxSeconds = 1.0);
+
+    // Render method: fills the buffer with getNumOutputChannels(params) channels.
+    // With params.autoLength the buffer is shrunk to where the 808 actually ends (keeping its
+    // allocation). Once the generator has rendered at the same settings, render doesn't allocate
+    // unless outBuffer has to grow (see RenderContext).
+    // The non-static functions use the generator's own State, so an instance is one thread's.
     void render(const GeneratorParams& params, juce::AudioBuffer<float>& outBuffer);
 
+    // The channel layout of a render: without detune the width stage leaves both channels identical,
+    // so the result is kept as one channel instead of two copies. Whatever plays or exports it
+    // duplicates that channel where it needs stereo (see WavExporter / PluginProcessor::renderPreview).
+    static int getNumOutputChannels(const GeneratorParams& params) { return params.detune >= 0.001f ? 2 : 1; }
+
     // Convenience: return wav data in a float buffer
     juce::AudioBuffer<float> renderToBuffer(const GeneratorParams& params);
 
+    // Cheap preview for interactive edits: same seed and character, but rendered at
+    // 1/draftDecimation of the sample rate, capped at maxSeconds, without the stereo stage or
+    // oversampling and with FastMath's draft tier instead of libm.
+    // For display only; the buffer is mono and its rate is params.sampleRate / draftDecimation.
+    static constexpr int draftDecimation = 4;
+    juce::AudioBuffer<float> renderDraft(const GeneratorParams& params, double maxSeconds = 1.0);
+    void renderDraft(const GeneratorParams& params, juce::AudioBuffer<float>& outBuffer, double maxSeconds = 1.0);
+    static int getDraftNumSamples(const GeneratorParams& params, double maxSeconds = 1.0);
+
+    // Auto length: the output ends at the first sample after which both channels stay below the floor
+    // for tailHoldSeconds (long enough to span a cycle of the lowest 808 note, so zero crossings don't
+    // count), with a linear fade over the last tailFadeSeconds before it. The envelope only decays, so
+    // nothing audible comes after. If the output never goes quiet it keeps its full length.
+    static constexpr double tailHoldSeconds = 0.05, tailFadeSeconds = 0.01;
+
+    // what render() does at the end of an autoLength render, for callers that run the stages
+    // themselves (StagedGenerator); the result is the same as render()'s. Does nothing without autoLength.
+    static void trimToTail(const GeneratorParams& params, juce::AudioBuffer<float>& buffer);
+
+    // the CounterRng stream of params.seed the analog noise comes from, sample i being number i
+    static constexpr uint64_t analogNoiseStream = 0;
+
+    // what the mt19937_64 is seeded with for params.seed: the note and glide are its first two draws
+    // in every engine version, and v1's analog noise continues the stream
+    static uint64_t rngSeedFor(int64_t seed) noexcept { return (uint64_t)seed ^ 0x9E3779B97F4A7C15ULL; }
+
+    // The stages render() runs, in order, for callers that keep intermediate results (StagedGenerator).
+    // StageTimers times each of them here and inside render() (--stats / --trace on any command).
+    // renderOscillatorStage picks the note from params.seed and overwrites the mono buffer.
+    void renderOscillatorStage(const GeneratorParams& params, juce::AudioBuffer<float>& mono);
+    void renderFilterStage(const GeneratorParams& params, juce::AudioBuffer<float>& mono);   // lowpass, shelf, saturation
+    void renderWidthStage(const GeneratorParams& params, const juce::AudioBuffer<float>& mono,
+                          juce::AudioBuffer<float>& out);   // copy to getNumOutputChannels channels + width
+    void renderOutputStage(const GeneratorParams& params, juce::AudioBuffer<float>& out);     // master gain + soft clip
+
 private:
-    std::mt19937_64 rng;
-    std::uniform_real_distribution<double> uni{0.0, 1.0};
+    // render() and renderDraft(): the whole chain one blockSize chunk at a time.
+    // Math is the policy the per-sample loops call sin/exp/tanh through (see 808Generator.cpp)
+    static constexpr int blockSize = 256;
+    template <typename Math>
+    static void renderStages(const GeneratorParams& params, State& state, juce::AudioBuffer<float>& outBuffer,
+                             bool withStereoWidth);
+
+    static double midiNoteToFreq(double midi) { return 440.0 * std::pow(2.0, (midi - 69.0) / 12.0); }
+
+    static void fillOsc(double phaseInc, double& phase, float* dest, int numSamples);
+
+    // core generation helpers: start* resets a stage, render* continues it for the next samples.
+    // With params.oversampling > 1 the saturation and soft clip run through an Oversampler (on
+    // FastMath's final tier) and hand their samples back late: renderFilter and applySoftClip return
+    // how many finished samples they wrote to the start of their output, and the flush* calls write
+    // the rest once the input ends
+    static void startOscillator(State& state, const GeneratorParams& p);
+    template <typename Math> static void renderOscillator(State& state, const GeneratorParams& p, float* dest,
+                                                          int startSample, int numSamples);
+    static void startFilter(State& state, const GeneratorParams& p);
+    template <typename Math> static int renderFilter(State& state, const GeneratorParams& p, float* data, int numSamples);
+    static int flushFilter(State& state, float* dest);
+    template <typename Math> static float saturate(float x, double drive);
+    static void applyGain(float* data, int numSamples, float gain);
+    template <typename Math> static float softClip(float x);
+    template <typename Math> static int applySoftClip(Oversampler& oversampler, const float* src, float* dest, int numSamples);
+    static int flushSoftClip(Oversampler& oversampler, float* dest);
+    static void applyStereoWidth(juce::AudioBuffer<float>& bufStereo, const GeneratorParams& p);
+    static int getWidthSourceIndex(const GeneratorParams& p, int i, int numSamples);
+    static int getMaxWidthDelay(const GeneratorParams& p);
+    static void releaseUnusedMemory(juce::AudioBuffer<float>& buffer);
+    static GeneratorParams makeDraftParams(const GeneratorParams& params, double maxSeconds);
+
+    // finds the end of an autoLength render from finished output, fed in order a block at a time
+    struct TailDetector
+    {
+        explicit TailDetector(const GeneratorParams& p);
 
-    double random01() { return uni(rng); }
+        // true once the end has been found (it doesn't depend on how the output is split into blocks)
+        bool update(const juce::AudioBuffer<float>& buffer, int startSample, int endSample);
 
-    double midiNoteToFreq(double midi) { return 440.0 * std::pow(2.0, (midi - 69.0) / 12.0); }
+        // trims the buffer at the end that update() found, fading out into it
+        void trim(juce::AudioBuffer<float>& buffer) const;
 
-    void fillOsc(double phaseInc, double& phase, float* dest, int numSamples);
+        float floor = 0.0f;
+        int holdSamples = 0, fadeSamples = 0;
+        int quietStart = 0;  // one past the last sample at or above the floor
+    };
 
-    // core generation helpers
-    void generateWaveform(const GeneratorParams& p, juce::AudioBuffer<float>& bufMono);
-    void applyFilterAndSaturation(juce::AudioBuffer<float>& bufMono, const GeneratorParams& p);
-    void applyStereoWidth(juce::AudioBuffer<float>& bufStereo, const GeneratorParams& p);
+    State state;  // what the non-static functions render with
 };
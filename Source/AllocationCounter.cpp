@@ -0,0 +1,75 @@
+#include "AllocationCounter.h"
+#include "RealtimeChecker.h"
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    // the innermost live counter on this thread (plain pointer: no dynamic thread_local init)
+    thread_local juce::int64* activeCount = nullptr;
+}
+
+AllocationCounter::AllocationCounter() noexcept
+    : previous(activeCount)
+{
+    activeCount = &count;
+}
+
+AllocationCounter::~AllocationCounter() noexcept
+{
+    activeCount = previous;
+}
+
+// the hooks themselves: test builds only (see ORADE808_TEST_HOOKS)
+#if ORADE808_TEST_HOOKS
+
+namespace
+{
+    void* allocate(std::size_t size) noexcept
+    {
+        if (activeCount != nullptr)
+            ++*activeCount;
+       #if !ORADE808_LIBC_HOOKS
+        RealtimeChecker::noteAllocation(); // otherwise the malloc hook reports it
+       #endif
+        return std::malloc(size > 0 ? size : 1);
+    }
+
+    void deallocate(void* p) noexcept
+    {
+       #if !ORADE808_LIBC_HOOKS
+        if (p != nullptr)
+            RealtimeChecker::noteFree();
+       #endif
+        std::free(p);
+    }
+}
+
+//==============================================================================
+// replacements for the global allocation functions. The aligned overloads are left to the
+// standard library: they have their own allocate/free pair that never comes through here
+void* operator new(std::size_t size)
+{
+    if (void* p = allocate(size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    if (void* p = allocate(size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept   { return allocate(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+
+void operator delete(void* p) noexcept                                 { deallocate(p); }
+void operator delete[](void* p) noexcept                               { deallocate(p); }
+void operator delete(void* p, std::size_t) noexcept                    { deallocate(p); }
+void operator delete[](void* p, std::size_t) noexcept                  { deallocate(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept          { deallocate(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept        { deallocate(p); }
+
+#endif
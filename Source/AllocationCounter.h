@@ -0,0 +1,42 @@
+#pragma once
+#include <JuceHeader.h>
+
+// Test hooks: the replaced global allocation functions AllocationCounter and RealtimeChecker rely
+// on are compiled in only when ORADE808_TEST_HOOKS is 1, which is the default in debug builds. Add
+// ORADE808_TEST_HOOKS=1 to the Projucer's preprocessor definitions to run --check-allocations and
+// --check-realtime in a release build; with it 0 every allocation goes straight to the library.
+#ifndef ORADE808_TEST_HOOKS
+ #if JUCE_DEBUG
+  #define ORADE808_TEST_HOOKS 1
+ #else
+  #define ORADE808_TEST_HOOKS 0
+ #endif
+#endif
+
+/*
+ AllocationCounter
+ - Counts the calls to the global operator new (std containers, make_shared, new) made on the
+   calling thread while it exists. Counters nest; only the innermost one counts
+ - AllocationCounter.cpp replaces the global operator new / delete to do this (with
+   ORADE808_TEST_HOOKS only; isAvailable() says whether it did). Outside a counter
+   the cost is one thread_local check per allocation. RealtimeChecker builds on the same hooks
+ - juce::HeapBlock, and so juce::AudioBuffer, allocates with malloc and isn't seen here. Callers
+   that care about buffers check that their storage stays put (see --check-allocations)
+*/
+class AllocationCounter
+{
+public:
+    AllocationCounter() noexcept;
+    ~AllocationCounter() noexcept;
+
+    juce::int64 getCount() const noexcept { return count; }
+
+    // false if the hooks are compiled out: getCount() then stays 0 whatever is allocated
+    static constexpr bool isAvailable() noexcept { return ORADE808_TEST_HOOKS != 0; }
+
+private:
+    juce::int64 count = 0;
+    juce::int64* previous = nullptr;
+
+    JUCE_DECLARE_NON_COPYABLE(AllocationCounter)
+};
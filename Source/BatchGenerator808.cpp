@@ -0,0 +1,347 @@
+#include "BatchGenerator808.h"
+#include "CounterRng.h"
+#include "StageTimers.h"
+#include <juce_dsp/juce_dsp.h>
+#include <random>
+
+using namespace juce;
+
+// The per-lane expressions below are copied from Generator808 on purpose, including the
+// float/double mix, so the results round exactly like the scalar render.
+
+template <int Lanes>
+std::vector<AudioBuffer<float>> BatchGenerator808<Lanes>::render(const GeneratorParams* voices, int numVoices)
+{
+    numVoices = jlimit(0, Lanes, numVoices);
+    std::vector<AudioBuffer<float>> result((size_t)numVoices);
+
+    AudioBuffer<float>* results[Lanes];
+    for (int l = 0; l < numVoices; ++l)
+        results[l] = &result[(size_t)l];
+
+    render(voices, numVoices, results);
+    return result;
+}
+
+template <int Lanes>
+void BatchGenerator808<Lanes>::render(const GeneratorParams* voices, int numVoices, AudioBuffer<float>* const* results)
+{
+    numVoices = jlimit(0, Lanes, numVoices);
+    if (numVoices == 0)
+        return;
+
+    // as in Generator808::render: the decaying tails must not fall into denormal arithmetic
+    ScopedNoDenormals noDenormals;
+    STAGE_TIMER(batch);
+
+    // unused lanes repeat voice 0 so they compute something valid that is thrown away
+    GeneratorParams p[Lanes];
+    int length[Lanes];
+    int maxLength = 0;
+    for (int l = 0; l < Lanes; ++l)
+    {
+        p[l] = voices[l < numVoices ? l : 0];
+        length[l] = (int)std::lround(p[l].lengthSeconds * p[l].sampleRate);
+        maxLength = jmax(maxLength, length[l]);
+    }
+
+    const size_t size = (size_t)maxLength * Lanes;
+    mono.assign(size, 0.0f);
+    left.assign(size, 0.0f);
+    right.assign(size, 0.0f);
+
+    renderOscillators(p, maxLength);
+    renderFilters(p, maxLength);
+    renderStereoAndOutput(p, length, maxLength);
+
+    // back to one AudioBuffer per voice, in the scalar render's channel layout (right is a copy of
+    // left without width, so mono voices only keep left)
+    for (int l = 0; l < numVoices; ++l)
+    {
+        auto& buf = *results[l];
+        buf.setSize(Generator808::getNumOutputChannels(p[l]), length[l], false, false, true);
+        float* outL = buf.getWritePointer(0);
+        for (int i = 0; i < length[l]; ++i)
+            outL[i] = left[(size_t)i * Lanes + (size_t)l];
+
+        if (buf.getNumChannels() > 1)
+        {
+            float* outR = buf.getWritePointer(1);
+            for (int i = 0; i < length[l]; ++i)
+                outR[i] = right[(size_t)i * Lanes + (size_t)l];
+        }
+    }
+}
+
+template <int Lanes>
+void BatchGenerator808<Lanes>::renderOscillators(const GeneratorParams* p, int maxLength)
+{
+    constexpr double twoPi = MathConstants<double>::twoPi;
+    constexpr double attack = 0.002;
+
+    // per-voice setup, scalar: same draws as Generator808::startOscillator
+    alignas(64) double sr[Lanes], freq[Lanes], phi2[Lanes], baseDecay[Lanes], glide[Lanes], maxDrop[Lanes];
+    alignas(64) double growl[Lanes], subAmount[Lanes], analog[Lanes];
+    alignas(64) double phase[Lanes], phase2[Lanes];
+    alignas(64) uint64_t noiseKey[Lanes];
+    bool growlOn[Lanes], subOn[Lanes], analogOn[Lanes];
+
+    for (int l = 0; l < Lanes; ++l)
+    {
+        const auto& v = p[l];
+        std::mt19937_64 rng(Generator808::rngSeedFor(v.seed));
+        std::uniform_real_distribution<double> uni{ 0.0, 1.0 };
+
+        double baseMidi = 32.0 + (uni(rng) * 10.0);
+        baseMidi += v.tuneSemitones;
+        double f = 440.0 * std::pow(2.0, (baseMidi - 69.0) / 12.0);
+        double subBias = (double)v.subAmount * -2.0;
+        f *= std::pow(2.0, subBias / 12.0);
+
+        sr[l] = v.sampleRate;
+        freq[l] = f;
+        phi2[l] = twoPi * f * 2.0 / v.sampleRate;
+
+        double decay = 0.8;
+        decay *= (1.0 + 0.8 * (double)v.boomAmount);
+        decay *= (0.4 + 0.6 * (1.0 - (double)v.shortness));
+        baseDecay[l] = decay;
+
+        glide[l] = 0.015 + 0.010 * uni(rng);
+        maxDrop[l] = 0.24 + 1.0 * v.punch;
+
+        growl[l] = v.growl;
+        subAmount[l] = v.subAmount;
+        analog[l] = v.analog;
+        growlOn[l] = v.growl > 0.001f;
+        subOn[l] = v.subAmount > 0.001f;
+        analogOn[l] = v.analog > 0.001f;
+
+        phase[l] = 0.0;
+        phase2[l] = 0.0;
+        noiseKey[l] = CounterRng::keyFor((uint64_t)v.seed, Generator808::analogNoiseStream);
+    }
+
+    for (int i = 0; i < maxLength; ++i)
+    {
+        float* out = mono.data() + (size_t)i * Lanes;
+
+        for (int l = 0; l < Lanes; ++l)
+        {
+            double t = (double)i / sr[l];
+
+            double env = t < attack ? t / attack : std::exp(-(t - attack) / baseDecay[l]);
+
+            double pitchMult = 1.0;
+            if (t < glide[l])
+            {
+                double frac = t / glide[l];
+                double drop = maxDrop[l] * (1.0 - frac);
+                pitchMult = std::pow(2.0, -drop / 12.0);
+            }
+
+            double curPhi = twoPi * freq[l] * pitchMult / sr[l];
+            double s1 = std::sin(phase[l]);
+            phase[l] += curPhi;
+            if (phase[l] > twoPi) phase[l] -= twoPi;
+
+            double s2 = std::sin(phase2[l]);
+            phase2[l] += phi2[l];
+            if (phase2[l] > twoPi) phase2[l] -= twoPi;
+
+            double fm = growlOn[l] ? growl[l] * 0.25 * std::sin(phase2[l] * 0.5 + 0.3) : 0.0;
+            double body = (1.0 - (0.25 * growl[l])) * s1 + 0.25 * s2 + fm;
+
+            double sub = subOn[l] ? subAmount[l] * 0.8 * std::sin(twoPi * (freq[l] * 0.5) * ((double)i / sr[l])) : 0.0;
+
+            double sample = (body * (1.0 - subAmount[l] * 0.5)) + sub;
+            // counter-based noise is a pure function of (voice, sample), so it's drawn in the lane loop
+            if (analogOn[l])
+                sample += ((CounterRng::uniform01(noiseKey[l], (uint64_t)i) - 0.5) * 0.002 * analog[l]);
+
+            out[l] = (float)(sample * env);
+        }
+    }
+}
+
+template <int Lanes>
+void BatchGenerator808<Lanes>::renderFilters(const GeneratorParams* p, int maxLength)
+{
+    // biquad lowpass, transposed direct form II like juce::dsp::IIR::Filter
+    alignas(64) float b0[Lanes], b1[Lanes], b2[Lanes], a1[Lanes], a2[Lanes], lv1[Lanes], lv2[Lanes];
+    alignas(64) double alpha[Lanes], drive[Lanes];
+    alignas(64) float shelfGain[Lanes], prevLow[Lanes];
+
+    for (int l = 0; l < Lanes; ++l)
+    {
+        // same coefficients as Generator808::startFilter
+        const auto c = dsp::IIR::ArrayCoefficients<float>::makeLowPass((float)p[l].sampleRate, 1400.0f, 0.7f);
+        b0[l] = c[0]; b1[l] = c[1]; b2[l] = c[2]; a1[l] = c[4]; a2[l] = c[5];
+        lv1[l] = lv2[l] = 0.0f;
+
+        double rc = 1.0 / (2.0 * MathConstants<double>::pi * 60.0f);
+        double dt = 1.0 / p[l].sampleRate;
+        alpha[l] = dt / (rc + dt);
+        shelfGain[l] = 1.0f + p[l].boomAmount * 0.5f;
+        prevLow[l] = 0.0f;
+        drive[l] = 1.0 + p[l].analog * 0.5f;
+    }
+
+    for (int i = 0; i < maxLength; ++i)
+    {
+        float* data = mono.data() + (size_t)i * Lanes;
+
+        for (int l = 0; l < Lanes; ++l)
+        {
+            float input = data[l];
+            float output = (input * b0[l]) + lv1[l];
+            lv1[l] = (input * b1[l]) - (output * a1[l]) + lv2[l];
+            lv2[l] = (input * b2[l]) - (output * a2[l]);
+
+            // crude low shelf
+            prevLow[l] = (float)(prevLow[l] + alpha[l] * (output - prevLow[l]));
+            float s = output + (prevLow[l] * (shelfGain[l] - 1.0f));
+
+            // soft saturation
+            data[l] = (float)((s < -1.0f) ? -1.0f : (s > 1.0f ? 1.0f : std::tanh(s * drive[l])));
+        }
+    }
+}
+
+template <int Lanes>
+void BatchGenerator808<Lanes>::renderStereoAndOutput(const GeneratorParams* p, const int* length, int maxLength)
+{
+    alignas(64) float gain[Lanes];
+    alignas(64) double sr[Lanes], detune[Lanes], lfoRate[Lanes];
+    bool widthOn[Lanes], applyGain[Lanes], clearOut[Lanes];
+
+    for (int l = 0; l < Lanes; ++l)
+    {
+        widthOn[l] = p[l].detune >= 0.001f;
+        sr[l] = p[l].sampleRate;
+        detune[l] = p[l].detune;
+        lfoRate[l] = 2.0 * MathConstants<double>::pi * 0.8;
+
+        // AudioBuffer::applyGain skips unity gain and clears on zero gain
+        gain[l] = GeneratorVoiceUtils::dBToGain(p[l].masterGainDb);
+        clearOut[l] = approximatelyEqual(gain[l], 0.0f);
+        applyGain[l] = !clearOut[l] && !approximatelyEqual(gain[l], 1.0f);
+    }
+
+    // stereo copy (AudioBuffer::addFrom into a cleared buffer is a plain copy)
+    for (size_t i = 0; i < (size_t)maxLength * Lanes; ++i)
+        left[i] = right[i] = mono[i];
+
+    // width: right mixes in a slightly modulated delay of left (which may look ahead)
+    for (int i = 0; i < maxLength; ++i)
+    {
+        for (int l = 0; l < Lanes; ++l)
+        {
+            if (!widthOn[l] || i >= length[l])
+                continue;
+
+            const int ns = length[l];
+            double mod = 0.0005 * std::sin(lfoRate[l] * i / (double)ns);
+            int delaySamples = (int)std::round(mod * sr[l] * detune[l] * 20.0);
+            int idx = jlimit(0, ns - 1, i - delaySamples);
+
+            float& r = right[(size_t)i * Lanes + (size_t)l];
+            r = 0.6f * r + 0.4f * left[(size_t)idx * Lanes + (size_t)l];
+        }
+    }
+
+    // master gain + soft clip
+    for (int i = 0; i < maxLength; ++i)
+    {
+        float* outL = left.data() + (size_t)i * Lanes;
+        float* outR = right.data() + (size_t)i * Lanes;
+
+        for (int l = 0; l < Lanes; ++l)
+        {
+            float xl = clearOut[l] ? 0.0f : (applyGain[l] ? outL[l] * gain[l] : outL[l]);
+            float xr = clearOut[l] ? 0.0f : (applyGain[l] ? outR[l] * gain[l] : outR[l]);
+            outL[l] = std::tanh(xl * 1.2f);
+            outR[l] = std::tanh(xr * 1.2f);
+        }
+    }
+}
+
+template class BatchGenerator808<4>;
+template class BatchGenerator808<8>;
+template class BatchGenerator808<16>;
+
+//==============================================================================
+int BatchRender808::getNativeLanes()
+{
+   #if defined (__AVX512F__)
+    return 16;
+   #elif defined (__AVX2__) || defined (__AVX__)
+    return 8;
+   #else
+    return 4;
+   #endif
+}
+
+namespace
+{
+    template <int Lanes>
+    void renderAllWith(const GeneratorParams* voices, int numVoices, AudioBuffer<float>* const* results,
+                       BatchGenerator808<Lanes>& batch, BatchRender808::Workspace& workspace)
+    {
+        // the lanes don't oversample or stop early and only run the latest engine version, so voices
+        // that ask for anything else go through Generator808
+        auto& batched = workspace.batched;
+        batched.clear();
+        for (int v = 0; v < numVoices; ++v)
+        {
+            if (voices[v].oversampling > 1 || voices[v].autoLength
+                || Generator808::resolveEngineVersion(voices[v].engineVersion) != GeneratorParams::latestEngineVersion)
+            {
+                const int numSamples = (int)std::lround(voices[v].lengthSeconds * voices[v].sampleRate);
+                results[v]->setSize(Generator808::getNumOutputChannels(voices[v]), numSamples, false, false, true);
+                workspace.scalar.render(voices[v], *results[v]);
+            }
+            else
+            {
+                batched.push_back(v);
+            }
+        }
+
+        GeneratorParams group[Lanes];
+        AudioBuffer<float>* groupResults[Lanes];
+        for (size_t first = 0; first < batched.size(); first += Lanes)
+        {
+            const int n = (int)jmin<size_t>(Lanes, batched.size() - first);
+            for (int l = 0; l < n; ++l)
+            {
+                group[l] = voices[batched[first + (size_t)l]];
+                groupResults[l] = results[batched[first + (size_t)l]];
+            }
+
+            batch.render(group, n, groupResults);
+        }
+    }
+}
+
+std::vector<AudioBuffer<float>> BatchRender808::renderAll(const std::vector<GeneratorParams>& voices, int lanes)
+{
+    std::vector<AudioBuffer<float>> result(voices.size());
+    std::vector<AudioBuffer<float>*> results;
+    for (auto& buffer : result)
+        results.push_back(&buffer);
+
+    Workspace workspace;
+    renderAll(voices.data(), (int)voices.size(), results.data(), workspace, lanes);
+    return result;
+}
+
+void BatchRender808::renderAll(const GeneratorParams* voices, int numVoices, AudioBuffer<float>* const* results,
+                               Workspace& workspace, int lanes)
+{
+    switch (lanes > 0 ? lanes : getNativeLanes())
+    {
+        case 16: renderAllWith(voices, numVoices, results, workspace.batch16, workspace); break;
+        case 8:  renderAllWith(voices, numVoices, results, workspace.batch8, workspace); break;
+        default: renderAllWith(voices, numVoices, results, workspace.batch4, workspace); break;
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <JuceHeader.h>
+#include "808Generator.h"
+#include <vector>
+
+/*
+ BatchGenerator808
+ - Renders up to Lanes independent 808 voices in lockstep, one voice per vector lane
+ - Buffers are structure-of-arrays (sample-major, lane-minor), so each stage's per-sample
+   lane loop reads and writes contiguous memory and auto-vectorizes (4 lanes: SSE/NEON,
+   8: AVX2, 16: AVX-512 when the build targets them)
+ - Voices may differ in every param, including length and sample rate: lanes past their own
+   length keep running but their samples are discarded (per-lane mask)
+ - Mirrors Generator808::render stage for stage, so every voice matches the scalar render.
+   Bit-exact unless the compiler swaps libm sin/exp/tanh for vector versions that differ
+   in the last ulp; --bench-batch reports the worst difference
+ - No oversampling: voices are rendered as if params.oversampling were 1, and autoLength is
+   ignored, and every voice renders with the latest engine version (renderAll hands oversampled,
+   autoLength and older-engine voices to Generator808 instead)
+ - Instantiated for 4, 8 and 16 lanes; not thread-safe (scratch buffers are reused)
+*/
+template <int Lanes>
+class BatchGenerator808
+{
+public:
+    static constexpr int numLanes = Lanes;
+
+    // numVoices <= Lanes; result[i] is voice i as a buffer of its own length and channel layout
+    // (Generator808::getNumOutputChannels)
+    std::vector<juce::AudioBuffer<float>> render(const GeneratorParams* voices, int numVoices);
+
+    // the same into *results[i], which keep their allocations when they're big enough. Once the
+    // scratch buffers have grown to the longest voice, this doesn't allocate
+    void render(const GeneratorParams* voices, int numVoices, juce::AudioBuffer<float>* const* results);
+
+private:
+    void renderOscillators(const GeneratorParams* p, int maxLength);
+    void renderFilters(const GeneratorParams* p, int maxLength);
+    void renderStereoAndOutput(const GeneratorParams* p, const int* length, int maxLength);
+
+    std::vector<float> mono;         // [sample * Lanes + lane]
+    std::vector<float> left, right;  // [sample * Lanes + lane]
+};
+
+struct BatchRender808
+{
+    // widest lane count the build's instruction set makes worthwhile (16 / 8 / 4)
+    static int getNativeLanes();
+
+    // renders every voice, Lanes at a time (0 = native); same as Generator808::renderToBuffer per voice
+    static std::vector<juce::AudioBuffer<float>> renderAll(const std::vector<GeneratorParams>& voices, int lanes = 0);
+
+    // generators and scratch kept between renderAll calls (see RenderContext)
+    struct Workspace
+    {
+        Generator808 scalar;
+        BatchGenerator808<4> batch4;
+        BatchGenerator808<8> batch8;
+        BatchGenerator808<16> batch16;
+        std::vector<int> batched;
+    };
+
+    // the same into *results[i] (see BatchGenerator808::render); with a warmed-up workspace and
+    // buffers this doesn't allocate
+    static void renderAll(const GeneratorParams* voices, int numVoices, juce::AudioBuffer<float>* const* results,
+                          Workspace& workspace, int lanes = 0);
+};
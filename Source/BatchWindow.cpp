@@ -1,6 +1,7 @@
 #include "BatchWindow.h"
 #include "WavExporter.h"
 #include "808Generator.h"
+#include "BatchGenerator808.h"
 #include <chrono>
 
 // constructor signature must match BatchWindow.h (PluginProcessor&)
@@ -16,6 +17,7 @@ BatchWindow::BatchWindow(PluginProcessor& ownerProcessor)
 
     // pass pointers to addAndMakeVisible to avoid overload/template lookup problems
     addAndMakeVisible(&useDescriptorToggle);
+    addAndMakeVisible(&monoFilesToggle);
     addAndMakeVisible(&countCombo);
     addAndMakeVisible(&chooseFolderBtn);
     addAndMakeVisible(&folderLabel);
@@ -94,10 +96,10 @@ void BatchWindow::buttonClicked(juce::Button* b)
         // Confirm action
         juce::AlertWindow::showMessageBoxAsync(juce::AlertWindow::InfoIcon, "Batch", "Starting batch generation (" + juce::String(count) + " files). This may take some time.");
 
-        // Use a fresh Generator808 instance so we don't rely on processor internals in case owner is hosted
-        Generator808 gen;
+        // build every voice's params first, then render them together across SIMD lanes
+        std::vector<GeneratorParams> voices;
+        voices.reserve((size_t)count);
 
-        int savedCount = 0;
         for (int i = 0; i < count; ++i)
         {
             // Build params baseline from owner's last params if available; otherwise fallback defaults
@@ -128,20 +130,35 @@ void BatchWindow::buttonClicked(juce::Button* b)
 
             // generate a seed (time-based + index)
             gp.seed = (int64_t)(std::chrono::high_resolution_clock::now().time_since_epoch().count() + i * 7919);
+            gp.engineVersion = GeneratorParams::latestEngineVersion;
             if (gp.sampleRate <= 0.0) gp.sampleRate = 44100.0;
 
-            // Render
-            auto buf = gen.renderToBuffer(gp);
+            voices.push_back(gp);
+        }
 
-            // filename zero-padded
-            juce::String filename = prefix + juce::String::formatted("%03d.wav", i + 1);
-            juce::File out = destFolder.getChildFile(filename);
-            bool ok = false;
-            if (buf.getNumSamples() > 0)
-                ok = WavExporter::saveBufferToWav(buf, gp.sampleRate, out, 24);
+        int savedCount = 0;
+        std::vector<GeneratorParams> chunk;
+        for (int first = 0; first < count; first += renderChunk)
+        {
+            // same output as Generator808::renderToBuffer per voice
+            chunk.assign(voices.begin() + first, voices.begin() + juce::jmin(count, first + renderChunk));
+            renderContext.renderAll(chunk, chunkBuffers);
 
-            if (ok) ++savedCount;
-            else juce::Logger::writeToLog("Batch: failed to save " + out.getFullPathName());
+            for (int i = first; i < first + (int)chunk.size(); ++i)
+            {
+                const auto& gp = voices[(size_t)i];
+                const auto& buf = *chunkBuffers[(size_t)(i - first)];
+
+                // filename zero-padded
+                juce::String filename = prefix + juce::String::formatted("%03d.wav", i + 1);
+                juce::File out = destFolder.getChildFile(filename);
+                bool ok = false;
+                if (buf.getNumSamples() > 0)
+                    ok = WavExporter::saveBufferToWav(buf, gp.sampleRate, out, 24, -1, monoFilesToggle.getToggleState());
+
+                if (ok) ++savedCount;
+                else juce::Logger::writeToLog("Batch: failed to save " + out.getFullPathName());
+            }
         }
 
         juce::AlertWindow::showMessageBoxAsync(juce::AlertWindow::InfoIcon, "Batch Done", "Finished generating batch. Saved " + juce::String(savedCount) + " / " + juce::String(count) + " files.");
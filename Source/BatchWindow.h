@@ -1,11 +1,13 @@
 #pragma once
 #include <JuceHeader.h>
 #include "PluginProcessor.h" // need concrete type
+#include "RenderContext.h"
 
 /*
  BatchWindow
  - UI for batch generation + export
- - Options: count (25,50,100), use descriptors (ask DescriptorWindow for selections), naming scheme, destination folder
+ - Options: count (25,50,100), use descriptors (ask DescriptorWindow for selections), naming scheme, destination folder,
+   mono WAVs for voices without stereo width
  - Public API: open(), closeWindow()
 */
 
@@ -37,6 +39,7 @@ private:
 
     // UI
     juce::ToggleButton useDescriptorToggle{ "Use Descriptors" };
+    juce::ToggleButton monoFilesToggle{ "Mono WAVs" };
     juce::ComboBox countCombo; // 25/50/100
     juce::TextButton chooseFolderBtn{ "Choose Folder" };
     juce::Label folderLabel;
@@ -47,6 +50,12 @@ private:
     // last chosen folder
     juce::File destFolder;
 
+    // batches are rendered and written renderChunk voices at a time through one context, so after
+    // the first chunk the buffers are reused instead of holding (and allocating) the whole batch
+    static constexpr int renderChunk = 16;
+    RenderContext renderContext;
+    std::vector<RenderContext::BufferPtr> chunkBuffers;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BatchWindow)
 };
 
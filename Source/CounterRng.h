@@ -0,0 +1,40 @@
+#pragma once
+#include <JuceHeader.h>
+#include <cstdint>
+
+/*
+ CounterRng
+ - Counter-based random numbers (Widynski's "Squares" generator): number n of a stream is a pure
+   function of (key, n), so there is no state to carry and no order the numbers have to be drawn in
+ - Keyed by seed and sample index, a render gets the same noise whatever block size, thread or SIMD
+   lane width it runs with, and any block of numbers can be generated on its own
+ - Four 64-bit multiplies per number and no branches or tables, so loops over it auto-vectorize
+ - keyFor mixes a seed and a stream id into a key (splitmix64, odd, as Squares expects), so
+   different uses of one seed get unrelated streams
+*/
+struct CounterRng
+{
+    static inline uint64_t keyFor(uint64_t seed, uint64_t stream) noexcept
+    {
+        uint64_t z = seed + (stream + 1) * 0x9E3779B97F4A7C15ULL;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return (z ^ (z >> 31)) | 1;
+    }
+
+    // 32 random bits: number `counter` of the stream `key` selects
+    static inline uint32_t bits(uint64_t key, uint64_t counter) noexcept
+    {
+        uint64_t x = counter * key, y = x, z = y + key;
+        x = x * x + y; x = (x >> 32) | (x << 32);
+        x = x * x + z; x = (x >> 32) | (x << 32);
+        x = x * x + y; x = (x >> 32) | (x << 32);
+        return (uint32_t)((x * x + z) >> 32);
+    }
+
+    // uniform in [0, 1)
+    static inline double uniform01(uint64_t key, uint64_t counter) noexcept
+    {
+        return (double)bits(key, counter) * (1.0 / 4294967296.0);
+    }
+};
@@ -1,4 +1,5 @@
 #include "DescriptorWindow.h"
+#include <random>
 
 using namespace juce;
 
@@ -0,0 +1,158 @@
+#include "EngineGolden.h"
+#include "808Generator.h"
+#include "CounterRng.h"
+#include <cstring>
+#include <random>
+
+using namespace juce;
+
+namespace
+{
+    struct Fnv1a
+    {
+        uint64_t value = 0xcbf29ce484222325ULL;
+
+        void addBytes(const void* data, size_t numBytes)
+        {
+            for (size_t i = 0; i < numBytes; ++i)
+                value = (value ^ static_cast<const uint8_t*>(data)[i]) * 0x100000001b3ULL;
+        }
+
+        template <typename T>
+        void add(T x)
+        {
+            addBytes(&x, sizeof(T));
+        }
+    };
+
+    String toHex(uint64_t value)
+    {
+        return String::toHexString((int64)value).paddedLeft('0', 16);
+    }
+
+    struct GoldenCase
+    {
+        const char* name;
+        GeneratorParams params;
+        bool draft;
+    };
+
+    GoldenCase makeCase(const char* name, float detune, float growl, float analog, int oversampling, bool autoLength, bool draft)
+    {
+        GoldenCase c { name, {}, draft };
+        c.params.seed = 80808;
+        c.params.lengthSeconds = autoLength ? 4.0 : 0.75;
+        c.params.subAmount = 0.5f;
+        c.params.punch = 0.6f;
+        // auto length: short enough to go below the floor well inside lengthSeconds (~2.8 s of 4),
+        // so the tail detection and the fade are part of the hash
+        c.params.boomAmount = autoLength ? 0.0f : 0.4f;
+        c.params.shortness = autoLength ? 1.0f : 0.2f;
+        c.params.silenceFloorDb = autoLength ? -72.0f : -90.0f;
+        c.params.detune = detune;
+        c.params.growl = growl;
+        c.params.analog = analog;
+        c.params.oversampling = oversampling;
+        c.params.autoLength = autoLength;
+        return c;
+    }
+
+    // the draws engine `version` makes for seed: the note and the glide from the seed's
+    // mt19937_64, then one per sample of analog noise, which v1 takes from the same stream and
+    // later versions from CounterRng. Raw integers: no libm, and no uniform_real_distribution
+    // (whose conversion to double the standard libraries don't agree on)
+    uint64_t hashRandomDraws(int version, int64_t seed)
+    {
+        constexpr uint64_t numNoiseDraws = 4096;
+
+        Fnv1a hash;
+        std::mt19937_64 rng(Generator808::rngSeedFor(seed));
+        hash.add((uint64_t)rng());
+        hash.add((uint64_t)rng());
+
+        const auto key = CounterRng::keyFor((uint64_t)seed, Generator808::analogNoiseStream);
+        for (uint64_t i = 0; i < numNoiseDraws; ++i)
+            hash.add(version == 1 ? (uint64_t)rng() : (uint64_t)CounterRng::bits(key, i));
+        return hash.value;
+    }
+}
+
+std::vector<EngineGolden::Entry> EngineGolden::computeEntries()
+{
+    const std::vector<GoldenCase> cases {
+        makeCase("mono",   0.0f, 0.0f, 0.0f, 1, false, false),
+        makeCase("stereo", 0.5f, 0.0f, 0.0f, 1, false, false),
+        makeCase("noise",  0.5f, 0.6f, 0.8f, 1, false, false),
+        makeCase("os2",    0.3f, 0.6f, 0.8f, 2, false, false),
+        makeCase("os4",    0.0f, 0.6f, 0.8f, 4, false, false),
+        makeCase("auto",   0.5f, 0.3f, 0.8f, 1, true,  false),
+        makeCase("draft",  0.5f, 0.6f, 0.8f, 1, false, true),
+    };
+
+    std::vector<Entry> entries;
+    Generator808::State state;
+    AudioBuffer<float> buffer;
+
+    for (const auto& engine : Generator808::getEngineVersions())
+    {
+        const String prefix = "v" + String(engine.number) + "-";
+
+        Fnv1a draws;
+        for (int64_t seed : { (int64_t)80808, (int64_t)-808, (int64_t)0x7FFFFFFFFFFFFFFFLL })
+            draws.add(hashRandomDraws(engine.number, seed));
+        entries.push_back({ prefix + "random", toHex(draws.value), true });
+
+        for (const auto& c : cases)
+        {
+            auto p = c.params;
+            p.engineVersion = engine.number;
+
+            if (c.draft)
+            {
+                Generator808::renderDraft(p, state, buffer);
+            }
+            else
+            {
+                buffer.setSize(Generator808::getNumOutputChannels(p), (int)std::lround(p.lengthSeconds * p.sampleRate), false, false, true);
+                Generator808::render(p, state, buffer);
+            }
+
+            Fnv1a hash;
+            for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+                hash.addBytes(buffer.getReadPointer(ch), sizeof(float) * (size_t)buffer.getNumSamples());
+
+            Entry entry { prefix + c.name,
+                          String(buffer.getNumChannels()) + " " + String(buffer.getNumSamples()) + " " + toHex(hash.value),
+                          false, {} };
+
+            const int fullLength = (int)std::lround(p.lengthSeconds * p.sampleRate);
+            if (p.autoLength && buffer.getNumSamples() >= fullLength)
+                entry.error = "wasn't trimmed (" + String(buffer.getNumSamples()) + " samples), so it doesn't test auto length";
+
+            entries.push_back(entry);
+        }
+    }
+
+    return entries;
+}
+
+String EngineGolden::getLibmFingerprint()
+{
+    Fnv1a hash;
+    for (int i = 0; i < 512; ++i)
+    {
+        // through a volatile, so the compiler can't work the results out at build time
+        volatile double input = -12.0 + 0.0473 * i;
+        const double x = input;
+        const float xf = (float)x;
+
+        hash.add(std::sin(x));
+        hash.add(std::exp(x));
+        hash.add(std::pow(2.0, x));
+        hash.add(std::tanh(x));
+        hash.add(std::tanh(xf));
+        hash.add(std::pow(10.0f, xf * 0.25f));
+        hash.add(std::tan(xf * 0.125f));
+    }
+    return toHex(hash.value);
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <JuceHeader.h>
+#include <vector>
+
+/*
+ EngineGolden
+ - What --check-engines compares with the golden file (Golden/engines.txt in the repo): for every
+   engine version a fixed set of renders (mono, stereo, growl + analog noise, 2x and 4x
+   oversampling, auto length, a draft), each reduced to its channel count, length and a 64-bit
+   FNV-1a hash of the float bits
+ - Renders call sin / exp / pow / tanh / tan from the C library, whose last bits differ between
+   platforms, so a render hash only holds on a platform whose libm gives the same results as the
+   one it was made on. getLibmFingerprint hashes those functions on fixed inputs; the golden file
+   records the fingerprint of its reference platform, and render entries are only checked where
+   it matches
+ - The auto length case has to end before lengthSeconds, or it wouldn't cover the tail
+   detection; an entry whose render doesn't do what its case is for carries an error
+ - The portable entries don't touch libm: per version, the random draws its character comes
+   from (the seed's mt19937_64 stream, CounterRng's analog noise stream). They are checked on
+   every platform
+*/
+struct EngineGolden
+{
+    struct Entry
+    {
+        juce::String name;      // "v<N>-<case>"
+        juce::String value;     // renders: "<channels> <samples> <hash>"; portable: "<hash>"
+        bool portable = false;
+        juce::String error;     // set when the render doesn't do what its case is there for
+    };
+
+    // every entry for every version in Generator808::getEngineVersions
+    static std::vector<Entry> computeEntries();
+
+    // hash of the C library's results for the functions the generator calls
+    static juce::String getLibmFingerprint();
+};
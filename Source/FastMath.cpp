@@ -0,0 +1,19 @@
+#include "FastMath.h"
+
+// The tier is picked once per block so the inner loops are branch-free and vectorize.
+#define FASTMATH_BLOCK_FUNCTION(name) \
+    void FastMath::name(const float* src, float* dest, int num, Accuracy accuracy) noexcept \
+    { \
+        if (accuracy == draftAccuracy) \
+            for (int i = 0; i < num; ++i) dest[i] = name<draftAccuracy>(src[i]); \
+        else \
+            for (int i = 0; i < num; ++i) dest[i] = name<finalAccuracy>(src[i]); \
+    }
+
+FASTMATH_BLOCK_FUNCTION(sin)
+FASTMATH_BLOCK_FUNCTION(exp)
+FASTMATH_BLOCK_FUNCTION(exp2)
+FASTMATH_BLOCK_FUNCTION(tanh)
+FASTMATH_BLOCK_FUNCTION(log2)
+
+#undef FASTMATH_BLOCK_FUNCTION
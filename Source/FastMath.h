@@ -0,0 +1,132 @@
+#pragma once
+#include <JuceHeader.h>
+#include <cstring>
+
+/*
+ FastMath
+ - Polynomial sin / exp / exp2 / tanh / log2 for float DSP code, shared by the generator and analysis
+ - Two accuracy tiers (worst case against double-precision libm, checked by --bench-math):
+     draftAccuracy   ~1e-4   interactive previews and anything that is only drawn
+                             sin abs 2e-4, exp2/exp rel 1.5e-4, tanh abs 1e-4, log2 abs 1.5e-4
+     finalAccuracy   ~1e-7   near float precision, for audio that gets exported
+                             sin abs 5e-7, exp2 rel 3e-7, exp rel 2e-6, tanh abs 3e-7, log2 abs 3e-7
+ - Bounds hold for finite inputs with sin |x| <= 1e4, exp2 |x| <= 126, exp |x| <= 20 (the error of exp
+   grows with |x| because of the x * log2(e) rounding), any tanh, log2 of normal positive floats
+ - No branches or table lookups in the scalar functions, so loops over them auto-vectorize. Selects
+   are done with bit masks: a plain ?: on floats isn't if-converted under the default -ftrapping-math.
+   The block versions take the tier at runtime and are the ones to call from per-sample loops
+*/
+struct FastMath
+{
+    enum Accuracy { draftAccuracy, finalAccuracy };
+
+    //==============================================================================
+    template <Accuracy accuracy>
+    static inline float exp2(float x) noexcept
+    {
+        x = select(x < -126.0f, -126.0f, x);
+        x = select(x > 126.0f, 126.0f, x);
+
+        // x = i + f with f in [-0.5, 0.5)
+        const float k = x + 0.5f;
+        int i = (int)k;
+        i -= (int)(k < (float)i);
+        const float f = x - (float)i;
+
+        float p;
+        if (accuracy == draftAccuracy)
+            p = 1.0f + f * (6.932829327e-1f + f * (2.422109679e-1f + f * 5.500890305e-2f));
+        else
+            p = 1.0f + f * (6.931472029e-1f + f * (2.402264791e-1f + f * (5.550332470e-2f
+                    + f * (9.618437366e-3f + f * (1.339887487e-3f + f * 1.535336063e-4f)))));
+
+        return p * fromBits((i + 127) << 23);
+    }
+
+    template <Accuracy accuracy>
+    static inline float exp(float x) noexcept
+    {
+        return exp2<accuracy>(x * 1.442695041f);
+    }
+
+    template <Accuracy accuracy>
+    static inline float log2(float x) noexcept
+    {
+        x = select(x < 1.175494351e-38f, 1.175494351e-38f, x);
+
+        // x = m * 2^e with m in [sqrt(0.5), sqrt(2)), split on the mantissa bits of sqrt(2)
+        const int bits = toBits(x);
+        const int mantissa = bits & 0x7fffff;
+        const int high = (int)(mantissa > 0x3504f3);
+        const int e = ((bits >> 23) & 0xff) - 127 + high;
+        const float u = fromBits(mantissa | (0x3f800000 - (high << 23))) - 1.0f;
+
+        float p;
+        if (accuracy == draftAccuracy)
+            p = 1.441760649f + u * (-7.249043876e-1f + u * (5.175091494e-1f + u * -3.296275143e-1f));
+        else
+            p = 1.442694772f + u * (-7.213571493e-1f + u * (4.809394412e-1f + u * (-3.600872001e-1f
+                    + u * (2.867075459e-1f + u * (-2.500693045e-1f + u * (2.368897859e-1f + u * -1.457429602e-1f))))));
+
+        return (float)e + u * p;
+    }
+
+    template <Accuracy accuracy>
+    static inline float sin(float x) noexcept
+    {
+        // x = k * pi + r with r in [-pi/2, pi/2]; pi split in two so k * piHigh is exact (Cody-Waite)
+        const float q = x * 0.3183098862f;
+        const int k = (int)(q + select(q < 0.0f, -0.5f, 0.5f));
+        const float r = (x - (float)k * 3.140625f) - (float)k * 9.676535897e-4f;
+
+        const float s = r * r;
+        float p;
+        if (accuracy == draftAccuracy)
+            p = r + r * s * (-1.661291913e-1f + s * 7.656545072e-3f);
+        else
+            p = r + r * s * (-1.666666663e-1f + s * (8.333331109e-3f + s * (-1.984086821e-4f
+                    + s * (2.752538456e-6f + s * -2.388891138e-8f))));
+
+        // odd k flips the sign
+        return fromBits(toBits(p) ^ ((k & 1) << 31));
+    }
+
+    template <Accuracy accuracy>
+    static inline float tanh(float x) noexcept
+    {
+        // tanh |x| = 1 - 2 / (e^2|x| + 1), which is exactly 1 in float past |x| = 9
+        const int sign = toBits(x) & (int)0x80000000;
+        float ax = fromBits(toBits(x) & 0x7fffffff);
+        ax = select(ax > 9.0f, 9.0f, ax);
+        float t = 1.0f - 2.0f / (exp2<accuracy>(ax * 2.885390082f) + 1.0f);
+
+        if (accuracy == finalAccuracy)
+        {
+            // that formula cancels near zero, where an odd polynomial does better
+            const float s = ax * ax;
+            const float p = ax + ax * s * (-3.333328194e-1f + s * (1.333144221e-1f + s * (-5.373971626e-2f
+                                + s * (2.063909061e-2f + s * -5.704990368e-3f))));
+            t = select(ax < 0.625f, p, t);
+        }
+
+        return fromBits(toBits(t) | sign);
+    }
+
+    //==============================================================================
+    // dest[i] = f(src[i]); src and dest may be the same array
+    static void sin(const float* src, float* dest, int num, Accuracy accuracy) noexcept;
+    static void exp(const float* src, float* dest, int num, Accuracy accuracy) noexcept;
+    static void exp2(const float* src, float* dest, int num, Accuracy accuracy) noexcept;
+    static void tanh(const float* src, float* dest, int num, Accuracy accuracy) noexcept;
+    static void log2(const float* src, float* dest, int num, Accuracy accuracy) noexcept;
+
+private:
+    static inline float select(bool condition, float a, float b) noexcept
+    {
+        const int mask = -(int)condition;
+        return fromBits((toBits(a) & mask) | (toBits(b) & ~mask));
+    }
+
+    static inline float fromBits(int bits) noexcept { float f; std::memcpy(&f, &bits, sizeof(f)); return f; }
+    static inline int toBits(float f) noexcept { int bits; std::memcpy(&bits, &f, sizeof(bits)); return bits; }
+};
@@ -0,0 +1,426 @@
+#include "FeatureIndex.h"
+#include "FolderResynthesizer.h"
+#include "ParallelJobs.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <set>
+
+using namespace juce;
+
+namespace
+{
+    struct IndexHeader
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t numRecords;
+        uint32_t recordSize;
+    };
+
+    static_assert(sizeof(IndexHeader) == 16, "IndexHeader is part of the file format");
+
+    const char indexMagic[4] = { '8', '0', '8', 'F' };
+
+    // murmur3 finalizer
+    uint64_t mix64(uint64_t k)
+    {
+        k ^= k >> 33;
+        k *= 0xff51afd7ed558ccdULL;
+        k ^= k >> 33;
+        k *= 0xc4ceb9fe1a85ec53ULL;
+        k ^= k >> 33;
+        return k;
+    }
+
+    // word-at-a-time 64-bit content hash; not cryptographic, just a good cache key
+    uint64_t hashBytes(const void* data, size_t size)
+    {
+        auto* p = static_cast<const uint8_t*>(data);
+        uint64_t h = 0x9E3779B97F4A7C15ULL ^ (uint64_t)size;
+
+        size_t i = 0;
+        for (; i + 8 <= size; i += 8)
+        {
+            uint64_t w;
+            std::memcpy(&w, p + i, 8);
+            h ^= mix64(w);
+            h = ((h << 27) | (h >> 37)) * 0x87C37B91114253D5ULL + 0x52DCE729ULL;
+        }
+
+        uint64_t tail = 0;
+        if (i < size)
+            std::memcpy(&tail, p + i, size - i);
+        h ^= mix64(tail ^ 0xA0761D6478BD642FULL);
+
+        return mix64(h);
+    }
+}
+
+FeatureIndex::FeatureIndex(const File& file)
+    : indexFile(file),
+      pathTableFile(file.withFileExtension("paths"))
+{
+    ScopedLock sl(lock);
+    openMapping();
+    loadPathTable();
+}
+
+FeatureIndex::~FeatureIndex() = default;
+
+File FeatureIndex::getDefaultIndexFile()
+{
+    return File::getSpecialLocation(File::userApplicationDataDirectory)
+        .getChildFile("808orade")
+        .getChildFile("features.idx");
+}
+
+void FeatureIndex::openMapping()
+{
+    mapped.reset();
+    records = nullptr;
+    numRecords = 0;
+
+    if (!indexFile.existsAsFile())
+        return;
+
+    mapped.reset(new MemoryMappedFile(indexFile, MemoryMappedFile::readOnly));
+    auto* base = static_cast<const char*>(mapped->getData());
+    const size_t size = mapped->getSize();
+
+    IndexHeader header;
+    if (base == nullptr || size < sizeof(header))
+    {
+        mapped.reset();
+        return;
+    }
+
+    std::memcpy(&header, base, sizeof(header));
+    const bool valid = std::memcmp(header.magic, indexMagic, 4) == 0
+                    && header.version == formatVersion
+                    && header.recordSize == sizeof(AudioFeatures)
+                    && sizeof(header) + (size_t)header.numRecords * sizeof(AudioFeatures) <= size;
+    if (!valid)
+    {
+        Logger::writeToLog("FeatureIndex: ignoring unreadable index " + indexFile.getFullPathName());
+        mapped.reset();
+        return;
+    }
+
+    records = reinterpret_cast<const AudioFeatures*>(base + sizeof(header));
+    numRecords = (int)header.numRecords;
+}
+
+void FeatureIndex::loadPathTable()
+{
+    pathTable.clear();
+
+    StringArray lines;
+    pathTableFile.readLines(lines);
+
+    // <hash hex> \t <size> \t <mtime ms> \t <full path>
+    for (auto& line : lines)
+    {
+        auto hashStr = line.upToFirstOccurrenceOf("\t", false, false);
+        auto rest = line.fromFirstOccurrenceOf("\t", false, false);
+        auto sizeStr = rest.upToFirstOccurrenceOf("\t", false, false);
+        rest = rest.fromFirstOccurrenceOf("\t", false, false);
+        auto timeStr = rest.upToFirstOccurrenceOf("\t", false, false);
+        auto path = rest.fromFirstOccurrenceOf("\t", false, false);
+        if (path.isEmpty())
+            continue;
+
+        PathEntry e;
+        e.hash = (uint64_t)hashStr.getHexValue64();
+        e.size = sizeStr.getLargeIntValue();
+        e.modTime = timeStr.getLargeIntValue();
+        pathTable[path] = e;
+    }
+}
+
+bool FeatureIndex::writePathTable() const
+{
+    String text;
+    for (auto& kv : pathTable)
+        text << String::toHexString((int64)kv.second.hash) << "\t" << kv.second.size << "\t"
+             << kv.second.modTime << "\t" << kv.first << "\n";
+
+    TemporaryFile temp(pathTableFile);
+    return temp.getFile().replaceWithText(text) && temp.overwriteTargetFileWithTemporary();
+}
+
+bool FeatureIndex::writeIndex(const std::vector<AudioFeatures>& sortedRecords)
+{
+    indexFile.getParentDirectory().createDirectory();
+
+    TemporaryFile temp(indexFile);
+    {
+        FileOutputStream out(temp.getFile());
+        if (!out.openedOk())
+            return false;
+
+        IndexHeader header;
+        std::memcpy(header.magic, indexMagic, 4);
+        header.version = formatVersion;
+        header.numRecords = (uint32_t)sortedRecords.size();
+        header.recordSize = (uint32_t)sizeof(AudioFeatures);
+
+        out.write(&header, sizeof(header));
+        out.write(sortedRecords.data(), sortedRecords.size() * sizeof(AudioFeatures));
+        out.flush();
+        if (out.getStatus().failed())
+            return false;
+    }
+
+    // the old mapping has to go before the file can be replaced (Windows won't replace a mapped file)
+    ScopedLock sl(lock);
+    mapped.reset();
+    records = nullptr;
+    numRecords = 0;
+
+    const bool ok = temp.overwriteTargetFileWithTemporary();
+    openMapping();
+    return ok;
+}
+
+const AudioFeatures* FeatureIndex::findRecord(uint64_t contentHash) const
+{
+    if (records == nullptr)
+        return nullptr;
+
+    auto* end = records + numRecords;
+    auto* it = std::lower_bound(records, end, contentHash,
+                                [](const AudioFeatures& r, uint64_t h) { return r.contentHash < h; });
+    return (it != end && it->contentHash == contentHash) ? it : nullptr;
+}
+
+bool FeatureIndex::lookup(uint64_t contentHash, AudioFeatures& result) const
+{
+    ScopedLock sl(lock);
+    if (auto* r = findRecord(contentHash))
+    {
+        result = *r;
+        return true;
+    }
+    return false;
+}
+
+bool FeatureIndex::lookupFile(const File& file, AudioFeatures& result) const
+{
+    const auto size = file.getSize();
+    const auto modTime = file.getLastModificationTime().toMilliseconds();
+
+    {
+        ScopedLock sl(lock);
+        auto it = pathTable.find(file.getFullPathName());
+        if (it != pathTable.end() && it->second.size == size && it->second.modTime == modTime)
+        {
+            if (auto* r = findRecord(it->second.hash))
+            {
+                result = *r;
+                return true;
+            }
+        }
+    }
+
+    return lookup(hashFileContents(file), result);
+}
+
+File FeatureIndex::getFileForHash(uint64_t contentHash) const
+{
+    ScopedLock sl(lock);
+    for (auto& kv : pathTable)
+        if (kv.second.hash == contentHash)
+            return File(kv.first);
+    return {};
+}
+
+int FeatureIndex::getNumRecords() const
+{
+    ScopedLock sl(lock);
+    return numRecords;
+}
+
+std::vector<AudioFeatures> FeatureIndex::getAllRecords() const
+{
+    ScopedLock sl(lock);
+    return records != nullptr ? std::vector<AudioFeatures>(records, records + numRecords) : std::vector<AudioFeatures>();
+}
+
+FeatureIndex::UpdateStats FeatureIndex::update(const File& folder, bool recursive, int numThreads, ProgressCallback progress)
+{
+    ScopedLock updating(updateLock);
+
+    UpdateStats stats;
+    const double start = Time::getMillisecondCounterHiRes();
+
+    auto files = FolderResynthesizer::findAudioFiles(folder, recursive);
+    stats.numFiles = files.size();
+
+    // 1. anything whose path, size and mtime we've already seen is skipped outright
+    std::vector<PathEntry> entries((size_t)files.size());
+    std::vector<int> todo;
+    {
+        ScopedLock sl(lock);
+        for (int i = 0; i < files.size(); ++i)
+        {
+            auto& e = entries[(size_t)i];
+            e.size = files[i].getSize();
+            e.modTime = files[i].getLastModificationTime().toMilliseconds();
+
+            auto it = pathTable.find(files[i].getFullPathName());
+            if (it != pathTable.end() && it->second.size == e.size && it->second.modTime == e.modTime
+                && findRecord(it->second.hash) != nullptr)
+            {
+                e.hash = it->second.hash;
+                ++stats.numUnchanged;
+            }
+            else
+            {
+                todo.push_back(i);
+            }
+        }
+    }
+
+    // 2. hash the rest in parallel; only content we've never seen gets decoded + analyzed
+    std::vector<AudioFeatures> fresh(todo.size());
+    std::vector<char> status(todo.size(), 0); // 0 failed, 1 known content, 2 analyzed
+    std::atomic<int> done{ stats.numUnchanged };
+
+    ParallelJobs::run((int)todo.size(), numThreads, [&](int k)
+    {
+        const int i = todo[(size_t)k];
+        auto& e = entries[(size_t)i];
+        e.hash = hashFileContents(files[i]);
+
+        AudioFeatures existing;
+        if (lookup(e.hash, existing))
+        {
+            status[(size_t)k] = 1;
+        }
+        else
+        {
+            AudioFormatManager formatManager;
+            formatManager.registerBasicFormats();
+
+            AudioBuffer<float> mono;
+            double sampleRate = 44100.0;
+            if (ResynthesisAnalyzer::loadMono(formatManager, files[i], mono, sampleRate))
+            {
+                ResynthesisAnalyzer analyzer;
+                fresh[(size_t)k] = makeFeatures(e.hash, analyzer.analyze(mono, sampleRate));
+                status[(size_t)k] = 2;
+            }
+        }
+
+        const int finished = ++done;
+        if (progress)
+            progress(finished, files.size());
+    });
+
+    // 3. merge, write the new table and swap the mapping
+    auto merged = getAllRecords();
+    std::set<int> failed;
+    for (size_t k = 0; k < todo.size(); ++k)
+    {
+        if (status[k] == 2) { merged.push_back(fresh[k]); ++stats.numDecoded; }
+        else if (status[k] == 1) ++stats.numKnownContent;
+        else { failed.insert(todo[k]); ++stats.numFailed; }
+    }
+
+    if (stats.numDecoded > 0)
+    {
+        std::sort(merged.begin(), merged.end(),
+                  [](const AudioFeatures& a, const AudioFeatures& b) { return a.contentHash < b.contentHash; });
+        merged.erase(std::unique(merged.begin(), merged.end(),
+                                 [](const AudioFeatures& a, const AudioFeatures& b) { return a.contentHash == b.contentHash; }),
+                     merged.end());
+
+        if (!writeIndex(merged))
+            Logger::writeToLog("FeatureIndex: failed to write " + indexFile.getFullPathName());
+    }
+
+    {
+        ScopedLock sl(lock);
+
+        // forget files that disappeared from what was scanned, then record what we saw. Without
+        // recursive that is only the folder's own files: entries in its subfolders weren't looked at
+        const auto prefix = folder.getFullPathName() + File::getSeparatorString();
+        std::set<String> seen;
+        for (auto& f : files)
+            seen.insert(f.getFullPathName());
+
+        auto wasScanned = [&prefix, recursive](const String& path)
+        {
+            return path.startsWith(prefix)
+                && (recursive || !path.substring(prefix.length()).containsChar(File::getSeparatorChar()));
+        };
+
+        for (auto it = pathTable.begin(); it != pathTable.end();)
+        {
+            if (wasScanned(it->first) && seen.count(it->first) == 0)
+                it = pathTable.erase(it);
+            else
+                ++it;
+        }
+
+        for (int i = 0; i < files.size(); ++i)
+            if (failed.count(i) == 0)
+                pathTable[files[i].getFullPathName()] = entries[(size_t)i];
+
+        if (!writePathTable())
+            Logger::writeToLog("FeatureIndex: failed to write " + pathTableFile.getFullPathName());
+    }
+
+    stats.seconds = (Time::getMillisecondCounterHiRes() - start) / 1000.0;
+    return stats;
+}
+
+uint64_t FeatureIndex::hashFileContents(const File& file)
+{
+    MemoryMappedFile mm(file, MemoryMappedFile::readOnly);
+    if (mm.getData() != nullptr)
+        return hashBytes(mm.getData(), mm.getSize());
+
+    MemoryBlock data;
+    file.loadFileAsData(data);
+    return hashBytes(data.getData(), data.getSize());
+}
+
+AudioFeatures FeatureIndex::makeFeatures(uint64_t contentHash, const ResynthesisAnalysis& analysis)
+{
+    AudioFeatures f;
+    f.contentHash = contentHash;
+    f.f0Hz = (float)analysis.dominantHz;
+    f.attackSeconds = (float)analysis.attackSeconds;
+    f.releaseSeconds = (float)analysis.releaseSeconds;
+    f.peak = analysis.peak;
+    f.spectralCentroidHz = (float)analysis.spectralCentroidHz;
+    f.rms = (float)analysis.rms;
+    f.lengthSeconds = (float)analysis.lengthSeconds;
+    f.sampleRate = (float)analysis.sampleRate;
+    f.rootMidiNote = analysis.rootMidiNote;
+    return f;
+}
+
+ResynthesisAnalysis FeatureIndex::toAnalysis(const AudioFeatures& f)
+{
+    ResynthesisAnalysis a;
+    a.dominantHz = f.f0Hz;
+    a.spectralCentroidHz = f.spectralCentroidHz;
+    a.rootMidiNote = f.rootMidiNote;
+    a.rms = f.rms;
+    a.peak = f.peak;
+    a.attackSeconds = f.attackSeconds;
+    a.releaseSeconds = f.releaseSeconds;
+    a.lengthSeconds = f.lengthSeconds;
+    a.sampleRate = f.sampleRate;
+    return a;
+}
+
+String FeatureIndex::UpdateStats::toString() const
+{
+    return String(numFiles) + " files: " + String(numUnchanged) + " unchanged, "
+         + String(numKnownContent) + " known content, " + String(numDecoded) + " analyzed, "
+         + String(numFailed) + " failed in " + String(seconds, 2) + " s";
+}
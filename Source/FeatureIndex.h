@@ -0,0 +1,103 @@
+#pragma once
+#include <JuceHeader.h>
+#include "ResynthesisAnalyzer.h"
+#include <functional>
+#include <map>
+
+// One analysed sample as stored on disk. Plain data so the index file can be memory-mapped
+// and read in place; the layout is part of the file format (bump FeatureIndex::formatVersion if it changes).
+struct AudioFeatures
+{
+    uint64_t contentHash = 0;      // FeatureIndex::hashFileContents of the source file
+    float f0Hz = 0.0f;             // dominant frequency
+    float attackSeconds = 0.0f;
+    float releaseSeconds = 0.0f;
+    float peak = 0.0f;
+    float spectralCentroidHz = 0.0f;
+    float rms = 0.0f;
+    float lengthSeconds = 0.0f;
+    float sampleRate = 0.0f;
+    int32_t rootMidiNote = 0;
+    uint32_t reserved = 0;
+};
+
+static_assert(sizeof(AudioFeatures) == 48, "AudioFeatures is an on-disk record");
+
+/*
+ FeatureIndex
+ - Persistent content-hash -> AudioFeatures table for reference libraries
+ - <index>.idx holds the records sorted by hash and is memory-mapped for lookups
+ - <index>.paths remembers path/size/mtime -> hash so unchanged files are neither hashed nor decoded
+ - update() scans a folder, hashes only new/changed files and decodes+analyzes only unseen content,
+   spread over a thread pool; the new table is written to a temp file and swapped in
+ - All public methods are thread-safe
+*/
+class FeatureIndex
+{
+public:
+    static constexpr uint32_t formatVersion = 1;
+
+    explicit FeatureIndex(const juce::File& indexFile = getDefaultIndexFile());
+    ~FeatureIndex();
+
+    // <user app data>/808orade/features.idx
+    static juce::File getDefaultIndexFile();
+
+    bool lookup(uint64_t contentHash, AudioFeatures& result) const;
+
+    // path table first (size + mtime unchanged), otherwise hash the file bytes. Never decodes.
+    bool lookupFile(const juce::File& file, AudioFeatures& result) const;
+
+    // a file known to have this content, or File() if none
+    juce::File getFileForHash(uint64_t contentHash) const;
+
+    int getNumRecords() const;
+    std::vector<AudioFeatures> getAllRecords() const;
+
+    struct UpdateStats
+    {
+        int numFiles = 0;       // audio files found
+        int numUnchanged = 0;   // path/size/mtime matched: not even hashed
+        int numKnownContent = 0;// hashed, content already indexed (moved/copied/touched files)
+        int numDecoded = 0;     // decoded + analyzed
+        int numFailed = 0;
+        double seconds = 0.0;
+
+        juce::String toString() const;
+    };
+
+    using ProgressCallback = std::function<void(int done, int total)>;
+
+    UpdateStats update(const juce::File& folder, bool recursive = true, int numThreads = 0,
+                       ProgressCallback progress = nullptr);
+
+    static uint64_t hashFileContents(const juce::File& file);
+    static AudioFeatures makeFeatures(uint64_t contentHash, const ResynthesisAnalysis& analysis);
+    static ResynthesisAnalysis toAnalysis(const AudioFeatures& features);
+
+private:
+    struct PathEntry
+    {
+        juce::int64 size = 0;
+        juce::int64 modTime = 0;
+        uint64_t hash = 0;
+    };
+
+    void openMapping();                 // caller holds lock
+    void loadPathTable();               // caller holds lock
+    bool writeIndex(const std::vector<AudioFeatures>& sortedRecords);
+    bool writePathTable() const;        // caller holds lock
+    const AudioFeatures* findRecord(uint64_t contentHash) const; // caller holds lock
+
+    juce::File indexFile;
+    juce::File pathTableFile;
+
+    juce::CriticalSection updateLock;   // one update() at a time
+    mutable juce::CriticalSection lock; // guards the mapping + path table
+    std::unique_ptr<juce::MemoryMappedFile> mapped;
+    const AudioFeatures* records = nullptr;
+    int numRecords = 0;
+    std::map<juce::String, PathEntry> pathTable; // full path -> entry
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(FeatureIndex)
+};
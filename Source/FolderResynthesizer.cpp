@@ -0,0 +1,467 @@
+#include "FolderResynthesizer.h"
+#include "WavExporter.h"
+#include "ParallelJobs.h"
+#include "SeedBatch.h"
+#include <map>
+#include <set>
+
+using namespace juce;
+
+namespace
+{
+    double nowMs() { return Time::getMillisecondCounterHiRes(); }
+
+    String relativePath(const File& source, const File& inputFolder)
+    {
+        return source.getRelativePathFrom(inputFolder).replaceCharacter('\\', '/');
+    }
+
+    // where a source's render goes under the output folder, minus the "_resynth_<note>.wav": its path
+    // relative to the input folder without the extension, so subfolders are mirrored
+    String outputStem(const File& source, const File& inputFolder)
+    {
+        return relativePath(source, inputFolder).dropLastCharacters(source.getFileExtension().length());
+    }
+
+    // sources that would write the same WAV (kick.wav and kick.aif; compared ignoring case, for
+    // case-insensitive file systems), by relative path, with the error each one fails with
+    std::map<String, String> findOutputCollisions(const Array<File>& sources, const File& inputFolder)
+    {
+        std::map<String, StringArray> byStem;
+        for (auto& f : sources)
+            byStem[outputStem(f, inputFolder).toLowerCase()].add(relativePath(f, inputFolder));
+
+        std::map<String, String> collisions;
+        for (auto& stem : byStem)
+            if (stem.second.size() > 1)
+                for (auto& path : stem.second)
+                    collisions[path] = "would write the same output as " + stem.second.joinIntoString(", ");
+        return collisions;
+    }
+
+    // FNV-1a of the UTF-8 bytes and a splitmix64 finalizer, so neighbouring names spread over the shards
+    int shardOfPath(const String& relative, int numShards)
+    {
+        uint64_t h = 14695981039346656037ull;
+        for (auto* c = relative.toRawUTF8(); *c != 0; ++c)
+            h = (h ^ (uint8_t)*c) * 1099511628211ull;
+
+        h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ull;
+        h = (h ^ (h >> 27)) * 0x94d049bb133111ebull;
+        h ^= h >> 31;
+        return (int)(h % (uint64_t)jmax(1, numShards)) + 1;
+    }
+
+    // what every shard of one pack has to agree on
+    var optionsToJson(const FolderResynthesisOptions& o)
+    {
+        DynamicObject::Ptr j = new DynamicObject();
+        j->setProperty("recursive", o.recursive);
+        j->setProperty("baseSeed", String(o.baseSeed));
+        j->setProperty("lengthSeconds", o.lengthSeconds);
+        j->setProperty("autoLength", o.autoLength);
+        j->setProperty("silenceFloorDb", o.silenceFloorDb);
+        j->setProperty("bitsPerSample", o.bitsPerSample);
+        j->setProperty("monoFiles", o.monoFiles);
+        j->setProperty("engineVersion", GeneratorParams::latestEngineVersion);
+        j->setProperty("harmonicSmooth", o.settings.harmonicSmooth);
+        j->setProperty("envelopeSmooth", o.settings.envelopeSmooth);
+        j->setProperty("subWeight", o.settings.subWeight);
+        j->setProperty("transient", o.settings.transient);
+        j->setProperty("distortion", o.settings.distortion);
+        j->setProperty("noiseBlend", o.settings.noiseBlend);
+        j->setProperty("glide", o.settings.glide);
+        j->setProperty("accuracy", o.settings.accuracy);
+        return var(j.get());
+    }
+}
+
+bool FolderResynthesizer::writeJsonAtomically(const var& json, const File& file)
+{
+    const auto temp = file.getSiblingFile(file.getFileName() + ".tmp");
+    return temp.replaceWithText(JSON::toString(json)) && temp.moveFileTo(file);
+}
+
+Array<File> FolderResynthesizer::findAudioFiles(const File& folder, bool recursive)
+{
+    AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    auto files = folder.findChildFiles(File::findFiles, recursive, formatManager.getWildcardForAllFormats());
+    files.sort();
+    return files;
+}
+
+FolderResynthesisFileResult FolderResynthesizer::processFile(const File& source, const FolderResynthesisOptions& options,
+                                                             AudioFormatManager& formatManager)
+{
+    FolderResynthesisFileResult r;
+    r.source = source;
+    r.seed = seedFor(source, options);
+
+    // indexed files need neither decode nor analysis
+    double t0 = nowMs();
+    double t1 = t0;
+    ResynthesisAnalysis analysis;
+    AudioFeatures indexed;
+    if (options.featureIndex != nullptr && options.featureIndex->lookupFile(source, indexed))
+    {
+        analysis = FeatureIndex::toAnalysis(indexed);
+        r.fromIndex = true;
+    }
+    else
+    {
+        // decode
+        AudioBuffer<float> mono;
+        double sampleRate = 44100.0;
+        if (!ResynthesisAnalyzer::loadMono(formatManager, source, mono, sampleRate))
+        {
+            r.error = "could not decode";
+            return r;
+        }
+
+        // analyze
+        t1 = nowMs();
+        ResynthesisAnalyzer analyzer;
+        analysis = analyzer.analyze(mono, sampleRate);
+    }
+    r.sourceSeconds = analysis.lengthSeconds;
+    r.rootMidiNote = analysis.rootMidiNote;
+
+    // render
+    double t2 = nowMs();
+    auto gp = ResynthesisAnalyzer::makeParams(analysis, options.settings, r.seed, options.lengthSeconds);
+    gp.autoLength = options.autoLength;
+    gp.silenceFloorDb = options.silenceFloorDb;
+    Generator808 gen;
+    auto buf = gen.renderToBuffer(gp);
+    r.renderedSeconds = buf.getNumSamples() / gp.sampleRate;
+
+    // write
+    double t3 = nowMs();
+    r.output = options.outputFolder.getChildFile(outputStem(source, options.inputFolder)
+                                                 + "_resynth_" + ResynthesisAnalyzer::midiNoteName(analysis.rootMidiNote) + ".wav");
+    r.ok = buf.getNumSamples() > 0
+        && r.output.getParentDirectory().createDirectory().wasOk()
+        && WavExporter::saveBufferToWav(buf, gp.sampleRate, r.output, options.bitsPerSample, analysis.rootMidiNote, options.monoFiles);
+    if (!r.ok)
+        r.error = "could not write " + r.output.getFullPathName();
+    double t4 = nowMs();
+
+    r.decodeMs = t1 - t0;
+    r.analysisMs = t2 - t1;
+    r.renderMs = t3 - t2;
+    r.writeMs = t4 - t3;
+    return r;
+}
+
+FolderResynthesisReport FolderResynthesizer::run(const FolderResynthesisOptions& options,
+                                                 ProgressCallback progress,
+                                                 const std::atomic<bool>* cancelFlag)
+{
+    FolderResynthesisReport report;
+
+    auto sources = findAudioFiles(options.inputFolder, options.recursive);
+
+    // before sharding, so every shard agrees: sources that would write the same file fail instead
+    // of overwriting each other (from two workers, or two machines)
+    const auto collisions = findOutputCollisions(sources, options.inputFolder);
+
+    if (options.numShards > 1)
+    {
+        report.numOtherShards = sources.removeIf([&options](const File& f)
+        {
+            return shardOf(f, options.inputFolder, options.numShards) != options.shard;
+        });
+    }
+
+    report.files.resize((size_t)sources.size());
+    if (sources.isEmpty())
+        return report;
+
+    if (!options.outputFolder.isDirectory() && options.outputFolder.createDirectory().failed())
+    {
+        for (int i = 0; i < sources.size(); ++i)
+        {
+            report.files[(size_t)i].source = sources[i];
+            report.files[(size_t)i].error = "could not create " + options.outputFolder.getFullPathName();
+        }
+        return report;
+    }
+
+    report.numThreads = ParallelJobs::resolveThreadCount(options.numThreads);
+
+    const double start = nowMs();
+    std::atomic<int> done{ 0 };
+
+    ParallelJobs::run(sources.size(), report.numThreads, [&](int i)
+    {
+        auto& slot = report.files[(size_t)i];
+        const auto collision = collisions.find(relativePath(sources[i], options.inputFolder));
+        if (collision != collisions.end())
+        {
+            slot.source = sources[i];
+            slot.seed = seedFor(sources[i], options);
+            slot.error = collision->second;
+        }
+        else if (cancelFlag != nullptr && cancelFlag->load())
+        {
+            slot.source = sources[i];
+            slot.error = "cancelled";
+        }
+        else
+        {
+            AudioFormatManager formatManager;
+            formatManager.registerBasicFormats();
+            slot = processFile(sources[i], options, formatManager);
+        }
+
+        const int finished = ++done;
+        if (progress)
+            progress(slot, finished, sources.size());
+    });
+
+    report.wallSeconds = (nowMs() - start) / 1000.0;
+    for (auto& f : report.files)
+        if (f.ok) ++report.numSucceeded;
+
+    return report;
+}
+
+String FolderResynthesisReport::summary() const
+{
+    String s;
+    double analysisTotal = 0.0, audioTotal = 0.0;
+    for (auto& f : files)
+    {
+        s << f.source.getFileName() << ": ";
+        if (f.ok)
+            s << "ok -> " << f.output.getFileName()
+              << "  length " << String(f.renderedSeconds, 3) << " s"
+              << "  decode " << String(f.decodeMs, 1) << " ms"
+              << "  analysis " << String(f.analysisMs, 1) << " ms" << (f.fromIndex ? " (indexed)" : "")
+              << "  render " << String(f.renderMs, 1) << " ms"
+              << "  write " << String(f.writeMs, 1) << " ms";
+        else
+            s << "FAILED (" << f.error << ")";
+        s << "\n";
+        analysisTotal += f.analysisMs;
+        audioTotal += f.sourceSeconds;
+    }
+
+    s << numSucceeded << " / " << (int)files.size() << " files in " << String(wallSeconds, 2) << " s on "
+      << numThreads << " threads: " << String(filesPerSecond(), 1) << " files/s, "
+      << String(wallSeconds > 0.0 ? audioTotal / wallSeconds : 0.0, 1) << " s of reference audio per s, "
+      << "mean analysis " << String(files.empty() ? 0.0 : analysisTotal / (double)files.size(), 1) << " ms";
+    if (numOtherShards > 0)
+        s << " (" << numOtherShards << " files left to other shards)";
+    return s;
+}
+
+int64_t FolderResynthesizer::seedFor(const File& source, const FolderResynthesisOptions& options)
+{
+    // the relative path, not the name: a/kick.wav and b/kick.wav are different sources
+    return options.baseSeed ^ relativePath(source, options.inputFolder).hashCode64();
+}
+
+int FolderResynthesizer::shardOf(const File& source, const File& inputFolder, int numShards)
+{
+    return shardOfPath(relativePath(source, inputFolder), numShards);
+}
+
+File FolderResynthesizer::getShardManifestFile(const File& outputFolder, int shard, int numShards)
+{
+    return outputFolder.getChildFile("manifest-shard-" + String(shard) + "-of-" + String(numShards) + ".json");
+}
+
+bool FolderResynthesizer::writeShardManifest(const FolderResynthesisOptions& options, const FolderResynthesisReport& report,
+                                             String& error)
+{
+    Array<var> files;
+    for (auto& f : report.files)
+    {
+        DynamicObject::Ptr item = new DynamicObject();
+        item->setProperty("source", relativePath(f.source, options.inputFolder));
+        item->setProperty("ok", f.ok);
+        item->setProperty("seed", String(f.seed));
+        if (f.ok)
+        {
+            item->setProperty("output", relativePath(f.output, options.outputFolder));
+            item->setProperty("rootMidiNote", f.rootMidiNote);
+            item->setProperty("seconds", f.renderedSeconds);
+        }
+        else
+        {
+            item->setProperty("error", f.error);
+        }
+        files.add(var(item.get()));
+    }
+
+    DynamicObject::Ptr root = new DynamicObject();
+    root->setProperty("formatVersion", manifestFormatVersion);
+    root->setProperty("shard", options.shard);
+    root->setProperty("numShards", options.numShards);
+    root->setProperty("options", optionsToJson(options));
+    root->setProperty("numSucceeded", report.numSucceeded);
+    root->setProperty("wallSeconds", report.wallSeconds);
+    root->setProperty("files", files);
+
+    const auto file = getShardManifestFile(options.outputFolder, options.shard, options.numShards);
+    if (options.outputFolder.createDirectory().failed() || !writeJsonAtomically(var(root.get()), file))
+    {
+        error = "could not write " + file.getFullPathName();
+        return false;
+    }
+    return true;
+}
+
+bool FolderResynthesizer::mergeShardManifests(const File& outputFolder, int numShards, const File& packIndex,
+                                              PackMergeReport& report, String& error)
+{
+    if (numShards < 1)
+    {
+        error = "the number of shards must be at least 1";
+        return false;
+    }
+
+    // only this run's: a folder rendered again split another way still has the old run's manifests
+    auto manifests = outputFolder.findChildFiles(File::findFiles, false, "manifest-shard-*-of-" + String(numShards) + ".json");
+    manifests.sort();
+    if (manifests.isEmpty())
+    {
+        error = "no manifests of a run split " + String(numShards) + " ways in " + outputFolder.getFullPathName();
+        return false;
+    }
+
+    report = {};
+    report.numShards = numShards;
+    var options;
+    String optionsText, kind;
+    std::vector<bool> seen((size_t)numShards, false);
+    std::map<String, int> shardOfSource;
+    std::set<String> outputs;
+    Array<var> items;
+
+    for (auto& manifest : manifests)
+    {
+        const auto json = JSON::parse(manifest);
+        auto* root = json.getDynamicObject();
+        if (root == nullptr || (int)root->getProperty("formatVersion") != manifestFormatVersion)
+        {
+            error = manifest.getFileName() + " is not a shard manifest this version can read";
+            return false;
+        }
+
+        const int shard = root->getProperty("shard");
+        const int manifestShards = root->getProperty("numShards");
+        if (manifestShards != numShards)
+        {
+            error = manifest.getFileName() + " belongs to a run split " + String(manifestShards) + " ways, not "
+                  + String(numShards);
+            return false;
+        }
+
+        // "files" (--resynth-folder, written before there were kinds) or "seeds" (SeedBatch)
+        const auto manifestKind = root->getProperty("kind").toString().isEmpty() ? String("files") : root->getProperty("kind").toString();
+
+        if (options.isVoid())
+        {
+            options = root->getProperty("options");
+            optionsText = JSON::toString(options, true);
+            kind = manifestKind;
+        }
+
+        if (manifestKind != kind)
+        {
+            error = manifest.getFileName() + " is a manifest of " + manifestKind + ", " + manifests[0].getFileName() + " of " + kind;
+            return false;
+        }
+
+        if (JSON::toString(root->getProperty("options"), true) != optionsText)
+        {
+            error = manifest.getFileName() + " was rendered with different options than " + manifests[0].getFileName();
+            return false;
+        }
+        if (shard < 1 || shard > numShards || seen[(size_t)shard - 1])
+        {
+            error = manifest.getFileName() + " repeats shard " + String(shard);
+            return false;
+        }
+        seen[(size_t)shard - 1] = true;
+
+        if (auto* files = root->getProperty("files").getArray())
+        {
+            for (auto& item : *files)
+            {
+                // files are partitioned by a hash of their path, seeds by index range
+                const bool seeds = kind == "seeds";
+                const auto source = seeds ? "item " + item["index"].toString() : item["source"].toString();
+                const int owner = seeds ? SeedBatch::shardOfIndex((int)item["index"], (int)options["count"], numShards)
+                                        : shardOfPath(source, numShards);
+                if (owner != shard)
+                {
+                    error = source + " is in shard " + String(shard) + (owner == 0 ? String(" but outside the batch")
+                                                                                   : " but belongs to shard " + String(owner));
+                    return false;
+                }
+
+                // shards partition the items, so this only trips when a manifest is listed twice under another name
+                if (!shardOfSource.emplace(source, shard).second)
+                {
+                    error = source + " was rendered by more than one shard";
+                    return false;
+                }
+
+                if ((bool)item["ok"])
+                {
+                    const auto output = item["output"].toString();
+                    if (!outputs.insert(output).second)
+                    {
+                        error = "two sources were rendered to " + output;
+                        return false;
+                    }
+                    ++report.numSucceeded;
+                }
+
+                if (auto* object = item.getDynamicObject())
+                    object->setProperty("shard", shard);
+                items.add(item);
+            }
+        }
+    }
+
+    StringArray missing;
+    for (size_t s = 0; s < seen.size(); ++s)
+        if (!seen[s])
+            missing.add(String((int)s + 1));
+    if (!missing.isEmpty())
+    {
+        error = "missing shard " + missing.joinIntoString(", ") + " of " + String(report.numShards);
+        return false;
+    }
+
+    std::sort(items.begin(), items.end(), [&kind](const var& a, const var& b)
+    {
+        if (kind == "seeds")
+            return (int)a["index"] < (int)b["index"];
+        return a["source"].toString() < b["source"].toString();
+    });
+    report.numItems = items.size();
+    report.packIndex = packIndex != File() ? packIndex : outputFolder.getChildFile("pack-index.json");
+
+    DynamicObject::Ptr root = new DynamicObject();
+    root->setProperty("formatVersion", manifestFormatVersion);
+    root->setProperty("kind", kind);
+    root->setProperty("numShards", report.numShards);
+    root->setProperty("options", options);
+    root->setProperty("numItems", report.numItems);
+    root->setProperty("numSucceeded", report.numSucceeded);
+    root->setProperty("items", items);
+
+    if (!writeJsonAtomically(var(root.get()), report.packIndex))
+    {
+        error = "could not write " + report.packIndex.getFullPathName();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,122 @@
+#pragma once
+#include <JuceHeader.h>
+#include "ResynthesisAnalyzer.h"
+#include "FeatureIndex.h"
+#include <atomic>
+#include <functional>
+
+/*
+ FolderResynthesizer
+ - Converts every audio file in a folder into a regenerated 808 (decode -> analyze -> render -> WAV)
+ - Files are spread across a juce::ThreadPool; each worker owns its own analyzer + generator
+ - Used by ResynthesisWindow ("Resynthesize Folder...") and the headless --resynth-folder command
+ - Sharding spreads one folder over several processes or machines sharing a filesystem: shard k of N
+   renders only the files shardOf assigns to it (a hash of the path relative to the input folder,
+   so every process agrees without talking to the others). Seeds come from the file, not the shard.
+ - Seeds and outputs are keyed on the path relative to the input folder: renders mirror the input's
+   subfolders (<outputFolder>/<sub>/<name>_resynth_<note>.wav). Sources that would still write the
+   same file (kick.wav next to kick.aif) fail before anything is rendered
+   Each shard writes a manifest next to its renders; mergeShardManifests checks that every shard
+   is there and that no file was rendered twice, then writes one pack index. It merges the
+   manifests of a sharded SeedBatch the same way
+*/
+
+struct FolderResynthesisOptions
+{
+    juce::File inputFolder;
+    juce::File outputFolder;
+    bool recursive = false;
+    int numThreads = 0;            // 0 = one per CPU core
+    ResynthesisSettings settings;
+    int64_t baseSeed = 0;          // combined with each file's relative path so reruns give the same results
+    double lengthSeconds = 1.6;    // with autoLength, the longest a render may be
+    bool autoLength = false;       // trim each render to its tail (GeneratorParams::autoLength)
+    float silenceFloorDb = -90.0f;
+    int bitsPerSample = 24;
+    bool monoFiles = false;        // write renders without stereo width as mono WAVs (half the size)
+    const FeatureIndex* featureIndex = nullptr; // optional: indexed files skip decode + analysis
+    int shard = 1, numShards = 1;  // 1-based: render only the files of shard `shard` of numShards
+};
+
+struct FolderResynthesisFileResult
+{
+    juce::File source;
+    juce::File output;
+    bool ok = false;
+    juce::String error;
+    int rootMidiNote = -1;
+    int64_t seed = 0;
+    bool fromIndex = false;        // analysis came from the feature index (no decode)
+    double decodeMs = 0.0;
+    double analysisMs = 0.0;
+    double renderMs = 0.0;
+    double writeMs = 0.0;
+    double sourceSeconds = 0.0;    // length of the decoded reference
+    double renderedSeconds = 0.0;  // length of the written 808 (shorter than lengthSeconds with autoLength)
+};
+
+struct FolderResynthesisReport
+{
+    std::vector<FolderResynthesisFileResult> files; // in input order
+    int numSucceeded = 0;
+    int numOtherShards = 0;        // files in the folder that belong to other shards
+    double wallSeconds = 0.0;
+    int numThreads = 0;
+
+    double filesPerSecond() const { return wallSeconds > 0.0 ? (double)files.size() / wallSeconds : 0.0; }
+    juce::String summary() const;  // one line per file + throughput totals
+};
+
+struct PackMergeReport
+{
+    int numShards = 0;
+    int numItems = 0;
+    int numSucceeded = 0;
+    juce::File packIndex;
+};
+
+class FolderResynthesizer
+{
+public:
+    // called from worker threads after each file; done counts finished files
+    using ProgressCallback = std::function<void(const FolderResynthesisFileResult& result, int done, int total)>;
+
+    static FolderResynthesisReport run(const FolderResynthesisOptions& options,
+                                       ProgressCallback progress = nullptr,
+                                       const std::atomic<bool>* cancelFlag = nullptr);
+
+    // every file in the folder that one of the basic formats can read, sorted by path
+    static juce::Array<juce::File> findAudioFiles(const juce::File& folder, bool recursive);
+
+    // decode + analyze + render + export a single file (used by the workers, exposed for reuse)
+    static FolderResynthesisFileResult processFile(const juce::File& source, const FolderResynthesisOptions& options,
+                                                   juce::AudioFormatManager& formatManager);
+
+    // the generator seed of a source file: options.baseSeed and its path relative to inputFolder,
+    // whichever shard renders it
+    static int64_t seedFor(const juce::File& source, const FolderResynthesisOptions& options);
+
+    // 1..numShards, from the path relative to inputFolder with '/' separators (the same on every OS)
+    static int shardOf(const juce::File& source, const juce::File& inputFolder, int numShards);
+
+    // <outputFolder>/manifest-shard-<shard>-of-<numShards>.json
+    static juce::File getShardManifestFile(const juce::File& outputFolder, int shard, int numShards);
+
+    // of the shard manifests and pack indexes, SeedBatch's included
+    static constexpr int manifestFormatVersion = 1;
+
+    // written beside the target and renamed, so a merge running at the same time never reads half a file
+    static bool writeJsonAtomically(const juce::var& json, const juce::File& file);
+
+    // the manifest of the shard run() just rendered: its options and every file with its seed and result
+    static bool writeShardManifest(const FolderResynthesisOptions& options, const FolderResynthesisReport& report,
+                                   juce::String& error);
+
+    // reads the manifests of the run split numShards ways in outputFolder (manifest-shard-*-of-<numShards>.json;
+    // those of runs split another way are left alone) and writes packIndex (default
+    // <outputFolder>/pack-index.json) listing all items sorted by source path, or by index for a seed
+    // batch. False with error set if a shard is missing or duplicated, the shards were run with different
+    // options or kinds, or an item appears in more than one shard or in the wrong one
+    static bool mergeShardManifests(const juce::File& outputFolder, int numShards, const juce::File& packIndex,
+                                    PackMergeReport& report, juce::String& error);
+};
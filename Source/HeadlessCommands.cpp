@@ -0,0 +1,1983 @@
+#include "HeadlessCommands.h"
+#include "FolderResynthesizer.h"
+#include "SeedBatch.h"
+#include "FeatureIndex.h"
+#include "SimilaritySearch.h"
+#include "PluginProcessor.h"
+#include "StagedGenerator.h"
+#include "BatchGenerator808.h"
+#include "FastMath.h"
+#include "Oversampler.h"
+#include "RenderContext.h"
+#include "AllocationCounter.h"
+#include "ParallelJobs.h"
+#include "RenderDaemon.h"
+#include "RealtimeChecker.h"
+#include "HostSimulator.h"
+#include "StageTimers.h"
+#include "EngineGolden.h"
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+
+using namespace juce;
+
+namespace
+{
+    // --shard=i/N, 1/1 when it isn't given
+    void parseShard(const ArgumentList& args, int& shard, int& numShards)
+    {
+        shard = numShards = 1;
+        if (!args.containsOption("--shard"))
+            return;
+
+        const auto tokens = StringArray::fromTokens(args.getValueForOption("--shard"), "/", "");
+        shard = tokens[0].getIntValue();
+        numShards = tokens[1].getIntValue();
+        if (tokens.size() != 2 || numShards < 1 || shard < 1 || shard > numShards)
+            ConsoleApplication::fail("--shard must be i/N with 1 <= i <= N");
+    }
+}
+
+ArgumentList HeadlessCommands::makeArgumentList(const StringArray& args)
+{
+    return ArgumentList(File::getSpecialLocation(File::currentExecutableFile).getFileName(), args);
+}
+
+ConsoleApplication HeadlessCommands::makeApp()
+{
+    ConsoleApplication app;
+    app.addHelpCommand("--help|-h", "808orade headless commands (run without arguments for the GUI):", false);
+
+    app.addCommand({ "--resynth-folder",
+                     "--resynth-folder <inputFolder> <outputFolder> [--threads=N] [--recursive] [--index=<file>] [--length=N] [--auto-length[=floorDb]] [--mono] [--shard=i/N]",
+                     "Resynthesize every audio file in a folder into clean 808s.",
+                     "Decodes, analyzes and regenerates each file on a thread pool and writes\n"
+                     "<name>_resynth_<note>.wav with the detected root note in the smpl chunk (with --recursive, in\n"
+                     "the same subfolder under <outputFolder>; files that would write the same WAV fail).\n"
+                     "Prints per-file analysis time, rendered length and overall throughput. With --index, files\n"
+                     "already in that feature index are not decoded or analyzed again. --length sets the render\n"
+                     "length in seconds (default 1.6); with --auto-length it is the maximum and each 808 stops\n"
+                     "once it has decayed below floorDb (default -90 dBFS), fades out and is trimmed there.\n"
+                     "--mono writes renders without stereo width as mono files instead of two identical channels.\n"
+                     "--shard=i/N (1 <= i <= N) renders only this process's share of the files, so N processes or\n"
+                     "machines sharing the folders can split one job; each writes manifest-shard-i-of-N.json to\n"
+                     "<outputFolder>. Every shard has to be run with the same options. Combine them with --merge-shards --shards=N.",
+                     [](const ArgumentList& a) { resynthFolder(a); } });
+
+    app.addCommand({ "--render-seeds",
+                     "--render-seeds <outputFolder> --count=N [--first-seed=S] [--length=N] [--auto-length[=floorDb]] [--mono] [--threads=N] [--shard=i/N]",
+                     "Render N consecutive seeds into a folder with the SIMD batch renderer.",
+                     "Renders seeds S, S + 1, ... S + N - 1 (default S 0) with the latest engine and otherwise fixed\n"
+                     "params on a thread pool and writes seed_<seed>.wav to <outputFolder>. --length, --auto-length and\n"
+                     "--mono work as for --resynth-folder. --shard=i/N (1 <= i <= N) renders only the i-th of N\n"
+                     "contiguous ranges of the N seeds, so N processes or machines can split one batch; each writes\n"
+                     "manifest-shard-i-of-N.json to <outputFolder>. Every shard has to be run with the same --count,\n"
+                     "--first-seed and options. Combine them with --merge-shards --shards=N.",
+                     [](const ArgumentList& a) { renderSeeds(a); } });
+
+    app.addCommand({ "--merge-shards",
+                     "--merge-shards <outputFolder> --shards=N [--out=<file>]",
+                     "Combine the shard manifests of a sharded --resynth-folder or --render-seeds run into one pack index.",
+                     "Reads every manifest-shard-*-of-N.json in <outputFolder>, N being the run's --shard=i/N (manifests\n"
+                     "left by runs split another way are ignored), and writes --out (default\n"
+                     "<outputFolder>/pack-index.json) listing every rendered file with its seed (and for a folder its\n"
+                     "source and root note) and length. Fails if a shard is missing or repeated, the shards disagree on\n"
+                     "their options, or an item was rendered by two shards or by the wrong one.",
+                     [](const ArgumentList& a) { mergeShards(a); } });
+
+    app.addCommand({ "--index-library",
+                     "--index-library <folder> [--index=<file>] [--threads=N]",
+                     "Add a reference library to the on-disk feature index.",
+                     "Scans the folder recursively. Files whose path, size and date are unchanged are skipped,\n"
+                     "changed files are re-hashed and only content never seen before is decoded and analyzed.\n"
+                     "The default index lives in the user application data folder.",
+                     [](const ArgumentList& a) { indexLibrary(a); } });
+
+    app.addCommand({ "--find-similar",
+                     "--find-similar <file> [--index=<file>] [--k=N] [--seeds=N]",
+                     "List the indexed samples and generator seeds closest to an audio file.",
+                     "The file is looked up in the feature index (or analyzed if it isn't there) and compared\n"
+                     "against every indexed sample. --seeds renders that many seeds around the matching\n"
+                     "resynthesis params and lists the closest ones too (default 256, 0 to skip).",
+                     [](const ArgumentList& a) { findSimilar(a); } });
+
+    app.addCommand({ "--bench-similarity",
+                     "--bench-similarity [--items=N] [--queries=N]",
+                     "Time nearest-neighbour queries over N synthetic feature vectors (default 100000).",
+                     "Fails if the average query takes 10 ms or more.",
+                     [](const ArgumentList& a) { benchSimilarity(a); } });
+
+    app.addCommand({ "--meter-preview",
+                     "--meter-preview [--seed=N] [--block=N]",
+                     "Play a generated 808 through processBlock and print the output meter readings.",
+                     "Drives the processor like a host would (default 512-sample blocks at 44.1 kHz) and\n"
+                     "reads the output meter FIFO every ~33 ms of audio, as the editor's timer does.\n"
+                     "Fails on NaN/inf, a silent preview, clipping or dropped meter samples.",
+                     [](const ArgumentList& a) { meterPreview(a); } });
+
+    app.addCommand({ "--sweep",
+                     "--sweep [--seeds=N] [--detunes=a,b,..] [--gains=a,b,..] [--out=<folder>]",
+                     "Render a seed x detune x master gain grid with stage memoization.",
+                     "Every combination is rendered through StagedGenerator and checked against a plain\n"
+                     "Generator808 render; prints both timings and the per-stage cache hit rates.\n"
+                     "With --out the renders are written as <seed>_d<detune>_g<gain>.wav.",
+                     [](const ArgumentList& a) { sweep(a); } });
+
+    app.addCommand({ "--bench-batch",
+                     "--bench-batch [--voices=N] [--lanes=4|8|16]",
+                     "Render N random voices with the SIMD batch renderer and with Generator808 (default 64).",
+                     "Prints voices per second for both and the largest per-sample difference. Lanes default\n"
+                     "to the widest the build targets. Fails if a voice's length differs or any sample is off\n"
+                     "by more than 1e-4 (libm vs vectorized transcendentals can differ in the last ulp).",
+                     [](const ArgumentList& a) { benchBatch(a); } });
+
+    app.addCommand({ "--bench-math",
+                     "--bench-math [--samples=N]",
+                     "Check FastMath's accuracy tiers against libm and time both.",
+                     "Evaluates sin, exp, exp2, tanh and log2 at N points over each function's documented\n"
+                     "range (default 1048576) in both tiers. Prints the worst error next to the documented\n"
+                     "bound and ns/sample for FastMath's block functions and a plain libm loop.\n"
+                     "Fails if any error exceeds its bound.",
+                     [](const ArgumentList& a) { benchMath(a); } });
+
+    app.addCommand({ "--bench-render",
+                     "--bench-render [--seconds=N] [--rate=N] [--renders=N]",
+                     "Time Generator808's block-fused render against running its stages one after another.",
+                     "Renders N voices (default 8 of 5 s at 96 kHz) both ways and checks they are bit-identical.\n"
+                     "Prints the time per render and how much full-length buffer traffic each way needs.\n"
+                     "The traffic is counted from the passes each path makes, not measured.",
+                     [](const ArgumentList& a) { benchRender(a); } });
+
+    app.addCommand({ "--bench-oversampling",
+                     "--bench-oversampling [--rate=N] [--renders=N]",
+                     "Measure how much aliasing oversampling removes and what it costs.",
+                     "Drives a 4 kHz sine through the soft clip curve at 1x, 2x and 4x and prints the aliasing that\n"
+                     "lands below 20 kHz relative to the harmonics. Then times N growly 808 renders (default 8)\n"
+                     "at --rate (default 44100) with each factor, and at 4x the rate without oversampling.\n"
+                     "Fails if 2x or 4x doesn't cut the aliasing by at least 40 dB.",
+                     [](const ArgumentList& a) { benchOversampling(a); } });
+
+    app.addCommand({ "--check-allocations",
+                     "--check-allocations [--rounds=N]",
+                     "Check that warmed-up renders and publishing them don't allocate.",
+                     "Runs what the editor and the batch exporter do (a draft and a full render per edit, the full\n"
+                     "one published through PluginProcessor::generate808AndStore with its peak pyramid, and 16-voice\n"
+                     "batch chunks) over mono, stereo, oversampled and auto-length settings. After two warm-up rounds\n"
+                     "it counts operator new calls over N more (default 20) and checks every result landed in a buffer\n"
+                     "the contexts already had. Prints the same count for a plain Generator808::renderToBuffer for\n"
+                     "comparison. Fails if a warmed-up render or publish allocates. Needs a build with\n"
+                     "ORADE808_TEST_HOOKS (debug builds have it).",
+                     [](const ArgumentList& a) { checkAllocations(a); } });
+
+    app.addCommand({ "--stress-threads",
+                     "--stress-threads [--threads=N] [--rounds=N]",
+                     "Check that the static Generator808 render is safe to call from many threads at once.",
+                     "Renders one shared list of settings (mono, stereo, oversampled, auto length, drafts) on N\n"
+                     "threads at once (default: one per core), each with its own Generator808::State, for N\n"
+                     "rounds (default 4), every thread starting at a different voice. Every result has to match a\n"
+                     "single-threaded render bit for bit. Run it in a ThreadSanitizer build to check for races too.\n"
+                     "Fails on any mismatch.",
+                     [](const ArgumentList& a) { stressThreads(a); } });
+
+    app.addCommand({ "--check-engines",
+                     "--check-engines <goldenFile> [--update]",
+                     "Compare every engine version's output with the golden hashes.",
+                     "Renders a fixed set of settings (mono, stereo, growl + analog noise, 2x and 4x oversampling,\n"
+                     "auto length, a draft) with every version in Generator808::getEngineVersions and compares the hash\n"
+                     "of each render with <goldenFile> (the repo's Golden/engines.txt). Render hashes depend on the\n"
+                     "C library's maths, so they are only checked where its fingerprint matches the file's reference\n"
+                     "platform; the portable entries (each version's random draws) are checked everywhere.\n"
+                     "--update rewrites the file from this platform. Fails on any mismatch or missing entry.",
+                     [](const ArgumentList& a) { checkEngines(a); } });
+
+    app.addCommand({ "--fuzz-render",
+                     "--fuzz-render [--cases=N] [--seed=N] [--top=N] [--slowdown=x] [--report=<file.csv>]",
+                     "Render random corners of the parameter space, looking for bad output and slow settings.",
+                     "Renders N random settings (default 500, from --seed) across sample rates 8k-192k, lengths\n"
+                     "10 ms-8 s, every keyword amount with extra weight on 0 and 1, tuning, gain, oversampling, auto\n"
+                     "length and engine version. Each render is timed per output sample and scanned for NaN, Inf,\n"
+                     "denormals and samples beyond full scale. A render of at least 8192 samples costing more than\n"
+                     "--slowdown (default 3) times the median for its oversampling factor is re-timed and, if still\n"
+                     "slow, flagged. Prints the --top (default 10) slowest settings and the worst real-time factor;\n"
+                     "--report writes every case as CSV. Fails on non-finite or denormal output or a flagged slowdown.",
+                     [](const ArgumentList& a) { fuzzRender(a); } });
+
+    app.addCommand({ "--check-denormals",
+                     "--check-denormals [--seconds=N] [--repeats=N] [--max-ratio=x]",
+                     "Check that the decaying tail of a render costs no more than its start.",
+                     "Renders a short-decay 808, so nearly all of it is the tail where envelope and filter state\n"
+                     "decay towards zero, at lengths of 1 .. N seconds (default 8) through the scalar render at 1x, 2x and 4x\n"
+                     "oversampling, the draft render and the SIMD batch, keeping the fastest of --repeats (default 5)\n"
+                     "timings. Prints the cost of each one-second block (the difference between consecutive lengths)\n"
+                     "and fails if the tail after the first second costs more than --max-ratio (default 2) times the\n"
+                     "first second per sample, i.e. if denormals are stalling the DSP.",
+                     [](const ArgumentList& a) { checkDenormals(a); } });
+
+    app.addCommand({ "--check-realtime",
+                     "--check-realtime [--blocks=N]",
+                     "Check that processBlock never allocates, frees or blocks on a lock.",
+                     "Runs processBlock for N blocks (default 20000) of 512 stereo samples on an audio thread with a\n"
+                     "RealtimeChecker attached, while the main thread starts and stops the preview, publishes new mono\n"
+                     "and stereo buffers and reads the current one, as the editor does. Every operator new / delete on\n"
+                     "the audio thread is a violation, printed with its call site; on Linux so is every malloc / free\n"
+                     "and mutex lock (see RealtimeChecker.h for what isn't seen). First makes sure the checker sees a\n"
+                     "deliberate allocation and lock, so it can't pass by being blind. Fails on any violation. Needs a\n"
+                     "build with ORADE808_TEST_HOOKS (debug builds have it).",
+                     [](const ArgumentList& a) { checkRealtime(a); } });
+
+    app.addCommand({ "--simulate-host",
+                     "--simulate-host [--rates=a,b,..] [--blocks=a,b,..] [--seconds=N] [--transport-threads=N] [--free-run] [--max-p99=x]",
+                     "Drive the processor like a DAW and measure every audio callback against its budget.",
+                     "For each sample rate (default 44100,48000,96000) and block size (default 64,256,1024) creates a\n"
+                     "PluginProcessor and calls processBlock for --seconds (default 5) of audio, each callback at its\n"
+                     "deadline (--free-run: back to back), while another thread keeps calling generate808AndStore and\n"
+                     "--transport-threads (default 2) keep starting and stopping the preview and reading the buffer.\n"
+                     "Prints the callback time distribution (mean, p50, p99, p99.9, max) against the budget of\n"
+                     "block / rate and the callbacks that overran it, and the preview blocks that were silenced (nothing\n"
+                     "to play) or underran (overran or started late while previewing). Fails if a p99 is over\n"
+                     "--max-p99 (default 0.5) times the budget, or on any silenced or underrun preview block. The\n"
+                     "audio thread isn't real-time priority, so expect a few scheduling spikes.",
+                     [](const ArgumentList& a) { simulateHost(a); } });
+
+    app.addCommand({ "--daemon",
+                     "--daemon [--socket=<path>] [--threads=N] [--max-batch=N] [--batch-window=ms]",
+                     "Serve render requests on a local socket until told to shut down.",
+                     "Listens on a UNIX domain socket (default <temp folder>/808orade-render.sock) for one JSON\n"
+                     "request per line and answers with inline float32 PCM or a WAV file (see RenderDaemon.h for the\n"
+                     "protocol). Requests arriving within --batch-window ms (default 2) of each other, up to\n"
+                     "--max-batch (default 64), render as one batch on --threads (default: one per core).\n"
+                     "Runs until a client sends {\"cmd\": \"shutdown\"}, then prints queue latency and throughput.",
+                     [](const ArgumentList& a) { daemon(a); } });
+
+    app.addCommand({ "--daemon-test",
+                     "--daemon-test [--clients=N] [--requests=N]",
+                     "Check the render daemon end to end on a temporary socket.",
+                     "Starts a daemon, connects N clients at once (default 8) that each send N requests (default 16)\n"
+                     "of varied settings (half naming the latest engine, half no engine, i.e. v1), some answered\n"
+                     "inline and some written to WAV files, plus a few malformed\n"
+                     "ones. Inline PCM has to match Generator808::renderToBuffer (within --bench-batch's tolerance)\n"
+                     "and files have to exist. Then asks for the stats, shuts the daemon down over the socket and\n"
+                     "prints how the requests were batched. Fails on any wrong answer.",
+                     [](const ArgumentList& a) { daemonTest(a); } });
+
+    return app;
+}
+
+bool HeadlessCommands::handles(const StringArray& args)
+{
+    if (args.isEmpty())
+        return false;
+
+    auto app = makeApp();
+    return app.findCommand(makeArgumentList(args), true) != nullptr;
+}
+
+int HeadlessCommands::run(const StringArray& args)
+{
+    auto app = makeApp();
+    const auto argList = makeArgumentList(args);
+
+    // any command: time the render stages while it runs (see StageTimers)
+    const bool printStats = argList.containsOption("--stats");
+    const bool writeTrace = argList.containsOption("--trace");
+    if ((printStats || writeTrace) && !StageTimers::isCompiledIn())
+        std::cerr << "Stage timers are compiled out of this build; rebuild with ORADE808_STAGE_TIMERS=1" << std::endl;
+
+    StageTimers::setEnabled(printStats || writeTrace);
+    StageTimers::setTracing(writeTrace);
+
+    int result = app.findAndRunCommand(argList, true);
+
+    if (printStats && StageTimers::isCompiledIn())
+        std::cout << StageTimers::formatStats() << std::endl;
+
+    if (writeTrace && StageTimers::isCompiledIn())
+    {
+        const auto traceFile = argList.getFileForOption("--trace");
+        String error;
+        if (StageTimers::writeChromeTrace(traceFile, error))
+        {
+            std::cout << "Wrote a timeline of the render stages to " << traceFile.getFullPathName() << std::endl;
+        }
+        else
+        {
+            std::cerr << error << std::endl;
+            result = jmax(result, 1);
+        }
+    }
+
+    return result;
+}
+
+void HeadlessCommands::resynthFolder(const ArgumentList& args)
+{
+    args.checkMinNumArguments(3);
+
+    FolderResynthesisOptions options;
+    options.inputFolder = args[1].resolveAsExistingFolder();
+    options.outputFolder = args[2].resolveAsFile();
+    options.recursive = args.containsOption("--recursive");
+    options.monoFiles = args.containsOption("--mono");
+    if (args.containsOption("--threads"))
+        options.numThreads = args.getValueForOption("--threads").getIntValue();
+    if (args.containsOption("--length"))
+        options.lengthSeconds = jlimit(0.05, 60.0, args.getValueForOption("--length").getDoubleValue());
+    if (args.containsOption("--auto-length"))
+    {
+        options.autoLength = true;
+        auto floorDb = args.getValueForOption("--auto-length");
+        if (floorDb.isNotEmpty())
+            options.silenceFloorDb = jlimit(-160.0f, -20.0f, floorDb.getFloatValue());
+    }
+
+    parseShard(args, options.shard, options.numShards);
+
+    std::unique_ptr<FeatureIndex> index;
+    if (args.containsOption("--index"))
+    {
+        index.reset(new FeatureIndex(args.getExistingFileForOption("--index")));
+        options.featureIndex = index.get();
+    }
+
+    std::cout << "Resynthesizing " << options.inputFolder.getFullPathName() << " -> "
+              << options.outputFolder.getFullPathName();
+    if (options.numShards > 1)
+        std::cout << " (shard " << options.shard << " of " << options.numShards << ")";
+    std::cout << std::endl;
+
+    std::mutex printLock;
+    auto report = FolderResynthesizer::run(options,
+        [&printLock](const FolderResynthesisFileResult& r, int done, int total)
+        {
+            std::lock_guard<std::mutex> lock(printLock);
+            std::cout << "[" << done << "/" << total << "] " << r.source.getFileName()
+                      << (r.ok ? "  analysis " + String(r.analysisMs, 1) + " ms" : "  FAILED: " + r.error) << std::endl;
+        });
+
+    std::cout << report.summary() << std::endl;
+
+    if (report.files.empty() && report.numOtherShards == 0)
+        ConsoleApplication::fail("No audio files found in " + options.inputFolder.getFullPathName());
+
+    // an empty shard still writes its manifest, so the merge knows it ran
+    if (options.numShards > 1)
+    {
+        String error;
+        if (!FolderResynthesizer::writeShardManifest(options, report, error))
+            ConsoleApplication::fail(error);
+        std::cout << "Wrote " << FolderResynthesizer::getShardManifestFile(options.outputFolder, options.shard, options.numShards).getFullPathName()
+                  << std::endl;
+    }
+
+    if (report.numSucceeded < (int)report.files.size())
+        ConsoleApplication::fail(String((int)report.files.size() - report.numSucceeded) + " file(s) failed");
+}
+
+void HeadlessCommands::renderSeeds(const ArgumentList& args)
+{
+    args.checkMinNumArguments(2);
+
+    SeedBatchOptions options;
+    options.outputFolder = args[1].resolveAsFile();
+    options.count = args.containsOption("--count") ? args.getValueForOption("--count").getIntValue() : 0;
+    if (options.count < 1)
+        ConsoleApplication::fail("--count=N is required: the number of seeds in the whole batch");
+    if (args.containsOption("--first-seed"))
+        options.firstSeed = args.getValueForOption("--first-seed").getLargeIntValue();
+    options.monoFiles = args.containsOption("--mono");
+    if (args.containsOption("--threads"))
+        options.numThreads = args.getValueForOption("--threads").getIntValue();
+
+    // the batch window's defaults
+    auto& p = options.params;
+    p.lengthSeconds = 1.6;
+    p.masterGainDb = -1.5f;
+    p.subAmount = 0.6f;
+    p.boomAmount = 0.4f;
+    p.punch = 0.55f;
+    p.growl = 0.2f;
+    p.detune = 0.05f;
+    p.analog = 0.08f;
+    if (args.containsOption("--length"))
+        p.lengthSeconds = jlimit(0.05, 60.0, args.getValueForOption("--length").getDoubleValue());
+    if (args.containsOption("--auto-length"))
+    {
+        p.autoLength = true;
+        auto floorDb = args.getValueForOption("--auto-length");
+        if (floorDb.isNotEmpty())
+            p.silenceFloorDb = jlimit(-160.0f, -20.0f, floorDb.getFloatValue());
+    }
+
+    parseShard(args, options.shard, options.numShards);
+
+    std::cout << "Rendering " << options.count << " seeds from " << String((int64)options.firstSeed) << " -> "
+              << options.outputFolder.getFullPathName();
+    if (options.numShards > 1)
+        std::cout << " (shard " << options.shard << " of " << options.numShards << ")";
+    std::cout << std::endl;
+
+    const auto report = SeedBatch::run(options);
+    std::cout << report.summary() << std::endl;
+
+    // an empty shard still writes its manifest, so the merge knows it ran
+    if (options.numShards > 1)
+    {
+        String error;
+        if (!SeedBatch::writeShardManifest(options, report, error))
+            ConsoleApplication::fail(error);
+        std::cout << "Wrote " << FolderResynthesizer::getShardManifestFile(options.outputFolder, options.shard, options.numShards).getFullPathName()
+                  << std::endl;
+    }
+
+    if (report.numSucceeded < (int)report.items.size())
+        ConsoleApplication::fail(String((int)report.items.size() - report.numSucceeded) + " seed(s) failed");
+}
+
+void HeadlessCommands::mergeShards(const ArgumentList& args)
+{
+    args.checkMinNumArguments(2);
+
+    const auto outputFolder = args[1].resolveAsExistingFolder();
+    const auto packIndex = args.containsOption("--out") ? args.getFileForOption("--out") : File();
+
+    const int numShards = args.containsOption("--shards") ? args.getValueForOption("--shards").getIntValue() : 0;
+    if (numShards < 1)
+        ConsoleApplication::fail("--shards=N is required: the N of the run's --shard=i/N");
+
+    PackMergeReport report;
+    String error;
+    if (!FolderResynthesizer::mergeShardManifests(outputFolder, numShards, packIndex, report, error))
+        ConsoleApplication::fail(error);
+
+    std::cout << report.numShards << " shards, " << report.numItems << " items (" << report.numSucceeded << " rendered) -> "
+              << report.packIndex.getFullPathName() << std::endl;
+
+    if (report.numSucceeded < report.numItems)
+        ConsoleApplication::fail(String(report.numItems - report.numSucceeded) + " item(s) failed in their shard");
+}
+
+void HeadlessCommands::indexLibrary(const ArgumentList& args)
+{
+    args.checkMinNumArguments(2);
+
+    auto folder = args[1].resolveAsExistingFolder();
+    auto indexFile = args.containsOption("--index") ? args.getFileForOption("--index") : FeatureIndex::getDefaultIndexFile();
+    const int numThreads = args.containsOption("--threads") ? args.getValueForOption("--threads").getIntValue() : 0;
+
+    FeatureIndex index(indexFile);
+    std::cout << "Indexing " << folder.getFullPathName() << " into " << indexFile.getFullPathName()
+              << " (" << index.getNumRecords() << " records)" << std::endl;
+
+    auto stats = index.update(folder, true, numThreads, [](int done, int total)
+    {
+        if (done % 500 == 0 || done == total)
+            std::cout << "[" << done << "/" << total << "]" << std::endl;
+    });
+
+    std::cout << stats.toString() << std::endl
+              << index.getNumRecords() << " records in " << indexFile.getFullPathName() << std::endl;
+
+    if (stats.numFailed > 0)
+        ConsoleApplication::fail(String(stats.numFailed) + " file(s) could not be decoded");
+}
+
+void HeadlessCommands::findSimilar(const ArgumentList& args)
+{
+    args.checkMinNumArguments(2);
+
+    auto file = args[1].resolveAsExistingFile();
+    auto indexFile = args.containsOption("--index") ? args.getExistingFileForOption("--index") : FeatureIndex::getDefaultIndexFile();
+    const int k = args.containsOption("--k") ? jmax(1, args.getValueForOption("--k").getIntValue()) : 8;
+    const int numSeeds = args.containsOption("--seeds") ? jmax(0, args.getValueForOption("--seeds").getIntValue()) : 256;
+
+    FeatureIndex index(indexFile);
+
+    ResynthesisAnalysis analysis;
+    AudioFeatures query;
+    if (index.lookupFile(file, query))
+    {
+        analysis = FeatureIndex::toAnalysis(query);
+    }
+    else
+    {
+        AudioFormatManager formats;
+        formats.registerBasicFormats();
+
+        AudioBuffer<float> mono;
+        double sampleRate = 44100.0;
+        if (!ResynthesisAnalyzer::loadMono(formats, file, mono, sampleRate))
+            ConsoleApplication::fail("Could not decode " + file.getFullPathName());
+
+        ResynthesisAnalyzer analyzer;
+        analysis = analyzer.analyze(mono, sampleRate);
+        query = FeatureIndex::makeFeatures(0, analysis);
+    }
+
+    double t0 = Time::getMillisecondCounterHiRes();
+    auto library = SimilaritySearch::fromFeatureIndex(index);
+    double buildMs = Time::getMillisecondCounterHiRes() - t0;
+
+    auto results = SimilaritySearch::findSimilar(query, library, ResynthesisAnalyzer::makeParams(analysis, ResynthesisSettings(), 0), numSeeds, k);
+
+    std::cout << "Closest to " << file.getFileName() << " among " << library.size() << " indexed samples"
+              << " (search built in " << String(buildMs, 1) << " ms):" << std::endl
+              << results.describe(index) << std::endl;
+}
+
+void HeadlessCommands::benchSimilarity(const ArgumentList& args)
+{
+    const int numItems = args.containsOption("--items") ? jmax(1, args.getValueForOption("--items").getIntValue()) : 100000;
+    const int numQueries = args.containsOption("--queries") ? jmax(1, args.getValueForOption("--queries").getIntValue()) : 200;
+
+    // plausible-looking 808 features; fixed seed so runs are comparable
+    Random rng(808);
+    auto randomFeatures = [&rng](uint64_t id)
+    {
+        AudioFeatures f;
+        f.contentHash = id;
+        f.f0Hz = 30.0f + rng.nextFloat() * 90.0f;
+        f.attackSeconds = 0.001f + rng.nextFloat() * 0.05f;
+        f.releaseSeconds = 0.2f + rng.nextFloat() * 2.5f;
+        f.spectralCentroidHz = 60.0f + rng.nextFloat() * 800.0f;
+        f.rms = 0.05f + rng.nextFloat() * 0.4f;
+        f.peak = jmin(1.0f, f.rms * (1.5f + rng.nextFloat() * 3.0f));
+        f.lengthSeconds = 0.3f + rng.nextFloat() * 3.0f;
+        f.sampleRate = 44100.0f;
+        return f;
+    };
+
+    SimilaritySearch search;
+    search.reserve(numItems);
+    for (int i = 0; i < numItems; ++i)
+        search.add((uint64_t)i, SimilaritySearch::makeVector(randomFeatures((uint64_t)i)));
+
+    double t0 = Time::getMillisecondCounterHiRes();
+    search.build();
+    double buildMs = Time::getMillisecondCounterHiRes() - t0;
+
+    std::vector<AudioFeatures> queries;
+    for (int i = 0; i < numQueries; ++i)
+        queries.push_back(randomFeatures(0));
+
+    double worstMs = 0.0;
+    size_t numMatches = 0; // keeps the queries observable
+    t0 = Time::getMillisecondCounterHiRes();
+    for (auto& q : queries)
+    {
+        double q0 = Time::getMillisecondCounterHiRes();
+        auto matches = search.findNearest(q, 8);
+        worstMs = jmax(worstMs, Time::getMillisecondCounterHiRes() - q0);
+        numMatches += matches.size();
+    }
+    double averageMs = (Time::getMillisecondCounterHiRes() - t0) / numQueries;
+
+    std::cout << numItems << " items, build " << String(buildMs, 1) << " ms, "
+              << numQueries << " queries: average " << String(averageMs, 3) << " ms, worst " << String(worstMs, 3) << " ms ("
+              << numMatches << " matches)" << std::endl;
+
+    if (averageMs >= 10.0)
+        ConsoleApplication::fail("Average query time is over the 10 ms budget");
+}
+
+void HeadlessCommands::meterPreview(const ArgumentList& args)
+{
+    const double sampleRate = 44100.0;
+    const int blockSize = args.containsOption("--block") ? jlimit(16, 8192, args.getValueForOption("--block").getIntValue()) : 512;
+
+    GeneratorParams params;
+    params.sampleRate = sampleRate;
+    params.seed = args.containsOption("--seed") ? args.getValueForOption("--seed").getLargeIntValue() : 808;
+    params.engineVersion = GeneratorParams::latestEngineVersion;
+
+    PluginProcessor processor;
+    processor.prepareToPlay(sampleRate, blockSize);
+    if (!processor.generate808AndStore(params))
+        ConsoleApplication::fail("Generation failed");
+
+    processor.startPreview();
+
+    auto& meter = processor.getOutputMeter();
+    AudioBuffer<float> block(2, blockSize);
+    MidiBuffer midi;
+
+    const int samplesPerRead = (int)(sampleRate / 30.0);
+    int sinceRead = 0;
+    int64 processed = 0;
+    float maxPeak = 0.0f, maxRms = 0.0f, peakHz = 0.0f;
+
+    auto readMeter = [&]()
+    {
+        if (!meter.update())
+            return;
+
+        const auto& levels = meter.getLevels();
+        for (int ch = 0; ch < levels.numChannels; ++ch)
+        {
+            if (!std::isfinite(levels.peak[ch]) || !std::isfinite(levels.rms[ch]))
+                ConsoleApplication::fail("Meter read NaN/inf at sample " + String(processed));
+
+            maxPeak = jmax(maxPeak, levels.peak[ch]);
+            if (levels.rms[ch] > maxRms)
+            {
+                maxRms = levels.rms[ch];
+                peakHz = meter.getSpectrumPeakHz();
+            }
+        }
+
+        std::cout << String(processed / sampleRate, 3) << " s  peak " << String(Decibels::gainToDecibels(levels.peak[0]), 1)
+                  << " dB  rms " << String(Decibels::gainToDecibels(levels.rms[0]), 1) << " dB  spectrum peak "
+                  << String(meter.getSpectrumPeakHz(), 1) << " Hz" << std::endl;
+    };
+
+    // 10 s cap in case preview never stops
+    while (processor.isPreviewing() && processed < (int64)(sampleRate * 10.0))
+    {
+        processor.processBlock(block, midi);
+        processed += blockSize;
+        sinceRead += blockSize;
+
+        if (sinceRead >= samplesPerRead)
+        {
+            readMeter();
+            sinceRead = 0;
+        }
+    }
+    readMeter();
+
+    const auto& levels = meter.getLevels();
+    std::cout << "Max peak " << String(Decibels::gainToDecibels(maxPeak), 2) << " dBFS, max RMS "
+              << String(Decibels::gainToDecibels(maxRms), 2) << " dBFS (spectrum peak " << String(peakHz, 1)
+              << " Hz), " << levels.samplesRead << " samples metered, " << levels.samplesDropped << " dropped" << std::endl;
+
+    if (maxRms <= 0.0f)
+        ConsoleApplication::fail("Preview output was silent");
+    if (maxPeak > 1.0f)
+        ConsoleApplication::fail("Preview output clipped");
+    if (levels.samplesDropped > 0)
+        ConsoleApplication::fail("Meter FIFO dropped samples");
+}
+
+void HeadlessCommands::sweep(const ArgumentList& args)
+{
+    auto parseList = [&args](const String& option, const String& fallback)
+    {
+        Array<float> values;
+        auto text = args.containsOption(option) ? args.getValueForOption(option) : fallback;
+        for (auto& token : StringArray::fromTokens(text, ",", ""))
+            if (token.trim().isNotEmpty())
+                values.add(token.trim().getFloatValue());
+        return values;
+    };
+
+    const int numSeeds = args.containsOption("--seeds") ? jmax(1, args.getValueForOption("--seeds").getIntValue()) : 4;
+    const auto detunes = parseList("--detunes", "0,0.25,0.5,0.75,1");
+    const auto gains = parseList("--gains", "-6,-3,0,3");
+    const File outFolder = args.containsOption("--out") ? args.getFileForOption("--out") : File();
+
+    if (outFolder != File() && outFolder.createDirectory().failed())
+        ConsoleApplication::fail("Could not create " + outFolder.getFullPathName());
+
+    StagedGenerator staged;
+    Generator808 plain;
+    double stagedMs = 0.0, plainMs = 0.0;
+    int numRenders = 0;
+
+    // seed outermost, cheapest stage innermost: the order that lets the cache work
+    for (int seedIndex = 0; seedIndex < numSeeds; ++seedIndex)
+    {
+        for (float detune : detunes)
+        {
+            for (float gainDb : gains)
+            {
+                GeneratorParams p;
+                p.seed = 808 + seedIndex;
+                p.engineVersion = GeneratorParams::latestEngineVersion;
+                p.detune = detune;
+                p.masterGainDb = gainDb;
+
+                double t0 = Time::getMillisecondCounterHiRes();
+                auto buf = staged.renderToBuffer(p);
+                double t1 = Time::getMillisecondCounterHiRes();
+                auto reference = plain.renderToBuffer(p);
+                double t2 = Time::getMillisecondCounterHiRes();
+
+                stagedMs += t1 - t0;
+                plainMs += t2 - t1;
+                ++numRenders;
+
+                for (int ch = 0; ch < reference.getNumChannels(); ++ch)
+                    if (std::memcmp(buf.getReadPointer(ch), reference.getReadPointer(ch), sizeof(float) * (size_t)reference.getNumSamples()) != 0)
+                        ConsoleApplication::fail("Staged render differs from Generator808 for seed " + String(p.seed)
+                                                 + ", detune " + String(detune) + ", gain " + String(gainDb));
+
+                if (outFolder != File())
+                {
+                    auto file = outFolder.getChildFile(String(p.seed) + "_d" + String(detune, 2) + "_g" + String(gainDb, 1) + ".wav");
+                    if (!WavExporter::saveBufferToWav(buf, p.sampleRate, file, 24))
+                        ConsoleApplication::fail("Could not write " + file.getFullPathName());
+                }
+            }
+        }
+    }
+
+    std::cout << numRenders << " renders: staged " << String(stagedMs, 1) << " ms, plain " << String(plainMs, 1)
+              << " ms (" << String(plainMs / jmax(0.001, stagedMs), 2) << "x)" << std::endl
+              << staged.getStats().toString() << std::endl;
+}
+
+void HeadlessCommands::benchBatch(const ArgumentList& args)
+{
+    const int numVoices = args.containsOption("--voices") ? jmax(1, args.getValueForOption("--voices").getIntValue()) : 64;
+    const int lanes = args.containsOption("--lanes") ? args.getValueForOption("--lanes").getIntValue() : BatchRender808::getNativeLanes();
+
+    if (lanes != 4 && lanes != 8 && lanes != 16)
+        ConsoleApplication::fail("--lanes must be 4, 8 or 16");
+
+    // every param varies per voice, lengths and sample rates included, so the lane masks get exercised
+    Random rng(808);
+    std::vector<GeneratorParams> voices((size_t)numVoices);
+    for (auto& p : voices)
+    {
+        p.seed = rng.nextInt64();
+        p.engineVersion = GeneratorParams::latestEngineVersion; // older versions don't take the SIMD path
+        p.sampleRate = rng.nextBool() ? 44100.0 : 48000.0;
+        p.lengthSeconds = 0.5 + 1.5 * rng.nextDouble();
+        p.tuneSemitones = (float)(rng.nextInt(25) - 12);
+        p.subAmount = rng.nextFloat();
+        p.boomAmount = rng.nextFloat();
+        p.punch = rng.nextFloat();
+        p.shortness = rng.nextFloat();
+        p.growl = rng.nextBool() ? rng.nextFloat() : 0.0f;
+        p.analog = rng.nextBool() ? rng.nextFloat() : 0.0f;
+        p.detune = rng.nextBool() ? rng.nextFloat() : 0.0f;
+        p.masterGainDb = -6.0f + 6.0f * rng.nextFloat();
+    }
+
+    double t0 = Time::getMillisecondCounterHiRes();
+    auto batch = BatchRender808::renderAll(voices, lanes);
+    double t1 = Time::getMillisecondCounterHiRes();
+
+    Generator808 scalar;
+    std::vector<AudioBuffer<float>> reference;
+    reference.reserve(voices.size());
+    for (auto& p : voices)
+        reference.push_back(scalar.renderToBuffer(p));
+    double t2 = Time::getMillisecondCounterHiRes();
+
+    float maxDiff = 0.0f;
+    int numExact = 0;
+    for (size_t v = 0; v < voices.size(); ++v)
+    {
+        if (batch[v].getNumSamples() != reference[v].getNumSamples() || batch[v].getNumChannels() != reference[v].getNumChannels())
+            ConsoleApplication::fail("Voice " + String((int)v) + " has a different length than the scalar render");
+
+        float voiceDiff = 0.0f;
+        for (int ch = 0; ch < reference[v].getNumChannels(); ++ch)
+        {
+            const float* a = batch[v].getReadPointer(ch);
+            const float* b = reference[v].getReadPointer(ch);
+            for (int i = 0; i < reference[v].getNumSamples(); ++i)
+                voiceDiff = jmax(voiceDiff, std::abs(a[i] - b[i]));
+        }
+
+        maxDiff = jmax(maxDiff, voiceDiff);
+        if (voiceDiff == 0.0f)
+            ++numExact;
+    }
+
+    const double batchMs = t1 - t0, scalarMs = t2 - t1;
+    std::cout << numVoices << " voices, " << lanes << " lanes" << std::endl
+              << "  batch  " << String(batchMs, 1) << " ms (" << String(numVoices * 1000.0 / jmax(0.001, batchMs), 1) << " voices/s)" << std::endl
+              << "  scalar " << String(scalarMs, 1) << " ms (" << String(numVoices * 1000.0 / jmax(0.001, scalarMs), 1) << " voices/s)" << std::endl
+              << "  " << String(scalarMs / jmax(0.001, batchMs), 2) << "x, " << numExact << "/" << numVoices
+              << " bit-exact, max diff " << maxDiff << std::endl;
+
+    if (maxDiff > 1.0e-4f)
+        ConsoleApplication::fail("Batch render differs from Generator808 by " + String(maxDiff));
+}
+
+void HeadlessCommands::benchMath(const ArgumentList& args)
+{
+    const int numSamples = args.containsOption("--samples") ? jmax(16, args.getValueForOption("--samples").getIntValue()) : 1 << 20;
+
+    using BlockFunction = void (*)(const float*, float*, int, FastMath::Accuracy);
+
+    struct Case
+    {
+        const char* name;
+        float low, high;
+        bool logSpaced, relative;
+        double (*reference)(double);
+        float (*libm)(float);
+        BlockFunction fast;
+        double bound[2]; // draft, final (the ones in FastMath.h)
+    };
+
+    const Case cases[] =
+    {
+        { "sin", -1.0e4f, 1.0e4f, false, false, [](double x) { return std::sin(x); }, [](float x) { return std::sin(x); },
+          [](const float* s, float* d, int n, FastMath::Accuracy a) { FastMath::sin(s, d, n, a); }, { 2.0e-4, 5.0e-7 } },
+        { "exp", -20.0f, 20.0f, false, true, [](double x) { return std::exp(x); }, [](float x) { return std::exp(x); },
+          [](const float* s, float* d, int n, FastMath::Accuracy a) { FastMath::exp(s, d, n, a); }, { 1.5e-4, 2.0e-6 } },
+        { "exp2", -126.0f, 126.0f, false, true, [](double x) { return std::exp2(x); }, [](float x) { return std::exp2(x); },
+          [](const float* s, float* d, int n, FastMath::Accuracy a) { FastMath::exp2(s, d, n, a); }, { 1.5e-4, 3.0e-7 } },
+        { "tanh", -12.0f, 12.0f, false, false, [](double x) { return std::tanh(x); }, [](float x) { return std::tanh(x); },
+          [](const float* s, float* d, int n, FastMath::Accuracy a) { FastMath::tanh(s, d, n, a); }, { 1.0e-4, 3.0e-7 } },
+        { "log2", -120.0f, 120.0f, true, false, [](double x) { return std::log2(x); }, [](float x) { return std::log2(x); },
+          [](const float* s, float* d, int n, FastMath::Accuracy a) { FastMath::log2(s, d, n, a); }, { 1.5e-4, 3.0e-7 } },
+    };
+
+    std::vector<float> input((size_t)numSamples), output((size_t)numSamples);
+
+    // best of a few passes, in ns per sample
+    auto timeIt = [numSamples](auto&& fn)
+    {
+        double best = 1.0e30;
+        for (int pass = 0; pass < 5; ++pass)
+        {
+            double t0 = Time::getMillisecondCounterHiRes();
+            fn();
+            best = jmin(best, Time::getMillisecondCounterHiRes() - t0);
+        }
+        return best * 1.0e6 / numSamples;
+    };
+
+    std::cout << "function  tier    max error  bound      ns/sample  libm ns  speedup" << std::endl;
+
+    bool failed = false;
+    for (auto& c : cases)
+    {
+        // log2 is sampled over exponents, so every binade gets the same number of points
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const float x = c.low + (c.high - c.low) * (float)i / (float)(numSamples - 1);
+            input[(size_t)i] = c.logSpaced ? std::exp2(x) : x;
+        }
+
+        const double libmNs = timeIt([&] { for (int i = 0; i < numSamples; ++i) output[(size_t)i] = c.libm(input[(size_t)i]); });
+
+        for (auto accuracy : { FastMath::draftAccuracy, FastMath::finalAccuracy })
+        {
+            const double fastNs = timeIt([&] { c.fast(input.data(), output.data(), numSamples, accuracy); });
+
+            double maxError = 0.0;
+            for (int i = 0; i < numSamples; ++i)
+            {
+                const double expected = c.reference((double)input[(size_t)i]);
+                const double error = std::abs((double)output[(size_t)i] - expected);
+                maxError = jmax(maxError, c.relative ? error / std::abs(expected) : error);
+            }
+
+            const double bound = c.bound[accuracy == FastMath::draftAccuracy ? 0 : 1];
+            failed = failed || !(maxError <= bound);
+
+            std::cout << String(c.name).paddedRight(' ', 10)
+                      << String(accuracy == FastMath::draftAccuracy ? "draft" : "final").paddedRight(' ', 8)
+                      << String::formatted("%-11.3g%-11.3g%-11.2f%-9.2f%.1fx", maxError, bound, fastNs, libmNs, libmNs / jmax(1.0e-6, fastNs))
+                      << (maxError <= bound ? "" : "  OVER BOUND") << std::endl;
+        }
+    }
+
+    if (failed)
+        ConsoleApplication::fail("FastMath error above its documented bound");
+}
+
+void HeadlessCommands::benchRender(const ArgumentList& args)
+{
+    const double seconds = args.containsOption("--seconds") ? jmax(0.01, args.getValueForOption("--seconds").getDoubleValue()) : 5.0;
+    const double rate = args.containsOption("--rate") ? jmax(8000.0, args.getValueForOption("--rate").getDoubleValue()) : 96000.0;
+    const int numRenders = args.containsOption("--renders") ? jmax(1, args.getValueForOption("--renders").getIntValue()) : 8;
+
+    Generator808 generator;
+    double fusedMs = 0.0, stagedMs = 0.0;
+    int numSamples = 0;
+
+    for (int r = 0; r < numRenders; ++r)
+    {
+        GeneratorParams p;
+        p.seed = 808 + r;
+        p.engineVersion = GeneratorParams::latestEngineVersion;
+        p.sampleRate = rate;
+        p.lengthSeconds = seconds;
+        p.growl = 0.3f;
+        p.analog = 0.2f;
+        p.subAmount = 0.5f;
+        p.detune = 0.5f;
+        p.masterGainDb = -1.0f;
+        numSamples = (int)std::lround(seconds * rate);
+
+        double t0 = Time::getMillisecondCounterHiRes();
+        auto fused = generator.renderToBuffer(p);
+        double t1 = Time::getMillisecondCounterHiRes();
+
+        // what render() used to do: every stage over the full length before the next one starts
+        AudioBuffer<float> mono(1, numSamples), staged(2, numSamples);
+        generator.renderOscillatorStage(p, mono);
+        generator.renderFilterStage(p, mono);
+        generator.renderWidthStage(p, mono, staged);
+        generator.renderOutputStage(p, staged);
+        double t2 = Time::getMillisecondCounterHiRes();
+
+        fusedMs += t1 - t0;
+        stagedMs += t2 - t1;
+
+        for (int ch = 0; ch < 2; ++ch)
+            if (std::memcmp(fused.getReadPointer(ch), staged.getReadPointer(ch), sizeof(float) * (size_t)numSamples) != 0)
+                ConsoleApplication::fail("Fused render differs from the staged render for seed " + String(p.seed));
+    }
+
+    // floats read + written per sample in full-length buffers: staged = clears, oscillator, lowpass,
+    // shelf, saturation, stereo copy, width, gain, soft clip (27); fused only writes the output (2),
+    // its mono look-ahead ring stays in L1
+    const double mbPerFloat = (double)numSamples * sizeof(float) / (1024.0 * 1024.0);
+
+    std::cout << numRenders << " renders of " << String(seconds, 2) << " s at " << String(rate, 0) << " Hz ("
+              << numSamples << " samples), bit-identical" << std::endl
+              << "  fused   " << String(fusedMs / numRenders, 2) << " ms/render, ~" << String(2.0 * mbPerFloat, 1) << " MB buffer traffic" << std::endl
+              << "  staged  " << String(stagedMs / numRenders, 2) << " ms/render, ~" << String(27.0 * mbPerFloat, 1) << " MB buffer traffic" << std::endl;
+}
+
+void HeadlessCommands::benchOversampling(const ArgumentList& args)
+{
+    const double rate = args.containsOption("--rate") ? jmax(8000.0, args.getValueForOption("--rate").getDoubleValue()) : 44100.0;
+    const int numRenders = args.containsOption("--renders") ? jmax(1, args.getValueForOption("--renders").getIntValue()) : 8;
+
+    // an odd number of cycles per FFT frame puts every harmonic on its own bin (no window needed)
+    // and the aliased ones, which fold back off the harmonic grid, in between
+    constexpr int fftOrder = 16, fftSize = 1 << fftOrder;
+    const int toneBin = roundToInt(4000.0 * fftSize / rate) | 1;
+    const int lastBin = jmin(fftSize / 2 - 1, (int)(20000.0 * fftSize / rate));
+
+    dsp::FFT fft(fftOrder);
+    std::vector<float> tone((size_t)(3 * fftSize)), clipped(tone.size()), spectrum((size_t)(2 * fftSize));
+    for (size_t i = 0; i < tone.size(); ++i)
+        tone[i] = 2.0f * (float)std::sin(MathConstants<double>::twoPi * toneBin * (double)i / fftSize);
+
+    std::cout << "Soft clip of a " << String(toneBin * rate / fftSize, 0) << " Hz sine at 6 dBFS, aliasing below 20 kHz:" << std::endl;
+
+    double aliasDb[3] = {};
+    const int factors[] = { 1, 2, 4 };
+    for (int f = 0; f < 3; ++f)
+    {
+        Oversampler oversampler;
+        oversampler.setFactor(factors[f]);
+
+        auto softClip = [](float x) { return std::tanh(x * 1.2f); };
+        const int ready = oversampler.process(tone.data(), clipped.data(), (int)tone.size(), softClip);
+        oversampler.flush(clipped.data() + ready, softClip);
+
+        // the middle frame, well clear of the filters' start and end
+        std::fill(spectrum.begin(), spectrum.end(), 0.0f);
+        std::copy(clipped.begin() + fftSize, clipped.begin() + 2 * fftSize, spectrum.begin());
+        fft.performFrequencyOnlyForwardTransform(spectrum.data(), true);
+
+        double harmonics = 0.0, aliases = 0.0;
+        for (int bin = 1; bin <= lastBin; ++bin)
+            (bin % toneBin == 0 ? harmonics : aliases) += (double)spectrum[(size_t)bin] * spectrum[(size_t)bin];
+
+        aliasDb[f] = 10.0 * std::log10(jmax(1.0e-30, aliases) / jmax(1.0e-30, harmonics));
+        std::cout << "  " << factors[f] << "x  " << String(aliasDb[f], 1) << " dB"
+                  << (factors[f] > 1 ? "  (latency " + String(oversampler.getLatency()) + " samples, compensated)" : String()) << std::endl;
+    }
+
+    // what it costs: oversampling only the nonlinearities against running the whole render at 4x the rate
+    auto timeRenders = [numRenders](double sampleRate, int oversampling)
+    {
+        Generator808 generator;
+        double total = 0.0;
+        for (int r = 0; r < numRenders; ++r)
+        {
+            GeneratorParams p;
+            p.seed = 808 + r;
+            p.engineVersion = GeneratorParams::latestEngineVersion;
+            p.sampleRate = sampleRate;
+            p.lengthSeconds = 2.0;
+            p.growl = 1.0f;
+            p.analog = 1.0f;
+            p.detune = 0.5f;
+            p.masterGainDb = 6.0f;
+            p.oversampling = oversampling;
+
+            double t0 = Time::getMillisecondCounterHiRes();
+            generator.renderToBuffer(p);
+            total += Time::getMillisecondCounterHiRes() - t0;
+        }
+        return total / numRenders;
+    };
+
+    const double baseMs = timeRenders(rate, 1);
+    std::cout << numRenders << " renders of 2 s:" << std::endl
+              << "  " << String(rate, 0) << " Hz          " << String(baseMs, 2) << " ms/render" << std::endl;
+    for (int factor : { 2, 4 })
+    {
+        const double ms = timeRenders(rate, factor);
+        std::cout << "  " << String(rate, 0) << " Hz, " << factor << "x     " << String(ms, 2) << " ms/render ("
+                  << String(ms / jmax(0.001, baseMs), 2) << "x)" << std::endl;
+    }
+    const double highRateMs = timeRenders(4.0 * rate, 1);
+    std::cout << "  " << String(4.0 * rate, 0) << " Hz         " << String(highRateMs, 2) << " ms/render ("
+              << String(highRateMs / jmax(0.001, baseMs), 2) << "x, before any downsampling)" << std::endl;
+
+    if (aliasDb[1] > aliasDb[0] - 40.0 || aliasDb[2] > aliasDb[0] - 40.0)
+        ConsoleApplication::fail("Oversampling removed less aliasing than expected");
+}
+
+void HeadlessCommands::checkAllocations(const ArgumentList& args)
+{
+    if (!AllocationCounter::isAvailable())
+        ConsoleApplication::fail("Allocation counting is unavailable: this build has ORADE808_TEST_HOOKS=0");
+
+    const int numRounds = args.containsOption("--rounds") ? jmax(1, args.getValueForOption("--rounds").getIntValue()) : 20;
+    constexpr int numWarmUpRounds = 2;
+
+    // one edit per setting: mono, stereo, both oversampling factors, auto length with a long maximum
+    std::vector<GeneratorParams> edits(5);
+    for (size_t i = 0; i < edits.size(); ++i)
+    {
+        auto& p = edits[i];
+        p.engineVersion = GeneratorParams::latestEngineVersion;
+        p.subAmount = 0.6f;
+        p.boomAmount = 0.4f;
+        p.punch = 0.55f;
+        p.growl = 0.3f;
+        p.analog = 0.2f;
+        p.detune = i == 0 ? 0.0f : 0.4f;
+        p.oversampling = i == 2 ? 2 : (i == 3 ? 4 : 1);
+        p.autoLength = i == 4;
+        p.shortness = i == 4 ? 0.9f : 0.0f;
+        p.lengthSeconds = i == 4 ? 6.0 : 1.5;
+    }
+
+    std::vector<GeneratorParams> batchVoices(16);
+    for (size_t v = 0; v < batchVoices.size(); ++v)
+    {
+        auto& p = batchVoices[v];
+        p.engineVersion = GeneratorParams::latestEngineVersion;
+        p.lengthSeconds = 0.8 + 0.1 * (double)(v % 8);
+        p.sampleRate = v % 2 == 0 ? 44100.0 : 48000.0;
+        p.detune = v % 3 == 0 ? 0.0f : 0.3f;
+        p.growl = 0.2f;
+        p.oversampling = v == 5 ? 2 : 1;  // goes through the scalar generator
+    }
+
+    // like the editor (the processor publishing full renders + a draft context) and the batch
+    // window (its own context)
+    PluginProcessor processor;
+    RenderContext draftContext, batchContext;
+    RenderContext::BufferPtr draft;
+    std::vector<RenderContext::BufferPtr> batch;
+
+    auto runRound = [&](int round)
+    {
+        for (auto& p : edits)
+        {
+            p.seed = 808 + round;
+            draft = draftContext.renderDraft(p);
+            if (!processor.generate808AndStore(p))
+                ConsoleApplication::fail("Generation failed");
+        }
+
+        for (auto& p : batchVoices)
+            p.seed += 1;
+        batchContext.renderAll(batchVoices, batch);
+    };
+
+    // where each result's storage lives (an AudioBuffer's channel list heads its allocation)
+    auto storageOf = [](const RenderContext::BufferPtr& b) { return (const void*)b->getArrayOfReadPointers(); };
+    std::vector<const void*> warmStorage, steadyStorage;
+    auto noteStorage = [&](std::vector<const void*>& list)
+    {
+        list.push_back(storageOf(processor.getGeneratedBufferSharedPtr()));
+        list.push_back(storageOf(draft));
+        for (auto& b : batch)
+            list.push_back(storageOf(b));
+    };
+
+    for (int round = 0; round < numWarmUpRounds; ++round)
+    {
+        runRound(round);
+        noteStorage(warmStorage);
+    }
+
+    int64 steadyAllocations = 0;
+    double ms = 0.0;
+    for (int round = 0; round < numRounds; ++round)
+    {
+        const double t0 = Time::getMillisecondCounterHiRes();
+        {
+            AllocationCounter counter;
+            runRound(numWarmUpRounds + round);
+            steadyAllocations += counter.getCount();
+        }
+        ms += Time::getMillisecondCounterHiRes() - t0;
+        noteStorage(steadyStorage);
+    }
+
+    int numNewBuffers = 0;
+    for (auto* s : steadyStorage)
+        if (std::find(warmStorage.begin(), warmStorage.end(), s) == warmStorage.end())
+            ++numNewBuffers;
+
+    // the pooled result has to be exactly what a plain render gives
+    const auto reference = Generator808().renderToBuffer(edits[2]);
+    processor.generate808AndStore(edits[2]);
+    const auto pooled = processor.getGeneratedBufferSharedPtr();
+    for (int ch = 0; ch < reference.getNumChannels(); ++ch)
+        if (pooled->getNumSamples() != reference.getNumSamples()
+            || std::memcmp(pooled->getReadPointer(ch), reference.getReadPointer(ch), sizeof(float) * (size_t)reference.getNumSamples()) != 0)
+            ConsoleApplication::fail("Published output differs from Generator808::renderToBuffer");
+
+    // what a render cost before: a fresh generator per worker, a new buffer, a new shared_ptr
+    int64 plainAllocations = 0;
+    for (auto& p : edits)
+    {
+        AllocationCounter counter;
+        Generator808 generator;
+        auto buffer = std::make_shared<AudioBuffer<float>>(generator.renderToBuffer(p));
+        plainAllocations += counter.getCount();
+    }
+
+    const int rendersPerRound = 2 * (int)edits.size() + (int)batchVoices.size();
+    std::cout << numRounds << " rounds of " << rendersPerRound << " renders (" << (int)edits.size() << " edits as draft + full, "
+              << (int)batchVoices.size() << " batch voices), " << String(ms / numRounds, 1) << " ms/round" << std::endl
+              << "  pooled:         " << steadyAllocations << " operator new calls, " << numNewBuffers
+              << " results outside the warmed-up buffers" << std::endl
+              << "  renderToBuffer: " << String((double)plainAllocations / (double)edits.size(), 1)
+              << " operator new calls per render, plus the malloc of its buffer" << std::endl;
+
+    if (steadyAllocations > 0 || numNewBuffers > 0)
+        ConsoleApplication::fail("Warmed-up renders or publishes allocated");
+}
+
+void HeadlessCommands::stressThreads(const ArgumentList& args)
+{
+    const int numThreads = ParallelJobs::resolveThreadCount(args.containsOption("--threads") ? args.getValueForOption("--threads").getIntValue() : 0);
+    const int numRounds = args.containsOption("--rounds") ? jmax(1, args.getValueForOption("--rounds").getIntValue()) : 4;
+
+    // one shared, read-only list of settings; every fourth voice is rendered as a draft
+    std::vector<GeneratorParams> settings(24);
+    for (size_t v = 0; v < settings.size(); ++v)
+    {
+        auto& p = settings[v];
+        p.seed = 4100 + (int64_t)v * 37;
+        p.engineVersion = GeneratorParams::latestEngineVersion;
+        p.sampleRate = v % 3 == 0 ? 48000.0 : 44100.0;
+        p.lengthSeconds = 0.6 + 0.1 * (double)(v % 5);
+        p.subAmount = 0.1f * (float)(v % 4);
+        p.punch = 0.5f;
+        p.growl = v % 2 == 0 ? 0.0f : 0.35f;
+        p.analog = 0.3f;
+        p.detune = v % 3 == 1 ? 0.0f : 0.4f;
+        p.oversampling = v % 6 == 2 ? 2 : (v % 6 == 5 ? 4 : 1);
+        p.autoLength = v % 5 == 4;
+        p.shortness = p.autoLength ? 0.9f : 0.2f;
+    }
+    const auto& voices = settings;
+    auto isDraft = [](size_t v) { return v % 4 == 3; };
+
+    auto renderVoice = [&](size_t v, Generator808::State& state, AudioBuffer<float>& out)
+    {
+        if (isDraft(v))
+        {
+            Generator808::renderDraft(voices[v], state, out);
+            return;
+        }
+
+        out.setSize(Generator808::getNumOutputChannels(voices[v]),
+                    (int)std::lround(voices[v].lengthSeconds * voices[v].sampleRate), false, false, true);
+        Generator808::render(voices[v], state, out);
+    };
+
+    std::vector<AudioBuffer<float>> reference(voices.size());
+    {
+        Generator808::State state;
+        for (size_t v = 0; v < voices.size(); ++v)
+            renderVoice(v, state, reference[v]);
+    }
+
+    std::atomic<int> numRenders{ 0 }, numMismatches{ 0 };
+    const double t0 = Time::getMillisecondCounterHiRes();
+
+    ParallelJobs::run(numThreads, numThreads, [&](int thread)
+    {
+        // each thread walks the list from its own starting point, so different settings overlap
+        Generator808::State state;
+        AudioBuffer<float> out;
+        for (int round = 0; round < numRounds; ++round)
+        {
+            for (size_t i = 0; i < voices.size(); ++i)
+            {
+                const size_t v = (i + (size_t)thread * 5) % voices.size();
+                renderVoice(v, state, out);
+
+                const auto& expected = reference[v];
+                bool same = out.getNumChannels() == expected.getNumChannels() && out.getNumSamples() == expected.getNumSamples();
+                for (int ch = 0; same && ch < expected.getNumChannels(); ++ch)
+                    same = std::memcmp(out.getReadPointer(ch), expected.getReadPointer(ch),
+                                       sizeof(float) * (size_t)expected.getNumSamples()) == 0;
+
+                if (!same)
+                    ++numMismatches;
+                ++numRenders;
+            }
+        }
+    });
+
+    const double ms = Time::getMillisecondCounterHiRes() - t0;
+    std::cout << numRenders.load() << " renders of " << (int)voices.size() << " shared settings on " << numThreads
+              << " threads in " << String(ms, 1) << " ms, " << numMismatches.load() << " differ from the single-threaded render"
+              << std::endl;
+
+    if (numMismatches > 0)
+        ConsoleApplication::fail("Concurrent renders differ from the single-threaded render");
+}
+
+void HeadlessCommands::checkEngines(const ArgumentList& args)
+{
+    args.checkMinNumArguments(2);
+    const File file = args[1].resolveAsFile();
+    const bool update = args.containsOption("--update");
+
+    const auto entries = EngineGolden::computeEntries();
+    const auto fingerprint = EngineGolden::getLibmFingerprint();
+
+    for (const auto& engine : Generator808::getEngineVersions())
+        std::cout << "v" << engine.number << ": " << engine.description << std::endl;
+
+    // a case that no longer tests what it's for fails, with --update too
+    int numBroken = 0;
+    for (const auto& e : entries)
+    {
+        if (e.error.isNotEmpty())
+        {
+            ++numBroken;
+            std::cout << "  " << e.name << " " << e.error << std::endl;
+        }
+    }
+    if (numBroken > 0)
+        ConsoleApplication::fail(String(numBroken) + " golden cases don't test what they are for");
+
+    if (update)
+    {
+        StringArray lines;
+        lines.add("# Golden output of every engine version, checked by --check-engines (see EngineGolden.h).");
+        lines.add("# Rewrite it with --update on the reference platform only when adding a version: a changed");
+        lines.add("# line means a change altered the sound of a version that has shipped.");
+        lines.add("# reference platform: " + SystemStats::getOperatingSystemName());
+        lines.add("libm " + fingerprint);
+        for (const auto& e : entries)
+            lines.add(e.name + " " + e.value);
+
+        if (file.getParentDirectory().createDirectory().failed() || !file.replaceWithText(lines.joinIntoString("\n") + "\n", false, false, "\n"))
+            ConsoleApplication::fail("Could not write " + file.getFullPathName());
+
+        std::cout << (int)entries.size() << " entries written to " << file.getFullPathName() << std::endl;
+        return;
+    }
+
+    if (!file.existsAsFile())
+        ConsoleApplication::fail(file.getFullPathName() + " doesn't exist (the repo's is Golden/engines.txt)");
+
+    // name -> value; "libm" is the reference platform's fingerprint
+    std::map<String, String> golden;
+    for (auto line : StringArray::fromLines(file.loadFileAsString()))
+    {
+        line = line.trim();
+        if (line.isNotEmpty() && !line.startsWithChar('#'))
+            golden[line.upToFirstOccurrenceOf(" ", false, false)] = line.fromFirstOccurrenceOf(" ", false, false).trim();
+    }
+
+    const String referenceLibm = golden.count("libm") > 0 ? golden["libm"] : String();
+    const bool sameLibm = referenceLibm == fingerprint;
+    int numChecked = 0, numSkipped = 0, numMissing = 0, numMismatches = 0;
+
+    for (const auto& e : entries)
+    {
+        const auto it = golden.find(e.name);
+        if (it == golden.end())
+        {
+            ++numMissing;
+            std::cout << "  " << e.name << " has no golden entry" << std::endl;
+            continue;
+        }
+
+        if (!e.portable && !sameLibm)
+        {
+            ++numSkipped;
+            continue;
+        }
+
+        ++numChecked;
+        if (it->second != e.value)
+        {
+            ++numMismatches;
+            std::cout << "  " << e.name << " is " << e.value << ", golden " << it->second << std::endl;
+        }
+    }
+
+    std::cout << numChecked << " entries checked against " << file.getFullPathName() << ", " << numMismatches << " differ, "
+              << numMissing << " missing" << std::endl;
+    if (numSkipped > 0)
+        std::cout << numSkipped << " render entries skipped: this platform's libm (" << fingerprint << ") isn't the reference's ("
+                  << referenceLibm << "), so only the portable entries were checked" << std::endl;
+
+    if (numMismatches > 0)
+        ConsoleApplication::fail("Engine output changed for a version that has shipped");
+    if (numMissing > 0)
+        ConsoleApplication::fail(String(numMissing) + " entries are missing: add a new version's with --update on the reference platform");
+}
+
+void HeadlessCommands::fuzzRender(const ArgumentList& args)
+{
+    const int numCases = args.containsOption("--cases") ? jmax(1, args.getValueForOption("--cases").getIntValue()) : 500;
+    const int64 fuzzSeed = args.containsOption("--seed") ? args.getValueForOption("--seed").getLargeIntValue() : 808;
+    const int numTop = args.containsOption("--top") ? jmax(0, args.getValueForOption("--top").getIntValue()) : 10;
+    const double slowdown = args.containsOption("--slowdown") ? jmax(1.5, args.getValueForOption("--slowdown").getDoubleValue()) : 3.0;
+    const File reportFile = args.containsOption("--report") ? args.getFileForOption("--report") : File();
+    constexpr int minTimedSamples = 8192;  // shorter renders are dominated by setup, not by per-sample cost
+
+    struct FuzzCase
+    {
+        GeneratorParams params;
+        int numSamples = 0;
+        double ms = 0.0, nsPerSample = 0.0, realTimeFactor = 0.0;
+        int numNonFinite = 0, numDenormal = 0, numClipped = 0;
+        bool slow = false;
+    };
+
+    // amounts favour the ends of their range, where the maths is most likely to misbehave
+    Random rng(fuzzSeed);
+    auto amount = [&rng]
+    {
+        const float r = rng.nextFloat();
+        return r < 0.15f ? 0.0f : (r < 0.3f ? 1.0f : rng.nextFloat());
+    };
+
+    const double sampleRates[] = { 8000.0, 22050.0, 44100.0, 48000.0, 88200.0, 96000.0, 192000.0 };
+    const int oversamplingFactors[] = { 1, 2, 4 };
+    const auto& engines = Generator808::getEngineVersions();
+
+    std::vector<FuzzCase> cases((size_t)numCases);
+    for (auto& c : cases)
+    {
+        auto& p = c.params;
+        p.seed = rng.nextInt64();
+        p.sampleRate = sampleRates[rng.nextInt(numElementsInArray(sampleRates))];
+        p.lengthSeconds = 0.01 * std::pow(800.0, rng.nextDouble());
+        p.tuneSemitones = (float)(rng.nextInt(49) - 24);
+        p.masterGainDb = -24.0f + 36.0f * rng.nextFloat();
+        p.subAmount = amount();
+        p.boomAmount = amount();
+        p.shortness = amount();
+        p.punch = amount();
+        p.growl = amount();
+        p.detune = amount();
+        p.analog = amount();
+        p.clean = amount();
+        p.oversampling = oversamplingFactors[rng.nextInt(3)];
+        p.autoLength = rng.nextInt(4) == 0;
+        p.engineVersion = engines[(size_t)rng.nextInt((int)engines.size())].number;
+    }
+
+    Generator808::State state;
+    AudioBuffer<float> out;
+
+    auto renderTimed = [&state, &out](const GeneratorParams& p)
+    {
+        const double t0 = Time::getMillisecondCounterHiRes();
+        out.setSize(Generator808::getNumOutputChannels(p), (int)std::lround(p.lengthSeconds * p.sampleRate), false, false, true);
+        Generator808::render(p, state, out);
+        return Time::getMillisecondCounterHiRes() - t0;
+    };
+
+    for (auto& c : cases)
+    {
+        c.ms = renderTimed(c.params);
+        c.numSamples = out.getNumSamples();
+        c.nsPerSample = c.ms * 1.0e6 / jmax(1, c.numSamples);
+        c.realTimeFactor = c.ms / jmax(1.0e-9, 1000.0 * c.numSamples / c.params.sampleRate);
+
+        for (int ch = 0; ch < out.getNumChannels(); ++ch)
+        {
+            const float* x = out.getReadPointer(ch);
+            for (int i = 0; i < c.numSamples; ++i)
+            {
+                const float a = std::abs(x[i]);
+                if (!std::isfinite(x[i]))
+                    ++c.numNonFinite;
+                else if (a != 0.0f && a < FLT_MIN)
+                    ++c.numDenormal;
+                else if (a > 1.0f)
+                    ++c.numClipped;
+            }
+        }
+    }
+
+    // a slowdown is relative to renders doing the same amount of work per output sample
+    int numSlow = 0;
+    for (int factor : oversamplingFactors)
+    {
+        std::vector<double> costs;
+        for (auto& c : cases)
+            if (c.params.oversampling == factor && c.numSamples >= minTimedSamples)
+                costs.push_back(c.nsPerSample);
+        if (costs.empty())
+            continue;
+
+        std::nth_element(costs.begin(), costs.begin() + (std::ptrdiff_t)costs.size() / 2, costs.end());
+        const double median = costs[costs.size() / 2];
+
+        for (auto& c : cases)
+        {
+            if (c.params.oversampling != factor || c.numSamples < minTimedSamples || c.nsPerSample <= slowdown * median)
+                continue;
+
+            // the fastest of three more runs, so a preempted thread isn't reported as a slow setting
+            double best = c.ms;
+            for (int retry = 0; retry < 3; ++retry)
+                best = jmin(best, renderTimed(c.params));
+
+            c.ms = best;
+            c.nsPerSample = best * 1.0e6 / c.numSamples;
+            c.realTimeFactor = best / (1000.0 * c.numSamples / c.params.sampleRate);
+            c.slow = c.nsPerSample > slowdown * median;
+            if (c.slow)
+                ++numSlow;
+        }
+    }
+
+    auto describe = [](const GeneratorParams& p)
+    {
+        return "seed " + String(p.seed) + ", " + String(p.sampleRate, 0) + " Hz, " + String(p.lengthSeconds, 3) + " s, "
+             + String(p.oversampling) + "x, v" + String(p.engineVersion) + (p.autoLength ? ", auto length" : "")
+             + ", tune " + String(p.tuneSemitones, 0) + ", gain " + String(p.masterGainDb, 1) + " dB"
+             + ", sub " + String(p.subAmount, 2) + " boom " + String(p.boomAmount, 2) + " short " + String(p.shortness, 2)
+             + " punch " + String(p.punch, 2) + " growl " + String(p.growl, 2) + " detune " + String(p.detune, 2)
+             + " analog " + String(p.analog, 2) + " clean " + String(p.clean, 2);
+    };
+
+    std::vector<const FuzzCase*> slowest;
+    for (auto& c : cases)
+        if (c.numSamples >= minTimedSamples)
+            slowest.push_back(&c);
+    std::sort(slowest.begin(), slowest.end(), [](const FuzzCase* a, const FuzzCase* b) { return a->nsPerSample > b->nsPerSample; });
+
+    std::cout << "Slowest per output sample:" << std::endl;
+    for (size_t i = 0; i < jmin((size_t)numTop, slowest.size()); ++i)
+        std::cout << "  " << String(slowest[i]->nsPerSample, 1) << " ns/sample" << (slowest[i]->slow ? " SLOW" : "")
+                  << "  " << describe(slowest[i]->params) << std::endl;
+
+    int numNonFinite = 0, numDenormal = 0, numClipped = 0;
+    const FuzzCase* worstRealTime = &cases.front();
+    for (auto& c : cases)
+    {
+        if (c.numNonFinite > 0 || c.numDenormal > 0)
+            std::cout << "  " << c.numNonFinite << " non-finite, " << c.numDenormal << " denormal samples: " << describe(c.params) << std::endl;
+        numNonFinite += c.numNonFinite > 0 ? 1 : 0;
+        numDenormal += c.numDenormal > 0 ? 1 : 0;
+        numClipped += c.numClipped > 0 ? 1 : 0;
+        if (c.numSamples >= minTimedSamples && c.realTimeFactor > worstRealTime->realTimeFactor)
+            worstRealTime = &c;
+    }
+
+    std::cout << numCases << " renders: " << numNonFinite << " with NaN/Inf, " << numDenormal << " with denormals, "
+              << numClipped << " beyond full scale, " << numSlow << " more than " << String(slowdown, 1) << "x the median cost" << std::endl
+              << "Worst real-time factor " << String(worstRealTime->realTimeFactor, 4) << " (" << describe(worstRealTime->params) << ")"
+              << std::endl;
+
+    if (reportFile != File())
+    {
+        String csv = "seed,sampleRate,lengthSeconds,tuneSemitones,masterGainDb,subAmount,boomAmount,shortness,punch,growl,detune,"
+                     "analog,clean,oversampling,autoLength,engineVersion,samples,ms,nsPerSample,realTimeFactor,nonFinite,denormal,"
+                     "clipped,slow\n";
+        for (auto& c : cases)
+        {
+            const auto& p = c.params;
+            csv << String(p.seed) << "," << String(p.sampleRate, 0) << "," << String(p.lengthSeconds, 4) << "," << String(p.tuneSemitones, 0)
+                << "," << String(p.masterGainDb, 2) << "," << String(p.subAmount, 3) << "," << String(p.boomAmount, 3) << ","
+                << String(p.shortness, 3) << "," << String(p.punch, 3) << "," << String(p.growl, 3) << "," << String(p.detune, 3) << ","
+                << String(p.analog, 3) << "," << String(p.clean, 3) << "," << p.oversampling << "," << (p.autoLength ? 1 : 0) << ","
+                << p.engineVersion << "," << c.numSamples << "," << String(c.ms, 3) << "," << String(c.nsPerSample, 2) << ","
+                << String(c.realTimeFactor, 5) << "," << c.numNonFinite << "," << c.numDenormal << "," << c.numClipped << ","
+                << (c.slow ? 1 : 0) << "\n";
+        }
+
+        if (!reportFile.replaceWithText(csv))
+            ConsoleApplication::fail("Could not write " + reportFile.getFullPathName());
+        std::cout << "Wrote " << reportFile.getFullPathName() << std::endl;
+    }
+
+    if (numNonFinite > 0 || numDenormal > 0)
+        ConsoleApplication::fail("Renders produced non-finite or denormal samples");
+    if (numSlow > 0)
+        ConsoleApplication::fail(String(numSlow) + " settings render pathologically slowly");
+}
+
+void HeadlessCommands::checkDenormals(const ArgumentList& args)
+{
+    const int numSeconds = args.containsOption("--seconds") ? jmax(2, args.getValueForOption("--seconds").getIntValue()) : 8;
+    const int numRepeats = args.containsOption("--repeats") ? jmax(1, args.getValueForOption("--repeats").getIntValue()) : 5;
+    const double maxRatio = args.containsOption("--max-ratio") ? jmax(1.0, args.getValueForOption("--max-ratio").getDoubleValue()) : 2.0;
+
+    // decays to silence within a fraction of a second; the rest of the render is the deep tail
+    GeneratorParams base;
+    base.seed = 4700;
+    base.engineVersion = GeneratorParams::latestEngineVersion;
+    base.sampleRate = 48000.0;
+    base.shortness = 1.0f;
+    base.punch = 0.5f;
+    base.growl = 0.3f;
+    base.analog = 0.0f;
+    base.detune = 0.4f;
+
+    enum class Path { scalar, draft, batch };
+    struct TailCase
+    {
+        const char* name;
+        Path path;
+        int oversampling;
+    };
+    const TailCase tailCases[] = {
+        { "render 1x", Path::scalar, 1 },
+        { "render 2x", Path::scalar, 2 },
+        { "render 4x", Path::scalar, 4 },
+        { "draft", Path::draft, 1 },
+        { "batch", Path::batch, 1 },
+    };
+
+    Generator808::State state;
+    AudioBuffer<float> out;
+    const int lanes = BatchRender808::getNativeLanes();
+    int numStalled = 0;
+
+    for (const auto& tc : tailCases)
+    {
+        auto p = base;
+        p.oversampling = tc.oversampling;
+
+        // renders are causal, so a render one second longer costs exactly one more second of work
+        auto renderMs = [&](int seconds)
+        {
+            p.lengthSeconds = seconds;
+            double best = 1.0e30;
+            for (int r = 0; r < numRepeats; ++r)
+            {
+                const double t0 = Time::getMillisecondCounterHiRes();
+                if (tc.path == Path::draft)
+                {
+                    Generator808::renderDraft(p, state, out, (double)seconds);
+                }
+                else if (tc.path == Path::batch)
+                {
+                    const auto voices = BatchRender808::renderAll(std::vector<GeneratorParams>((size_t)lanes, p), lanes);
+                    out.makeCopyOf(voices.front());
+                }
+                else
+                {
+                    out.setSize(Generator808::getNumOutputChannels(p), (int)std::lround(p.lengthSeconds * p.sampleRate), false, false, true);
+                    Generator808::render(p, state, out);
+                }
+                best = jmin(best, Time::getMillisecondCounterHiRes() - t0);
+            }
+            return best;
+        };
+
+        std::vector<double> ms { 0.0 };
+        for (int s = 1; s <= numSeconds; ++s)
+            ms.push_back(renderMs(s));
+
+        const int samplesPerSecond = tc.path == Path::draft ? Generator808::getDraftNumSamples(p, 1.0) : (int)p.sampleRate;
+        const double headNs = ms[1] * 1.0e6 / samplesPerSecond;
+        const double tailNs = (ms.back() - ms[1]) * 1.0e6 / ((double)samplesPerSecond * (numSeconds - 1));
+        const double ratio = tailNs / jmax(1.0e-9, headNs);
+
+        float tailPeak = 0.0f;
+        for (int ch = 0; ch < out.getNumChannels(); ++ch)
+            tailPeak = jmax(tailPeak, out.getMagnitude(ch, out.getNumSamples() - samplesPerSecond, samplesPerSecond));
+
+        std::cout << String(tc.name).paddedRight(' ', 10) << " ns/sample per second:";
+        for (int s = 1; s <= numSeconds; ++s)
+            std::cout << " " << String((ms[(size_t)s] - ms[(size_t)s - 1]) * 1.0e6 / samplesPerSecond, 1);
+        std::cout << "  tail/head " << String(ratio, 2) << ", last second peaks at "
+                  << (tailPeak > 0.0f ? String(Decibels::gainToDecibels(tailPeak, -1000.0f), 0) + " dBFS" : String("0"))
+                  << (ratio > maxRatio ? "  STALLED" : "") << std::endl;
+
+        if (ratio > maxRatio)
+            ++numStalled;
+    }
+
+    if (numStalled > 0)
+        ConsoleApplication::fail(String(numStalled) + " render paths slow down in the tail");
+}
+
+void HeadlessCommands::checkRealtime(const ArgumentList& args)
+{
+    if (!RealtimeChecker::isAvailable())
+        ConsoleApplication::fail("The real-time checker is unavailable: this build has ORADE808_TEST_HOOKS=0");
+
+    const int numBlocks = args.containsOption("--blocks") ? jmax(1, args.getValueForOption("--blocks").getIntValue()) : 20000;
+    const double sampleRate = 44100.0;
+    const int blockSize = 512;
+
+    RealtimeChecker checker;
+
+    // the hooks only work if ours are the ones linked in: operator new / delete, and on glibc
+    // malloc / free and pthread_mutex_lock
+    const int numCanaries = RealtimeChecker::seesMallocAndMutexes() ? 5 : 2;
+    {
+        std::mutex lock;
+        RealtimeChecker::Scope realtime(&checker);
+        // through a volatile, so the compiler can't drop the pairs
+        int* volatile allocated = new int(808);
+        delete allocated;
+        if (RealtimeChecker::seesMallocAndMutexes())
+        {
+            void* volatile block = std::malloc(808);
+            std::free(block);
+            const std::lock_guard<std::mutex> guard(lock);
+        }
+    }
+    if (checker.getNumViolations() < numCanaries)
+        ConsoleApplication::fail("The checker missed a deliberate allocation, free or lock (" + String(checker.getNumViolations())
+                                 + " of " + String(numCanaries) + " seen); are the allocation functions replaced?");
+    if (!RealtimeChecker::seesMallocAndMutexes())
+        std::cout << "Note: this platform's checker sees operator new / delete only, not malloc or locks" << std::endl;
+    checker.clear();
+
+    // buffers to swap in, rendered up front: short so previews keep reaching the end
+    GeneratorParams params;
+    params.sampleRate = sampleRate;
+    params.lengthSeconds = 0.25;
+    params.engineVersion = GeneratorParams::latestEngineVersion;
+    std::vector<AudioBuffer<float>> renders;
+    for (int i = 0; i < 4; ++i)
+    {
+        params.seed = 4800 + i;
+        params.detune = (i % 2 == 0) ? 0.0f : 0.4f; // mono and stereo renders
+        Generator808::State state;
+        AudioBuffer<float> out(Generator808::getNumOutputChannels(params), (int)std::lround(params.lengthSeconds * params.sampleRate));
+        Generator808::render(params, state, out);
+        renders.push_back(std::move(out));
+    }
+
+    PluginProcessor processor;
+    processor.prepareToPlay(sampleRate, blockSize);
+    processor.storeGenerated(params, AudioBuffer<float>(renders.front()));
+    processor.startPreview();
+    processor.setRealtimeChecker(&checker);
+
+    std::atomic<int> blocksDone{ 0 };
+    std::thread audioThread([&]()
+    {
+        AudioBuffer<float> block(2, blockSize);
+        MidiBuffer midi;
+        for (int b = 0; b < numBlocks; ++b)
+        {
+            processor.processBlock(block, midi);
+            blocksDone.store(b + 1);
+        }
+    });
+
+    int64 numSwaps = 0, numToggles = 0, numReads = 0;
+    for (int step = 0; blocksDone.load() < numBlocks; ++step)
+    {
+        const auto& next = renders[(size_t)step % renders.size()];
+        switch (step % 4)
+        {
+            case 0:  processor.storeGenerated(params, AudioBuffer<float>(next)); ++numSwaps; break;
+            case 1:  processor.storeGenerated(params, std::make_shared<AudioBuffer<float>>(next)); ++numSwaps; break;
+            case 2:  processor.startPreview(); ++numToggles; break;
+            default:
+                if (step % 16 == 3)
+                {
+                    processor.stopPreview();
+                    ++numToggles;
+                }
+                numReads += processor.getGeneratedBufferSharedPtr() != nullptr;
+                numReads += processor.getGeneratedSound().peaks != nullptr;
+                break;
+        }
+        Thread::sleep(step % 8 == 0 ? 1 : 0);
+    }
+
+    audioThread.join();
+    processor.setRealtimeChecker(nullptr);
+    processor.getOutputMeter().update();
+
+    std::cout << numBlocks << " blocks on the audio thread, meanwhile " << numSwaps << " buffer swaps, " << numToggles
+              << " preview starts/stops and " << numReads << " reads" << std::endl;
+
+    const auto violations = checker.getViolations();
+    for (size_t i = 0; i < jmin(violations.size(), (size_t)10); ++i)
+    {
+        std::cout << "Audio thread " << violations[i].what << " at:" << std::endl;
+        auto frames = StringArray::fromLines(violations[i].callSite.trim());
+        frames.removeRange(12, frames.size());
+        for (auto& frame : frames)
+            std::cout << "    " << frame.trim() << std::endl;
+    }
+
+    if (!violations.empty())
+        ConsoleApplication::fail(String((int)violations.size()) + " real-time violations in processBlock");
+
+    std::cout << "No allocations, frees or blocking locks in processBlock" << std::endl;
+}
+
+void HeadlessCommands::simulateHost(const ArgumentList& args)
+{
+    auto parseList = [&args](const String& option, const String& fallback)
+    {
+        Array<double> values;
+        auto text = args.containsOption(option) ? args.getValueForOption(option) : fallback;
+        for (auto& token : StringArray::fromTokens(text, ",", ""))
+            if (token.trim().getDoubleValue() > 0.0)
+                values.add(token.trim().getDoubleValue());
+        return values;
+    };
+
+    const auto rates = parseList("--rates", "44100,48000,96000");
+    const auto blocks = parseList("--blocks", "64,256,1024");
+    const double maxP99 = args.containsOption("--max-p99") ? jmax(0.01, args.getValueForOption("--max-p99").getDoubleValue()) : 0.5;
+
+    HostSimulationOptions options;
+    if (args.containsOption("--seconds"))
+        options.seconds = jmax(0.1, args.getValueForOption("--seconds").getDoubleValue());
+    if (args.containsOption("--transport-threads"))
+        options.numTransportThreads = jmax(0, args.getValueForOption("--transport-threads").getIntValue());
+    options.paced = !args.containsOption("--free-run");
+
+    if (rates.isEmpty() || blocks.isEmpty())
+        ConsoleApplication::fail("--rates and --blocks need at least one positive value each");
+
+    int numOverBudget = 0, numWithDropouts = 0;
+    for (auto rate : rates)
+    {
+        for (auto blockSize : blocks)
+        {
+            options.sampleRate = rate;
+            options.blockSize = jlimit(1, 16384, (int)blockSize);
+
+            const auto r = HostSimulator::run(options);
+            const bool overBudget = r.p99Us > maxP99 * r.budgetUs;
+            const bool droppedOut = r.getNumPreviewDropouts() > 0;
+
+            std::cout << String((int)rate).paddedLeft(' ', 6) << " Hz " << String(options.blockSize).paddedLeft(' ', 5)
+                      << " samples: " << r.toString() << (overBudget ? "  OVER BUDGET" : "")
+                      << (droppedOut ? "  DROPOUTS" : "") << std::endl;
+
+            if (overBudget)
+                ++numOverBudget;
+            if (droppedOut)
+                ++numWithDropouts;
+        }
+    }
+
+    if (numOverBudget > 0 || numWithDropouts > 0)
+        ConsoleApplication::fail(String(numOverBudget) + " configurations have a p99 callback time over "
+                                 + String(maxP99, 2) + " times the budget, " + String(numWithDropouts)
+                                 + " have silenced or underrun preview blocks");
+}
+
+void HeadlessCommands::daemon(const ArgumentList& args)
+{
+    RenderDaemonOptions options;
+    if (args.containsOption("--socket"))
+        options.socketPath = args.getFileForOption("--socket");
+    if (args.containsOption("--threads"))
+        options.numThreads = args.getValueForOption("--threads").getIntValue();
+    if (args.containsOption("--max-batch"))
+        options.maxBatchSize = jmax(1, args.getValueForOption("--max-batch").getIntValue());
+    if (args.containsOption("--batch-window"))
+        options.batchWindowMs = jmax(0.0, args.getValueForOption("--batch-window").getDoubleValue());
+
+    RenderDaemon server(options);
+    String error;
+    if (!server.start(error))
+        ConsoleApplication::fail(error);
+
+    std::cout << "Listening on " << server.getSocketPath().getFullPathName() << std::endl;
+    server.waitForShutdownRequest();
+    server.stop();
+
+    std::cout << server.getStats().toString() << std::endl;
+}
+
+void HeadlessCommands::daemonTest(const ArgumentList& args)
+{
+    const int numClients = args.containsOption("--clients") ? jmax(1, args.getValueForOption("--clients").getIntValue()) : 8;
+    const int numRequests = args.containsOption("--requests") ? jmax(1, args.getValueForOption("--requests").getIntValue()) : 16;
+
+    const auto temp = File::getSpecialLocation(File::tempDirectory);
+    const auto outFolder = temp.getChildFile("808orade-daemon-test");
+    outFolder.deleteRecursively();
+
+    RenderDaemonOptions options;
+    options.socketPath = temp.getChildFile("808orade-test-" + String::toHexString(Random::getSystemRandom().nextInt()) + ".sock");
+
+    RenderDaemon server(options);
+    String error;
+    if (!server.start(error))
+        ConsoleApplication::fail(error);
+
+    // request r of client c; every fourth is written to a file, every seventh is oversampled (the scalar
+    // path). Odd ones name the latest engine, even ones no engine, which has to render as v1
+    auto makeParams = [](int c, int r)
+    {
+        GeneratorParams p;
+        p.seed = 9000 + (int64_t)c * 100 + r;
+        p.engineVersion = r % 2 == 1 ? GeneratorParams::latestEngineVersion : 1;
+        p.sampleRate = r % 3 == 0 ? 48000.0 : 44100.0;
+        p.lengthSeconds = 0.3 + 0.05 * (double)(r % 5);
+        p.punch = 0.5f;
+        p.growl = r % 2 == 0 ? 0.0f : 0.4f;
+        p.analog = 0.3f;
+        p.detune = c % 2 == 0 ? 0.0f : 0.35f;
+        p.oversampling = r % 7 == 6 ? 2 : 1;
+        return p;
+    };
+
+    auto toJson = [](const GeneratorParams& p)
+    {
+        DynamicObject::Ptr o = new DynamicObject();
+        o->setProperty("seed", String(p.seed));
+        o->setProperty("sampleRate", p.sampleRate);
+        o->setProperty("lengthSeconds", p.lengthSeconds);
+        o->setProperty("punch", p.punch);
+        o->setProperty("growl", p.growl);
+        o->setProperty("analog", p.analog);
+        o->setProperty("detune", p.detune);
+        o->setProperty("oversampling", p.oversampling);
+        if (p.engineVersion != 1)
+            o->setProperty("engineVersion", p.engineVersion);
+        return var(o.get());
+    };
+
+    std::atomic<int> numInline{ 0 }, numFiles{ 0 }, numWrong{ 0 };
+    std::mutex printLock;
+    auto report = [&](int c, int r, const String& message)
+    {
+        std::lock_guard<std::mutex> lock(printLock);
+        std::cout << "  client " << c << " request " << r << ": " << message << std::endl;
+        ++numWrong;
+    };
+
+    const double t0 = Time::getMillisecondCounterHiRes();
+
+    ParallelJobs::run(numClients, numClients, [&](int c)
+    {
+        String connectError;
+        auto socket = LocalSocket::connect(server.getSocketPath(), connectError);
+        if (socket == nullptr)
+            return report(c, 0, connectError);
+
+        Generator808 reference;
+        std::string line;
+
+        for (int r = 0; r < numRequests; ++r)
+        {
+            const auto p = makeParams(c, r);
+            const bool toFile = r % 4 == 3;
+            const auto file = outFolder.getChildFile("c" + String(c) + "-r" + String(r) + ".wav");
+
+            DynamicObject::Ptr request = new DynamicObject();
+            request->setProperty("id", r);
+            request->setProperty("params", toJson(p));
+            if (toFile)
+            {
+                request->setProperty("output", file.getFullPathName());
+                request->setProperty("mono", true);
+            }
+
+            if (!socket->writeLine(JSON::toString(var(request.get()), true)) || !socket->readLine(line))
+                return report(c, r, "connection lost");
+
+            const auto reply = JSON::parse(String::fromUTF8(line.data(), (int)line.size()));
+            if (!(bool)reply["ok"] || (int)reply["id"] != r)
+            {
+                report(c, r, "failed: " + reply["error"].toString());
+                continue;
+            }
+
+            const auto expected = reference.renderToBuffer(p);
+            if ((int)reply["numChannels"] != expected.getNumChannels() || (int)reply["numSamples"] != expected.getNumSamples())
+            {
+                report(c, r, "wrong layout");
+                if (!toFile)
+                    return;  // the PCM that follows can't be skipped reliably
+                continue;
+            }
+
+            if (toFile)
+            {
+                if (!file.existsAsFile())
+                    report(c, r, "no file at " + file.getFullPathName());
+                ++numFiles;
+                continue;
+            }
+
+            const int numChannels = expected.getNumChannels(), numSamples = expected.getNumSamples();
+            std::vector<float> pcm((size_t)numChannels * (size_t)numSamples);
+            if ((int64)reply["pcmBytes"] != (int64)(pcm.size() * sizeof(float)) || !socket->read(pcm.data(), pcm.size() * sizeof(float)))
+                return report(c, r, "short PCM");
+
+            float maxDiff = 0.0f;
+            for (int ch = 0; ch < numChannels; ++ch)
+                for (int i = 0; i < numSamples; ++i)
+                    maxDiff = jmax(maxDiff, std::abs(pcm[(size_t)i * (size_t)numChannels + (size_t)ch] - expected.getSample(ch, i)));
+
+            if (maxDiff > 1.0e-4f)
+                report(c, r, "differs from Generator808 by " + String(maxDiff));
+            ++numInline;
+        }
+    });
+
+    const double ms = Time::getMillisecondCounterHiRes() - t0;
+
+    // malformed requests have to be answered with an error, not kill the connection
+    auto control = LocalSocket::connect(server.getSocketPath(), error);
+    if (control == nullptr)
+        ConsoleApplication::fail(error);
+
+    auto ask = [&control](const String& request)
+    {
+        std::string line;
+        if (!control->writeLine(request) || !control->readLine(line))
+            ConsoleApplication::fail("The daemon closed the connection after " + request);
+        return JSON::parse(String::fromUTF8(line.data(), (int)line.size()));
+    };
+
+    for (auto* bad : { "not json", "{\"params\": {\"bogus\": 1}}", "{\"params\": {\"oversampling\": 3}}",
+                       "{\"params\": {\"detune\": \"wide\"}}", "{\"cmd\": \"explode\"}", "{\"params\": {}, \"output\": \"relative.wav\"}",
+                       "{\"params\": {\"seed\": \"\"}}", "{\"params\": {\"seed\": \"-\"}}", "{\"params\": {\"seed\": \"--5\"}}",
+                       "{\"params\": {\"seed\": \"9223372036854775808\"}}",
+                       "{\"params\": {\"sampleRate\": 384000, \"lengthSeconds\": 60}}" })
+    {
+        const auto reply = ask(bad);
+        if ((bool)reply["ok"])
+        {
+            std::cout << "  accepted " << bad << std::endl;
+            ++numWrong;
+        }
+    }
+
+    const auto stats = ask("{\"cmd\": \"stats\"}")["stats"];
+    std::cout << "stats over the socket: " << JSON::toString(stats, true) << std::endl;
+
+    ask("{\"cmd\": \"shutdown\"}");
+    server.waitForShutdownRequest();
+    server.stop();
+    outFolder.deleteRecursively();
+
+    const auto expected = (int64)numClients * numRequests;
+    std::cout << numClients << " clients x " << numRequests << " requests in " << String(ms, 1) << " ms: "
+              << numInline.load() << " inline, " << numFiles.load() << " files, " << numWrong.load() << " wrong" << std::endl
+              << server.getStats().toString() << std::endl;
+
+    if (numWrong > 0 || server.getStats().numRenders != expected)
+        ConsoleApplication::fail("The daemon answered " + String(numWrong.load()) + " requests wrongly");
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <JuceHeader.h>
+
+/*
+ HeadlessCommands
+ - Command-line jobs the standalone app runs without opening a window, e.g.
+     808orade --resynth-folder <inputFolder> <outputFolder> [--threads=N] [--recursive] [--length=N] [--auto-length[=floorDb]] [--mono] [--shard=i/N]
+     808orade --render-seeds <outputFolder> --count=N [--first-seed=S] [--length=N] [--auto-length[=floorDb]] [--mono] [--threads=N] [--shard=i/N]
+     808orade --merge-shards <outputFolder> --shards=N [--out=<file>]
+     808orade --index-library <folder> [--index=<file>] [--threads=N]
+     808orade --find-similar <file> [--index=<file>] [--k=N] [--seeds=N]
+     808orade --bench-similarity [--items=N] [--queries=N]
+     808orade --meter-preview [--seed=N] [--block=N]
+     808orade --sweep [--seeds=N] [--detunes=a,b,..] [--gains=a,b,..] [--out=<folder>]
+     808orade --bench-batch [--voices=N] [--lanes=4|8|16]
+     808orade --bench-math [--samples=N]
+     808orade --bench-render [--seconds=N] [--rate=N] [--renders=N]
+     808orade --bench-oversampling [--rate=N] [--renders=N]
+     808orade --check-allocations [--rounds=N]
+     808orade --stress-threads [--threads=N] [--rounds=N]
+     808orade --check-engines <goldenFile> [--update]
+     808orade --fuzz-render [--cases=N] [--seed=N] [--top=N] [--slowdown=x] [--report=<file.csv>]
+     808orade --check-denormals [--seconds=N] [--repeats=N] [--max-ratio=x]
+     808orade --check-realtime [--blocks=N]
+     808orade --simulate-host [--rates=a,b,..] [--blocks=a,b,..] [--seconds=N] [--transport-threads=N] [--free-run] [--max-p99=x]
+     808orade --daemon [--socket=<path>] [--threads=N] [--max-batch=N] [--batch-window=ms]
+     808orade --daemon-test [--clients=N] [--requests=N]
+ - Main.cpp asks handles() first; if it returns true the app runs the job and quits
+ - Any command also takes --stats (a table of per-stage render times when it's done) and
+   --trace=<file.json> (a Chrome trace of every timed stage); see StageTimers
+ - Each command is a juce::ConsoleApplication command, so "808orade --help" lists them all
+*/
+class HeadlessCommands
+{
+public:
+    // true if the first argument names one of the headless commands (or --help)
+    static bool handles(const juce::StringArray& args);
+
+    // run the command; returns the process exit code
+    static int run(const juce::StringArray& args);
+
+private:
+    static juce::ConsoleApplication makeApp();
+    static juce::ArgumentList makeArgumentList(const juce::StringArray& args);
+
+    static void resynthFolder(const juce::ArgumentList& args);
+    static void renderSeeds(const juce::ArgumentList& args);
+    static void mergeShards(const juce::ArgumentList& args);
+    static void indexLibrary(const juce::ArgumentList& args);
+    static void findSimilar(const juce::ArgumentList& args);
+    static void benchSimilarity(const juce::ArgumentList& args);
+    static void meterPreview(const juce::ArgumentList& args);
+    static void sweep(const juce::ArgumentList& args);
+    static void benchBatch(const juce::ArgumentList& args);
+    static void benchMath(const juce::ArgumentList& args);
+    static void benchRender(const juce::ArgumentList& args);
+    static void benchOversampling(const juce::ArgumentList& args);
+    static void checkAllocations(const juce::ArgumentList& args);
+    static void stressThreads(const juce::ArgumentList& args);
+    static void checkEngines(const juce::ArgumentList& args);
+    static void fuzzRender(const juce::ArgumentList& args);
+    static void checkDenormals(const juce::ArgumentList& args);
+    static void checkRealtime(const juce::ArgumentList& args);
+    static void simulateHost(const juce::ArgumentList& args);
+    static void daemon(const juce::ArgumentList& args);
+    static void daemonTest(const juce::ArgumentList& args);
+};
@@ -0,0 +1,186 @@
+#include "HostSimulator.h"
+#include "PluginProcessor.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace juce;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double microsecondsBetween(Clock::time_point a, Clock::time_point b)
+    {
+        return std::chrono::duration<double, std::micro>(b - a).count();
+    }
+
+    // sorted must be sorted; nearest rank
+    double percentile(const std::vector<double>& sorted, double fraction)
+    {
+        if (sorted.empty())
+            return 0.0;
+        return sorted[(size_t)jlimit(0.0, (double)sorted.size() - 1.0, std::ceil(fraction * (double)sorted.size()) - 1.0)];
+    }
+
+    // what the editor might ask for next: short and long, mono and stereo, some oversampled
+    GeneratorParams nextSettings(Random& random, double sampleRate)
+    {
+        GeneratorParams p;
+        p.seed = random.nextInt64();
+        p.engineVersion = GeneratorParams::latestEngineVersion;
+        p.sampleRate = sampleRate;
+        p.lengthSeconds = 0.3 + 1.2 * random.nextDouble();
+        p.subAmount = random.nextFloat();
+        p.punch = random.nextFloat();
+        p.growl = random.nextBool() ? 0.0f : random.nextFloat();
+        p.analog = random.nextFloat() * 0.5f;
+        p.detune = random.nextBool() ? 0.0f : random.nextFloat();
+        p.oversampling = random.nextInt(4) == 0 ? 2 : 1;
+        return p;
+    }
+}
+
+String HostSimulationResult::toString() const
+{
+    return String(numCallbacks) + " callbacks, budget " + String(budgetUs, 1) + " us: mean " + String(meanUs, 1)
+         + " us (load " + String(100.0 * getLoad(), 2) + "%), p50 " + String(p50Us, 1) + ", p99 " + String(p99Us, 1)
+         + ", p99.9 " + String(p999Us, 1) + ", max " + String(maxUs, 1) + " us (" + String(100.0 * maxUs / jmax(1.0e-9, budgetUs), 1)
+         + "% of budget), " + String(numOverruns) + " overruns, " + String(numLateStarts) + " late starts, "
+         + String(numSilencedPreviewBlocks) + " silenced and " + String(numPreviewUnderruns) + " underrun preview blocks; meanwhile "
+         + String(numGenerates) + " generates (" + String(numFailedGenerates) + " failed), " + String(numPreviewToggles)
+         + " preview starts/stops, " + String(numReads) + " reads";
+}
+
+HostSimulationResult HostSimulator::run(const HostSimulationOptions& options)
+{
+    HostSimulationResult result;
+    const int blockSize = jmax(1, options.blockSize);
+    result.numCallbacks = jmax(1, (int)std::ceil(options.seconds * options.sampleRate / blockSize));
+    result.budgetUs = 1.0e6 * blockSize / options.sampleRate;
+
+    PluginProcessor processor;
+    processor.prepareToPlay(options.sampleRate, blockSize);
+
+    // everything the audio thread touches exists before it starts
+    std::vector<double> callbackUs((size_t)result.numCallbacks, 0.0);
+    AudioBuffer<float> block(jmax(1, options.numChannels), blockSize);
+    MidiBuffer midi;
+
+    std::atomic<bool> audioDone{ false };
+    std::atomic<int> numGenerates{ 0 }, numFailedGenerates{ 0 }, numToggles{ 0 }, numReads{ 0 };
+
+    // the editor generates before there is anything to preview; so do we
+    Random firstRandom(options.seed);
+    if (processor.generate808AndStore(nextSettings(firstRandom, options.sampleRate)))
+        ++numGenerates;
+    else
+        ++numFailedGenerates;
+
+    // the editor's message thread: a new 808 as soon as the last one is published
+    std::thread messageThread([&]()
+    {
+        Random random(options.seed + 1000);
+        while (!audioDone.load())
+        {
+            if (processor.generate808AndStore(nextSettings(random, options.sampleRate)))
+                ++numGenerates;
+            else
+                ++numFailedGenerates;
+        }
+    });
+
+    std::vector<std::thread> transportThreads;
+    for (int t = 0; t < jmax(0, options.numTransportThreads); ++t)
+    {
+        transportThreads.emplace_back([&, t]()
+        {
+            Random random(options.seed + 1 + t);
+            while (!audioDone.load())
+            {
+                if (random.nextInt(4) == 0)
+                    processor.stopPreview();
+                else
+                    processor.startPreview();
+                ++numToggles;
+
+                numReads += processor.getGeneratedBufferSharedPtr() != nullptr;
+                numReads += processor.getGeneratedSound().peaks != nullptr;
+
+                // the UI timer's meter read; OutputMeter has a single consumer
+                if (t == 0)
+                    processor.getOutputMeter().update();
+
+                std::this_thread::sleep_for(std::chrono::microseconds(random.nextInt(2000)));
+            }
+        });
+    }
+
+    const auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::micro>(result.budgetUs));
+    int numLateStarts = 0, numPreviewUnderruns = 0;
+    const auto wallStart = Clock::now();
+
+    std::thread audioThread([&]()
+    {
+        auto deadline = Clock::now();
+        for (int b = 0; b < result.numCallbacks; ++b)
+        {
+            bool late = false;
+            if (options.paced)
+            {
+                std::this_thread::sleep_until(deadline);
+
+                // a sound card doesn't wait: the blocks missed meanwhile are gone, carry on from now
+                if (Clock::now() - deadline > period)
+                {
+                    ++numLateStarts;
+                    late = true;
+                    deadline = Clock::now();
+                }
+            }
+
+            const bool wasPreviewing = processor.isPreviewing();
+            const auto t0 = Clock::now();
+            processor.processBlock(block, midi);
+            callbackUs[(size_t)b] = microsecondsBetween(t0, Clock::now());
+
+            if (wasPreviewing && (late || callbackUs[(size_t)b] > result.budgetUs))
+                ++numPreviewUnderruns;
+
+            deadline += period;
+        }
+        audioDone.store(true);
+    });
+
+    audioThread.join();
+    messageThread.join();
+    for (auto& t : transportThreads)
+        t.join();
+
+    result.wallSeconds = microsecondsBetween(wallStart, Clock::now()) * 1.0e-6;
+    result.numLateStarts = numLateStarts;
+    result.numPreviewUnderruns = numPreviewUnderruns;
+    result.numSilencedPreviewBlocks = processor.getNumSilencedPreviewBlocks();
+    result.numGenerates = numGenerates.load();
+    result.numFailedGenerates = numFailedGenerates.load();
+    result.numPreviewToggles = numToggles.load();
+    result.numReads = numReads.load();
+
+    double sum = 0.0;
+    for (auto us : callbackUs)
+    {
+        sum += us;
+        if (us > result.budgetUs)
+            ++result.numOverruns;
+    }
+
+    std::sort(callbackUs.begin(), callbackUs.end());
+    result.meanUs = sum / (double)callbackUs.size();
+    result.p50Us = percentile(callbackUs, 0.5);
+    result.p99Us = percentile(callbackUs, 0.99);
+    result.p999Us = percentile(callbackUs, 0.999);
+    result.maxUs = callbackUs.back();
+    return result;
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <JuceHeader.h>
+
+/*
+ HostSimulator
+ - Stands in for a DAW to reproduce dropouts offline: creates a PluginProcessor, calls
+   prepareToPlay and then processBlock on an "audio" thread at the block size and sample rate
+   given, while other threads do what the editor does at the same time
+     - one thread keeps calling generate808AndStore with new settings (it is the processor's
+       message thread: generate808AndStore isn't re-entrant)
+     - numTransportThreads threads keep calling startPreview / stopPreview and reading the
+       generated buffer and peaks; the first also drains the output meter like the UI timer
+ - Paced (the default), each callback is started at its deadline like a sound card would, so
+   the other threads get the CPU time they would have in a host; free-running, callbacks run
+   back to back
+ - Every callback is timed, into a buffer sized before the audio thread starts. The result has
+   the distribution against the budget (blockSize / sampleRate) and the callbacks that overran it
+ - A fast callback isn't necessarily a good one: the result also has the blocks the processor
+   silenced while previewing (PluginProcessor::getNumSilencedPreviewBlocks) and the overruns and
+   late starts that happened while the preview played, i.e. the dropouts a user would hear. One
+   808 is generated before the audio thread starts, so a preview always has something to play
+ - The audio thread runs at normal priority, so scheduling delays weigh more than in a host
+*/
+struct HostSimulationOptions
+{
+    double sampleRate = 48000.0;
+    int blockSize = 512;
+    int numChannels = 2;
+    double seconds = 5.0;           // of audio, i.e. callbacks = seconds * sampleRate / blockSize
+    bool paced = true;              // false: free-running
+    int numTransportThreads = 2;
+    juce::int64 seed = 4900;        // of the settings generate808AndStore is called with
+};
+
+struct HostSimulationResult
+{
+    int numCallbacks = 0;
+    double budgetUs = 0.0;          // blockSize / sampleRate
+    double meanUs = 0.0, p50Us = 0.0, p99Us = 0.0, p999Us = 0.0, maxUs = 0.0;
+    int numOverruns = 0;            // callbacks that took longer than the budget
+    int numLateStarts = 0;          // paced: callbacks started a whole budget after their deadline
+    int numSilencedPreviewBlocks = 0;   // previewing, but the processor had nothing to play
+    int numPreviewUnderruns = 0;        // overruns and late starts while previewing
+    int numGenerates = 0, numFailedGenerates = 0, numPreviewToggles = 0, numReads = 0;
+    double wallSeconds = 0.0;
+
+    double getLoad() const noexcept { return budgetUs > 0.0 ? meanUs / budgetUs : 0.0; }  // mean DSP load
+    int getNumPreviewDropouts() const noexcept { return numSilencedPreviewBlocks + numPreviewUnderruns; }
+    juce::String toString() const;
+};
+
+class HostSimulator
+{
+public:
+    // blocks until every callback has run and the other threads have stopped
+    static HostSimulationResult run(const HostSimulationOptions& options);
+};
@@ -0,0 +1,264 @@
+#include <JuceHeader.h>
+
+#if JUCE_WINDOWS
+ #include <winsock2.h>
+ #include <afunix.h>
+#else
+ #include <sys/socket.h>
+ #include <sys/un.h>
+ #include <unistd.h>
+ #include <cerrno>
+#endif
+
+#include "LocalSocket.h"
+#include <cstring>
+
+using namespace juce;
+
+namespace
+{
+   #if JUCE_WINDOWS
+    using NativeHandle = SOCKET;
+    const NativeHandle invalidHandle = INVALID_SOCKET;
+
+    void closeNative(NativeHandle h)    { closesocket(h); }
+    void shutdownNative(NativeHandle h) { shutdown(h, SD_BOTH); }
+    bool interrupted()                  { return false; }
+
+    // winsock has to be started once per process; juce does the same for its own sockets
+    void startSockets()
+    {
+        static const bool started = []
+        {
+            WSADATA data;
+            return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+        }();
+        ignoreUnused(started);
+    }
+   #else
+    using NativeHandle = int;
+    const NativeHandle invalidHandle = -1;
+
+    void closeNative(NativeHandle h)    { ::close(h); }
+    void shutdownNative(NativeHandle h) { shutdown(h, SHUT_RDWR); }
+    bool interrupted()                  { return errno == EINTR; }
+    void startSockets()                 {}
+   #endif
+
+   #if JUCE_LINUX || JUCE_BSD
+    const int sendFlags = MSG_NOSIGNAL;
+   #else
+    const int sendFlags = 0;
+   #endif
+
+    NativeHandle toNative(pointer_sized_int h) { return (NativeHandle)h; }
+
+    bool makeAddress(const File& path, sockaddr_un& address, String& error)
+    {
+        const auto bytes = path.getFullPathName().toStdString();
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+
+        if (bytes.size() >= sizeof(address.sun_path))
+        {
+            error = "Socket path is too long (" + String((int)sizeof(address.sun_path) - 1) + " bytes at most): " + path.getFullPathName();
+            return false;
+        }
+
+        std::memcpy(address.sun_path, bytes.data(), bytes.size());
+        return true;
+    }
+
+    NativeHandle openSocket(String& error)
+    {
+        startSockets();
+        const auto h = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (h == invalidHandle)
+            error = "Could not create a UNIX domain socket";
+
+       #if JUCE_MAC || JUCE_IOS
+        if (h != invalidHandle)
+        {
+            int one = 1;
+            setsockopt(h, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+        }
+       #endif
+        return h;
+    }
+}
+
+LocalSocket::LocalSocket(Handle h)
+    : handle(h)
+{
+}
+
+LocalSocket::~LocalSocket()
+{
+    close();
+    closeNative(toNative(handle));
+}
+
+std::unique_ptr<LocalSocket> LocalSocket::listen(const File& path, String& error)
+{
+    sockaddr_un address;
+    if (!makeAddress(path, address, error))
+        return nullptr;
+
+    const auto h = openSocket(error);
+    if (h == invalidHandle)
+        return nullptr;
+
+    path.deleteFile();
+
+    if (bind(h, (const sockaddr*)&address, (int)sizeof(address)) != 0 || ::listen(h, SOMAXCONN) != 0)
+    {
+        error = "Could not listen on " + path.getFullPathName();
+        closeNative(h);
+        return nullptr;
+    }
+
+    return std::unique_ptr<LocalSocket>(new LocalSocket((Handle)h));
+}
+
+std::unique_ptr<LocalSocket> LocalSocket::connect(const File& path, String& error)
+{
+    sockaddr_un address;
+    if (!makeAddress(path, address, error))
+        return nullptr;
+
+    const auto h = openSocket(error);
+    if (h == invalidHandle)
+        return nullptr;
+
+    if (::connect(h, (const sockaddr*)&address, (int)sizeof(address)) != 0)
+    {
+        error = "Could not connect to " + path.getFullPathName();
+        closeNative(h);
+        return nullptr;
+    }
+
+    return std::unique_ptr<LocalSocket>(new LocalSocket((Handle)h));
+}
+
+std::unique_ptr<LocalSocket> LocalSocket::accept()
+{
+    while (!closed)
+    {
+        const auto h = ::accept(toNative(handle), nullptr, nullptr);
+        if (h != invalidHandle)
+        {
+            // the connection that woke a closed listener up isn't handed out
+            if (closed)
+            {
+                closeNative(h);
+                break;
+            }
+
+            return std::unique_ptr<LocalSocket>(new LocalSocket((Handle)h));
+        }
+        if (!interrupted())
+            break;
+    }
+
+    return nullptr;
+}
+
+bool LocalSocket::fill()
+{
+    if (pendingStart > 0)
+    {
+        pending.erase(0, pendingStart);
+        pendingStart = 0;
+    }
+
+    char chunk[65536];
+    for (;;)
+    {
+        if (closed)
+            return false;
+
+        const auto n = recv(toNative(handle), chunk, (int)sizeof(chunk), 0);
+        if (n > 0)
+        {
+            pending.append(chunk, (size_t)n);
+            return true;
+        }
+        if (n == 0 || !interrupted())
+            return false;
+    }
+}
+
+bool LocalSocket::readLine(std::string& line, size_t maxLength)
+{
+    size_t searchFrom = pendingStart;
+    for (;;)
+    {
+        const auto end = pending.find('\n', searchFrom);
+        if (end != std::string::npos)
+        {
+            line.assign(pending, pendingStart, end - pendingStart);
+            pendingStart = end + 1;
+            return line.size() <= maxLength;
+        }
+
+        if (pending.size() - pendingStart > maxLength)
+            return false;
+
+        searchFrom = pending.size() - pendingStart;  // fill() moves the unread bytes to the front
+        if (!fill())
+            return false;
+    }
+}
+
+bool LocalSocket::read(void* dest, size_t numBytes)
+{
+    auto* out = static_cast<char*>(dest);
+    while (numBytes > 0)
+    {
+        if (pendingStart == pending.size() && !fill())
+            return false;
+
+        const size_t n = jmin(numBytes, pending.size() - pendingStart);
+        std::memcpy(out, pending.data() + pendingStart, n);
+        pendingStart += n;
+        out += n;
+        numBytes -= n;
+    }
+
+    return true;
+}
+
+bool LocalSocket::write(const void* data, size_t numBytes)
+{
+    auto* in = static_cast<const char*>(data);
+    while (numBytes > 0)
+    {
+        if (closed)
+            return false;
+
+        const auto n = send(toNative(handle), in, (int)jmin(numBytes, (size_t)1 << 20), sendFlags);
+        if (n > 0)
+        {
+            in += n;
+            numBytes -= (size_t)n;
+        }
+        else if (n == 0 || !interrupted())
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool LocalSocket::writeLine(const String& line)
+{
+    const auto bytes = line.toStdString() + "\n";
+    return write(bytes.data(), bytes.size());
+}
+
+void LocalSocket::close()
+{
+    if (!closed.exchange(true))
+        shutdownNative(toNative(handle));
+}
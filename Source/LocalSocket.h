@@ -0,0 +1,54 @@
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+#include <memory>
+#include <string>
+
+/*
+ LocalSocket
+ - A UNIX domain stream socket: a listener bound to a path, or one end of a connection. juce's
+   StreamingSocket only does TCP; this never touches the network
+ - POSIX sockets on macOS/Linux, AF_UNIX winsock on Windows (Windows 10 1803 and later)
+ - Blocking reads and writes. close() may be called from another thread to wake a blocked read;
+   a blocked accept() is woken by connecting to the listener (see RenderDaemon::stop)
+ - Writing to a peer that has gone away fails instead of raising SIGPIPE
+*/
+class LocalSocket
+{
+public:
+    ~LocalSocket();
+
+    // a listener at path; a stale socket file left there by an earlier run is replaced
+    static std::unique_ptr<LocalSocket> listen(const juce::File& path, juce::String& error);
+
+    // a connection to the listener at path
+    static std::unique_ptr<LocalSocket> connect(const juce::File& path, juce::String& error);
+
+    // waits for the next connection; nullptr once the listener is closed
+    std::unique_ptr<LocalSocket> accept();
+
+    // reads up to and excluding the next '\n'; false on end of stream, error or a line longer than maxLength
+    bool readLine(std::string& line, size_t maxLength = 1 << 20);
+
+    // reads exactly numBytes (after anything readLine buffered)
+    bool read(void* dest, size_t numBytes);
+
+    bool write(const void* data, size_t numBytes);
+    bool writeLine(const juce::String& line);
+
+    // stops further reads and writes; safe to call from another thread
+    void close();
+
+private:
+    using Handle = juce::pointer_sized_int;
+
+    explicit LocalSocket(Handle h);
+    bool fill();   // reads whatever is available into pending
+
+    Handle handle;
+    std::atomic<bool> closed{ false };
+    std::string pending;   // received but not yet consumed
+    size_t pendingStart = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LocalSocket)
+};
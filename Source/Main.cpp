@@ -1,5 +1,6 @@
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "HeadlessCommands.h"
 
 // Minimal JUCEApplication that hosts the plugin editor in a window.
 class StandaloneHostApplication  : public juce::JUCEApplication
@@ -11,6 +12,15 @@ public:
 
     void initialise (const juce::String&) override
     {
+        // headless jobs (e.g. --resynth-folder) run to completion and quit without opening a window
+        const auto args = getCommandLineParameterArray();
+        if (HeadlessCommands::handles (args))
+        {
+            setApplicationReturnValue (HeadlessCommands::run (args));
+            quit();
+            return;
+        }
+
         processor = std::make_unique<PluginProcessor>();
 
         // create the plugin editor (AudioProcessorEditor*) from processor
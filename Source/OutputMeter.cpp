@@ -0,0 +1,208 @@
+#include "OutputMeter.h"
+#include "FastMath.h"
+#include <cmath>
+
+using namespace juce;
+
+namespace
+{
+    constexpr float floorDb = -100.0f;
+    constexpr double peakHoldSeconds = 1.5;
+}
+
+OutputMeter::OutputMeter()
+    : history((size_t)fftSize, 0.0f),
+      fftData((size_t)fftSize * 2, 0.0f),
+      spectrumDb((size_t)fftSize / 2, floorDb)
+{
+    fifoBuffer.clear();
+}
+
+void OutputMeter::push(const AudioBuffer<float>& buffer, int numSamples) noexcept
+{
+    const int numChannels = jmin(maxChannels, buffer.getNumChannels());
+    if (numChannels == 0 || numSamples <= 0)
+        return;
+
+    pushedChannels.store(numChannels, std::memory_order_relaxed);
+
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite(numSamples, start1, size1, start2, size2);
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        if (size1 > 0) fifoBuffer.copyFrom(ch, start1, buffer, ch, 0, size1);
+        if (size2 > 0) fifoBuffer.copyFrom(ch, start2, buffer, ch, size1, size2);
+    }
+
+    fifo.finishedWrite(size1 + size2);
+
+    if (size1 + size2 < numSamples)
+        dropped.fetch_add(numSamples - (size1 + size2), std::memory_order_relaxed);
+}
+
+bool OutputMeter::update()
+{
+    const double nowMs = Time::getMillisecondCounterHiRes();
+    const double elapsedSeconds = lastUpdateMs > 0.0 ? (nowMs - lastUpdateMs) * 0.001 : 0.0;
+    lastUpdateMs = nowMs;
+
+    // peaks fall 60 dB over the hold time, whatever the update rate; in silence they keep decaying,
+    // so keep them out of the denormal range
+    ScopedNoDenormals noDenormals;
+    const float decay = (float)std::pow(0.001, elapsedSeconds / peakHoldSeconds);
+
+    const int numChannels = pushedChannels.load(std::memory_order_relaxed);
+    levels.numChannels = numChannels;
+    levels.samplesDropped = dropped.load(std::memory_order_relaxed);
+
+    const int numReady = fifo.getNumReady();
+    if (numReady == 0 || numChannels == 0)
+    {
+        for (int ch = 0; ch < maxChannels; ++ch)
+        {
+            levels.peak[ch] *= decay;
+            levels.rms[ch] = 0.0f;
+        }
+        return false;
+    }
+
+    int start1, size1, start2, size2;
+    fifo.prepareToRead(numReady, start1, size1, start2, size2);
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        const float* data = fifoBuffer.getReadPointer(ch);
+        auto range1 = FloatVectorOperations::findMinAndMax(data + start1, size1);
+        float peak = jmax(std::abs(range1.getStart()), std::abs(range1.getEnd()));
+        double sumSq = 0.0;
+        for (int i = 0; i < size1; ++i) sumSq += (double)data[start1 + i] * data[start1 + i];
+
+        if (size2 > 0)
+        {
+            auto range2 = FloatVectorOperations::findMinAndMax(data + start2, size2);
+            peak = jmax(peak, std::abs(range2.getStart()), std::abs(range2.getEnd()));
+            for (int i = 0; i < size2; ++i) sumSq += (double)data[start2 + i] * data[start2 + i];
+        }
+
+        levels.peak[ch] = jmax(peak, levels.peak[ch] * decay);
+        levels.rms[ch] = (float)std::sqrt(sumSq / (double)numReady);
+    }
+
+    // mono mix into the spectrum history
+    auto appendMono = [this, numChannels](int start, int size)
+    {
+        for (int i = 0; i < size; ++i)
+        {
+            float sum = 0.0f;
+            for (int ch = 0; ch < numChannels; ++ch)
+                sum += fifoBuffer.getSample(ch, start + i);
+
+            history[(size_t)historyPos] = sum / (float)numChannels;
+            historyPos = (historyPos + 1) % fftSize;
+        }
+    };
+    appendMono(start1, size1);
+    appendMono(start2, size2);
+
+    fifo.finishedRead(size1 + size2);
+    levels.samplesRead += size1 + size2;
+
+    // oldest sample first
+    FloatVectorOperations::copy(fftData.data(), history.data() + historyPos, fftSize - historyPos);
+    FloatVectorOperations::copy(fftData.data() + (fftSize - historyPos), history.data(), historyPos);
+    window.multiplyWithWindowingTable(fftData.data(), (size_t)fftSize);
+    fft.performFrequencyOnlyForwardTransform(fftData.data(), true);
+
+    // full-scale sine reads 0 dB (hann coherent gain 0.5); dB = 20 * log10(2) * log2(gain).
+    // Gains are floored a dB under floorDb first so silent bins end up at exactly floorDb.
+    const float scale = 4.0f / (float)fftSize;
+    const int numBins = fftSize / 2;
+    FloatVectorOperations::multiply(fftData.data(), scale, numBins);
+    FloatVectorOperations::clip(fftData.data(), fftData.data(), std::pow(10.0f, (floorDb - 1.0f) / 20.0f), 1.0e9f, numBins);
+    FastMath::log2(fftData.data(), spectrumDb.data(), numBins, FastMath::draftAccuracy);
+    FloatVectorOperations::multiply(spectrumDb.data(), 20.0f * std::log10(2.0f), numBins);
+    FloatVectorOperations::max(spectrumDb.data(), spectrumDb.data(), floorDb, numBins);
+
+    return true;
+}
+
+float OutputMeter::getSpectrumPeakHz() const
+{
+    // skip DC
+    int best = 1;
+    for (int i = 2; i < (int)spectrumDb.size(); ++i)
+        if (spectrumDb[(size_t)i] > spectrumDb[(size_t)best])
+            best = i;
+
+    return spectrumDb[(size_t)best] > floorDb ? (float)(best * getBinHz()) : 0.0f;
+}
+
+//==============================================================================
+OutputMeterComponent::OutputMeterComponent(OutputMeter& meterToShow)
+    : meter(meterToShow)
+{
+    startTimerHz(30);
+}
+
+OutputMeterComponent::~OutputMeterComponent()
+{
+    stopTimer();
+}
+
+void OutputMeterComponent::timerCallback()
+{
+    meter.update();
+    repaint();
+}
+
+void OutputMeterComponent::paint(Graphics& g)
+{
+    auto bounds = getLocalBounds().toFloat();
+    g.setColour(Colour(0xFF1B1F23));
+    g.fillRoundedRectangle(bounds, 4.0f);
+
+    const auto& levels = meter.getLevels();
+    auto toY = [](float gain, Rectangle<float> area)
+    {
+        // -60 .. 0 dB over the bar height
+        const float db = jlimit(-60.0f, 0.0f, Decibels::gainToDecibels(gain, -60.0f));
+        return area.getBottom() - (db + 60.0f) / 60.0f * area.getHeight();
+    };
+
+    // one bar per channel: RMS filled, peak as a line
+    auto bars = bounds.removeFromLeft(26.0f).reduced(3.0f);
+    const int numBars = jmax(1, levels.numChannels);
+    const float barW = bars.getWidth() / (float)numBars;
+    for (int ch = 0; ch < levels.numChannels; ++ch)
+    {
+        auto bar = bars.withX(bars.getX() + ch * barW).withWidth(barW - 1.0f);
+        g.setColour(Colour(0xFF4DB6A9));
+        const float rmsY = toY(levels.rms[ch], bar);
+        g.fillRect(bar.withTop(rmsY));
+
+        g.setColour(levels.peak[ch] >= 1.0f ? Colours::red : Colour(0xFFD6DCE0));
+        g.fillRect(bar.withTop(toY(levels.peak[ch], bar)).withHeight(1.5f));
+    }
+
+    // spectrum on a log frequency axis, 20 Hz .. 20 kHz
+    auto area = bounds.reduced(3.0f);
+    const auto& spectrum = meter.getSpectrumDb();
+    const double binHz = meter.getBinHz();
+    if (area.getWidth() < 2.0f || spectrum.empty() || binHz <= 0.0)
+        return;
+
+    Path p;
+    for (int x = 0; x < (int)area.getWidth(); ++x)
+    {
+        const double hz = 20.0 * std::pow(1000.0, x / (double)area.getWidth());
+        const int bin = jlimit(1, (int)spectrum.size() - 1, (int)(hz / binHz));
+        const float db = jlimit(-90.0f, 0.0f, spectrum[(size_t)bin]);
+        const float y = area.getBottom() - (db + 90.0f) / 90.0f * area.getHeight();
+        if (x == 0) p.startNewSubPath(area.getX(), y);
+        else p.lineTo(area.getX() + (float)x, y);
+    }
+
+    g.setColour(Colour(0xFF4DB6A9).withAlpha(0.8f));
+    g.strokePath(p, PathStrokeType(1.2f));
+}
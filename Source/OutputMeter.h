@@ -0,0 +1,88 @@
+#pragma once
+#include <JuceHeader.h>
+#include <juce_dsp/juce_dsp.h>
+#include <vector>
+
+/*
+ OutputMeter
+ - Taps what processBlock sends out and meters it away from the audio thread
+ - push() is the producer side (audio thread): one copy into a juce::AbstractFifo, no locks,
+   no allocation; if the consumer falls behind the newest samples are dropped
+ - update() is the consumer side (message thread timer, or a headless loop): drains the FIFO,
+   computes peak / RMS per channel and an FFT spectrum of the mono mix
+ - Exactly one producer and one consumer thread; getters belong to the consumer
+*/
+class OutputMeter
+{
+public:
+    static constexpr int maxChannels = 2;
+    static constexpr int fifoSize = 1 << 15;
+    static constexpr int fftOrder = 11;
+    static constexpr int fftSize = 1 << fftOrder;
+
+    OutputMeter();
+
+    // call before audio starts (sample rate only matters for the spectrum's Hz axis)
+    void setSampleRate(double newSampleRate) { sampleRate.store(newSampleRate); }
+
+    // audio thread
+    void push(const juce::AudioBuffer<float>& buffer, int numSamples) noexcept;
+
+    // consumer thread: returns true if new samples arrived since the last call
+    bool update();
+
+    struct Levels
+    {
+        int numChannels = 0;
+        float peak[maxChannels] = {};    // linear, held with a ~1.5 s decay
+        float rms[maxChannels] = {};     // linear, over the samples read by the last update()
+        juce::int64 samplesRead = 0;     // total since construction
+        juce::int64 samplesDropped = 0;  // producer found the FIFO full
+    };
+
+    const Levels& getLevels() const noexcept { return levels; }
+
+    // magnitude in dB of the last fftSize samples of the mono mix, fftSize / 2 bins
+    const std::vector<float>& getSpectrumDb() const noexcept { return spectrumDb; }
+    double getBinHz() const noexcept { return sampleRate.load() / (double)fftSize; }
+
+    // centre of the loudest bin, 0 if silent
+    float getSpectrumPeakHz() const;
+
+private:
+    juce::AbstractFifo fifo{ fifoSize };
+    juce::AudioBuffer<float> fifoBuffer{ maxChannels, fifoSize };
+    std::atomic<int> pushedChannels{ 0 };
+    std::atomic<juce::int64> dropped{ 0 };
+    std::atomic<double> sampleRate{ 44100.0 };
+
+    // consumer side
+    Levels levels;
+    std::vector<float> history;   // mono ring, fftSize samples
+    int historyPos = 0;
+    std::vector<float> fftData;
+    std::vector<float> spectrumDb;
+    juce::dsp::FFT fft{ fftOrder };
+    juce::dsp::WindowingFunction<float> window{ (size_t)fftSize, juce::dsp::WindowingFunction<float>::hann, false };
+    double lastUpdateMs = 0.0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(OutputMeter)
+};
+
+// Peak/RMS bars plus spectrum line for an OutputMeter, updated at display rate by its own timer
+class OutputMeterComponent : public juce::Component,
+                             private juce::Timer
+{
+public:
+    explicit OutputMeterComponent(OutputMeter& meterToShow);
+    ~OutputMeterComponent() override;
+
+    void paint(juce::Graphics& g) override;
+
+private:
+    void timerCallback() override;
+
+    OutputMeter& meter;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(OutputMeterComponent)
+};
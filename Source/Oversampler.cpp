@@ -0,0 +1,182 @@
+#include "Oversampler.h"
+#include <cmath>
+
+using namespace juce;
+
+namespace
+{
+    // outer 2x stage: 135 taps, transition 0.454 - 0.546 fs; inner 4x stage: 31 taps,
+    // passband to 0.227 of its output rate with the stopband from 0.387
+    constexpr int outerHalfTaps = 34, innerHalfTaps = 8;
+    constexpr double outerBeta = 9.5, innerBeta = 9.5;
+
+    double besselI0(double x)
+    {
+        double sum = 1.0, term = 1.0;
+        for (int k = 1; k < 50 && term > 1.0e-12 * sum; ++k)
+        {
+            term *= (x * x) / (4.0 * k * k);
+            sum += term;
+        }
+        return sum;
+    }
+}
+
+Oversampler::Oversampler()
+{
+    // the filters are the same at every factor, so they're designed (and everything allocated,
+    // sized for 4x) once here and setFactor only switches between them
+    stages[0].design(outerHalfTaps, outerBeta, false, chunkSize);
+    stages[1].design(innerHalfTaps, innerBeta, false, 2 * chunkSize);
+
+    oversampled.assign((size_t)(2 * chunkSize), 0.0f);
+    inner.assign((size_t)(4 * chunkSize), 0.0f);
+    base.assign((size_t)chunkSize, 0.0f);
+
+    setFactor(4);
+    zeros.assign((size_t)latency, 0.0f);
+    setFactor(1);
+}
+
+void Oversampler::setFactor(int newFactor)
+{
+    factor = newFactor >= 4 ? 4 : (newFactor >= 2 ? 2 : 1);
+
+    // the outer stage decimates on the odd phase at 4x so the inner stage's odd latency
+    // (in 2x samples) adds up to a whole number of base-rate samples
+    stages[0].oddDelay = factor == 4;
+
+    if (factor == 1)
+        latency = 0;
+    else if (factor == 2)
+        latency = stages[0].getLatency(0);
+    else
+        latency = stages[0].getLatency(stages[1].getLatency(0));
+
+    reset();
+}
+
+void Oversampler::reset()
+{
+    stages[0].reset();
+    stages[1].reset();
+    toSkip = latency;
+}
+
+//==============================================================================
+void Oversampler::HalfBand::design(int numHalfTaps, double beta, bool oddDownsampleDelay, int maxInputSamples)
+{
+    // h[k] = 0.5 sinc(k / 2) * kaiser(k) for odd k in -(2P - 1) .. 2P - 1; even k other than 0 are zero
+    const int halfLength = 2 * numHalfTaps - 1;
+    taps.resize((size_t)numHalfTaps);
+    upTaps.resize((size_t)numHalfTaps);
+
+    double sum = 0.0;
+    std::vector<double> h((size_t)numHalfTaps);
+    for (int j = 0; j < numHalfTaps; ++j)
+    {
+        const double k = 2.0 * j + 1.0;
+        const double sinc = std::sin(MathConstants<double>::halfPi * k) / (MathConstants<double>::halfPi * k);
+        const double r = k / (halfLength + 1.0);
+        h[(size_t)j] = 0.5 * sinc * besselI0(beta * std::sqrt(1.0 - r * r)) / besselI0(beta);
+        sum += 2.0 * h[(size_t)j];
+    }
+
+    // unity gain at DC: the centre tap is 0.5, so the others have to add up to 0.5
+    for (int j = 0; j < numHalfTaps; ++j)
+    {
+        taps[(size_t)j] = (float)(h[(size_t)j] * 0.5 / sum);
+        upTaps[(size_t)j] = 2.0f * taps[(size_t)j];
+    }
+
+    oddDelay = oddDownsampleDelay;
+
+    const size_t history = (size_t)(2 * numHalfTaps - 1);
+    upInput.assign(history + (size_t)maxInputSamples, 0.0f);
+    upOdd.assign((size_t)maxInputSamples, 0.0f);
+    downEven.assign(history + (size_t)maxInputSamples, 0.0f);
+    downOdd.assign(history + (size_t)maxInputSamples, 0.0f);
+}
+
+void Oversampler::HalfBand::reset()
+{
+    std::fill(upInput.begin(), upInput.end(), 0.0f);
+    std::fill(downEven.begin(), downEven.end(), 0.0f);
+    std::fill(downOdd.begin(), downOdd.end(), 0.0f);
+}
+
+int Oversampler::HalfBand::getLatency(int innerLatency) const noexcept
+{
+    // up: P input samples; down: the centre tap sits 2P - 2 (2P - 1 with oddDelay) 2x samples back
+    const int numTaps = (int)taps.size();
+    const int downDelay = 2 * numTaps - (oddDelay ? 1 : 2);
+    jassert((innerLatency + downDelay) % 2 == 0);
+    return numTaps + (innerLatency + downDelay) / 2;
+}
+
+void Oversampler::HalfBand::upsample(const float* in, int num, float* out)
+{
+    // With P = taps.size() and x[] = history + block, output pair i is
+    //   even: x[i + P - 1]                                 (the centre tap, a plain delay)
+    //   odd:  sum over j of 2 h_j (x[i + P - j] + x[i + P - 1 + j])
+    const int numTaps = (int)taps.size();
+    const int history = 2 * numTaps - 1;
+    float* x = upInput.data();
+    float* odd = upOdd.data();
+
+    std::copy(in, in + num, x + history);
+    std::fill(odd, odd + num, 0.0f);
+
+    for (int j = 1; j <= numTaps; ++j)
+    {
+        const float g = upTaps[(size_t)j - 1];
+        const float* a = x + numTaps - j;
+        const float* b = x + numTaps - 1 + j;
+        for (int i = 0; i < num; ++i)
+            odd[i] += g * (a[i] + b[i]);
+    }
+
+    const float* even = x + numTaps - 1;
+    for (int i = 0; i < num; ++i)
+    {
+        out[2 * i] = even[i];
+        out[2 * i + 1] = odd[i];
+    }
+
+    std::copy(x + num, x + num + history, x);
+}
+
+void Oversampler::HalfBand::downsample(const float* in, int num, float* out)
+{
+    // With P = taps.size() and the input split into even/odd phases (history + block), output i is
+    //   0.5 centre[i + P - 1 + shift] + sum over j of h_j (other[i + P - j] + other[i + P - 1 + j])
+    // where the centre is the even phase (shift 1) or, with oddDelay, the odd phase (shift 0)
+    const int numTaps = (int)taps.size();
+    const int history = 2 * numTaps - 1;
+    float* even = downEven.data();
+    float* odd = downOdd.data();
+
+    for (int i = 0; i < num; ++i)
+    {
+        even[history + i] = in[2 * i];
+        odd[history + i] = in[2 * i + 1];
+    }
+
+    const float* centre = oddDelay ? odd + numTaps - 1 : even + numTaps;
+    const float* other = oddDelay ? even : odd;
+
+    for (int i = 0; i < num; ++i)
+        out[i] = 0.5f * centre[i];
+
+    for (int j = 1; j <= numTaps; ++j)
+    {
+        const float h = taps[(size_t)j - 1];
+        const float* a = other + numTaps - j;
+        const float* b = other + numTaps - 1 + j;
+        for (int i = 0; i < num; ++i)
+            out[i] += h * (a[i] + b[i]);
+    }
+
+    std::copy(even + num, even + num + history, even);
+    std::copy(odd + num, odd + num + history, odd);
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+#include <functional>
+
+// Run job(0) ... job(numItems - 1) on a temporary juce::ThreadPool (or one the caller keeps, to skip
+// starting threads every time) and block until all have finished.
+// numThreads <= 0 means one thread per CPU core. Jobs must not throw.
+// Jobs run with denormals flushed to zero (juce::ScopedNoDenormals), like the audio thread.
+struct ParallelJobs
+{
+    static int resolveThreadCount(int numThreads)
+    {
+        return numThreads > 0 ? numThreads : juce::jmax(1, juce::SystemStats::getNumCpus());
+    }
+
+    static void run(int numItems, int numThreads, const std::function<void(int index)>& job)
+    {
+        if (numItems <= 0)
+            return;
+
+        juce::ThreadPool pool(juce::jmin(resolveThreadCount(numThreads), numItems));
+        run(pool, numItems, job);
+    }
+
+    static void run(juce::ThreadPool& pool, int numItems, const std::function<void(int index)>& job)
+    {
+        if (numItems <= 0)
+            return;
+
+        std::atomic<int> retired{ 0 };
+        juce::WaitableEvent allDone;
+
+        for (int i = 0; i < numItems; ++i)
+        {
+            pool.addJob([&, i]()
+            {
+                juce::ScopedNoDenormals noDenormals;
+                job(i);
+                if (++retired == numItems)
+                    allDone.signal();
+            });
+        }
+
+        allDone.wait();
+    }
+};
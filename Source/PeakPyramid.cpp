@@ -0,0 +1,202 @@
+#include "PeakPyramid.h"
+#include <limits>
+
+using namespace juce;
+
+void PeakPyramid::build(const AudioBuffer<float>& buffer)
+{
+    // the arrays of an earlier build are reused (levels only ever grows; numLevels are in use), so
+    // rebuilding a pooled pyramid for a buffer no longer than its last one doesn't allocate
+    numLevels = 0;
+    numSamples = buffer.getNumSamples();
+
+    const int numChannels = buffer.getNumChannels();
+    if (numSamples == 0 || numChannels == 0)
+        return;
+
+    auto nextLevel = [this](int numBlocks) -> std::vector<Peak>&
+    {
+        if ((int)levels.size() <= numLevels)
+            levels.emplace_back();
+        auto& level = levels[(size_t)numLevels++];
+        level.resize((size_t)numBlocks);
+        return level;
+    };
+
+    // level 0 straight from the samples
+    const int numBlocks = (int)((numSamples + baseBlockSize - 1) / baseBlockSize);
+    auto& base = nextLevel(numBlocks);
+
+    for (int b = 0; b < numBlocks; ++b)
+    {
+        const int start = b * baseBlockSize;
+        const int count = (int)jmin<int64>(baseBlockSize, numSamples - start);
+
+        float lo = std::numeric_limits<float>::max();
+        float hi = std::numeric_limits<float>::lowest();
+        double sumSq = 0.0;
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            const float* data = buffer.getReadPointer(ch, start);
+            for (int i = 0; i < count; ++i)
+            {
+                lo = jmin(lo, data[i]);
+                hi = jmax(hi, data[i]);
+                sumSq += (double)data[i] * data[i];
+            }
+        }
+
+        base[(size_t)b] = { lo, hi, (float)(sumSq / (double)(count * numChannels)) };
+    }
+
+    // each further level merges levelFactor blocks of the one below
+    while (levels[(size_t)numLevels - 1].size() > 1)
+    {
+        const int n = (int)levels[(size_t)numLevels - 1].size();
+        auto& next = nextLevel((n + levelFactor - 1) / levelFactor);
+        const auto& below = levels[(size_t)numLevels - 2];  // after nextLevel, which may grow levels
+
+        for (int b = 0; b < (int)next.size(); ++b)
+        {
+            const int first = b * levelFactor;
+            next[(size_t)b] = merge(below.data() + first, jmin(levelFactor, n - first));
+        }
+    }
+}
+
+PeakPyramid::Peak PeakPyramid::merge(const Peak* blocks, int count)
+{
+    Peak p = blocks[0];
+    for (int i = 1; i < count; ++i)
+    {
+        p.min = jmin(p.min, blocks[i].min);
+        p.max = jmax(p.max, blocks[i].max);
+        p.meanSquare += blocks[i].meanSquare;
+    }
+    p.meanSquare /= (float)count;
+    return p;
+}
+
+PeakPyramid::Peak PeakPyramid::getPeak(int64 start, int64 end) const
+{
+    start = jmax<int64>(0, start);
+    end = jmin(end, numSamples);
+    if (numLevels == 0 || end <= start)
+        return {};
+
+    // coarsest level whose blocks still fit inside the range: at most levelFactor + 1 blocks to merge
+    const int64 length = end - start;
+    int level = 0;
+    int64 blockSize = baseBlockSize;
+    while (level + 1 < numLevels && blockSize * levelFactor <= length)
+    {
+        blockSize *= levelFactor;
+        ++level;
+    }
+
+    const auto& blocks = levels[(size_t)level];
+    const int first = (int)(start / blockSize);
+    const int last = jmin((int)blocks.size() - 1, (int)((end - 1) / blockSize));
+    return merge(blocks.data() + first, last - first + 1);
+}
+
+void PeakPyramid::draw(Graphics& g, Rectangle<int> area, const PeakPyramid& peaks,
+                       const AudioBuffer<float>* raw, int64 startSample, int64 numSamplesToShow, Colour colour)
+{
+    const int w = area.getWidth();
+    if (w <= 0 || numSamplesToShow <= 0 || peaks.getNumSamples() == 0)
+        return;
+
+    const float centreY = (float)area.getCentreY();
+    const float halfHeight = (float)area.getHeight() * 0.45f;
+    const double samplesPerPixel = (double)numSamplesToShow / (double)w;
+    const bool useRaw = raw != nullptr && raw->getNumSamples() == peaks.getNumSamples()
+                        && samplesPerPixel < (double)baseBlockSize;
+
+    const Colour bodyColour = colour.withMultipliedAlpha(0.55f);
+
+    for (int x = 0; x < w; ++x)
+    {
+        int64 s0 = startSample + (int64)(x * samplesPerPixel);
+        int64 s1 = jmax(s0 + 1, startSample + (int64)((x + 1) * samplesPerPixel));
+
+        Peak p;
+        if (useRaw)
+        {
+            // zoomed in past the pyramid: scan the few samples directly, including the previous one so
+            // neighbouring columns join up instead of leaving gaps
+            s0 = jmax<int64>(0, s0 - 1);
+            s1 = jmin(s1, peaks.getNumSamples());
+            if (s1 <= s0)
+                continue;
+
+            p.min = std::numeric_limits<float>::max();
+            p.max = std::numeric_limits<float>::lowest();
+            double sumSq = 0.0;
+            for (int ch = 0; ch < raw->getNumChannels(); ++ch)
+            {
+                const float* data = raw->getReadPointer(ch);
+                for (int64 i = s0; i < s1; ++i)
+                {
+                    p.min = jmin(p.min, data[i]);
+                    p.max = jmax(p.max, data[i]);
+                    sumSq += (double)data[i] * data[i];
+                }
+            }
+            p.meanSquare = (float)(sumSq / (double)((s1 - s0) * raw->getNumChannels()));
+        }
+        else
+        {
+            p = peaks.getPeak(s0, s1);
+        }
+
+        const float px = (float)(area.getX() + x);
+        const float top = centreY - jlimit(-1.0f, 1.0f, p.max) * halfHeight;
+        const float bottom = centreY - jlimit(-1.0f, 1.0f, p.min) * halfHeight;
+        g.setColour(bodyColour);
+        g.fillRect(px, top, 1.0f, jmax(1.0f, bottom - top));
+
+        // RMS band, kept inside the min/max bar
+        const float r = p.rms();
+        const float rmsTop = jmax(top, centreY - jmin(1.0f, r) * halfHeight);
+        const float rmsBottom = jmin(bottom, centreY + jmin(1.0f, r) * halfHeight);
+        if (rmsBottom > rmsTop)
+        {
+            g.setColour(colour);
+            g.fillRect(px, rmsTop, 1.0f, rmsBottom - rmsTop);
+        }
+    }
+}
+
+void WaveformImageCache::draw(Graphics& g, Rectangle<int> area, const PeakPyramid& peaks,
+                              const AudioBuffer<float>* raw, int64 startSample, int64 numSamplesToShow, Colour colour)
+{
+    if (area.isEmpty())
+        return;
+
+    // render at physical resolution so columns stay one device pixel wide on hi-dpi screens
+    const float scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+
+    if (!image.isValid() || cachedPeaks != &peaks || cachedArea != area || cachedStart != startSample
+        || cachedLength != numSamplesToShow || cachedColour != colour || cachedScale != scale)
+    {
+        const int iw = jmax(1, roundToInt((float)area.getWidth() * scale));
+        const int ih = jmax(1, roundToInt((float)area.getHeight() * scale));
+
+        image = Image(Image::ARGB, iw, ih, true);
+        {
+            Graphics ig(image);
+            PeakPyramid::draw(ig, { 0, 0, iw, ih }, peaks, raw, startSample, numSamplesToShow, colour);
+        }
+
+        cachedPeaks = &peaks;
+        cachedArea = area;
+        cachedStart = startSample;
+        cachedLength = numSamplesToShow;
+        cachedColour = colour;
+        cachedScale = scale;
+    }
+
+    g.drawImage(image, area.toFloat());
+}
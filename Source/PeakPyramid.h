@@ -0,0 +1,77 @@
+#pragma once
+#include <JuceHeader.h>
+#include <vector>
+
+/*
+ PeakPyramid
+ - Multi-resolution min/max/RMS summary of an audio buffer for waveform displays
+ - Level 0 summarises blocks of baseBlockSize samples, every further level merges levelFactor blocks,
+   so any view range is answered from the coarsest level that still has a block per pixel
+ - Build it once per buffer (PluginProcessor does it right after rendering) and share it read-only;
+   getPeak() is const and can be called from any thread. build() reuses the storage of an earlier
+   build, so PluginProcessor keeps a pool of pyramids no reader holds any more
+ - Channels are folded together: min/max over all channels, mean square averaged
+*/
+class PeakPyramid
+{
+public:
+    static constexpr int baseBlockSize = 16;
+    static constexpr int levelFactor = 4;
+
+    struct Peak
+    {
+        float min = 0.0f;
+        float max = 0.0f;
+        float meanSquare = 0.0f;
+
+        float rms() const { return std::sqrt(meanSquare); }
+    };
+
+    PeakPyramid() = default;
+    explicit PeakPyramid(const juce::AudioBuffer<float>& buffer) { build(buffer); }
+
+    void build(const juce::AudioBuffer<float>& buffer);
+
+    juce::int64 getNumSamples() const { return numSamples; }
+    int getNumLevels() const { return numLevels; }
+
+    // summary of samples [start, end); block edges are rounded outwards, which is below a pixel at any zoom
+    // the pyramid picks. Returns a zero peak for an empty range.
+    Peak getPeak(juce::int64 start, juce::int64 end) const;
+
+    // one column per pixel of area, min..max as a bar with the RMS band drawn brighter on top.
+    // When a pixel covers fewer than baseBlockSize samples and `raw` is given, the raw samples are used.
+    static void draw(juce::Graphics& g, juce::Rectangle<int> area, const PeakPyramid& peaks,
+                     const juce::AudioBuffer<float>* raw, juce::int64 startSample, juce::int64 numSamplesToShow,
+                     juce::Colour colour);
+
+private:
+    static Peak merge(const Peak* blocks, int count);
+
+    std::vector<std::vector<Peak>> levels;  // the first numLevels are this buffer's
+    int numLevels = 0;
+    juce::int64 numSamples = 0;
+};
+
+/*
+ WaveformImageCache
+ - Keeps the last drawn waveform as an image and only redraws it when the pyramid, view range,
+   size, colour or display scale changed; repaints for anything else are a single image blit
+*/
+class WaveformImageCache
+{
+public:
+    void invalidate() { image = {}; }
+
+    void draw(juce::Graphics& g, juce::Rectangle<int> area, const PeakPyramid& peaks,
+              const juce::AudioBuffer<float>* raw, juce::int64 startSample, juce::int64 numSamplesToShow,
+              juce::Colour colour);
+
+private:
+    juce::Image image;
+    const PeakPyramid* cachedPeaks = nullptr;
+    juce::Rectangle<int> cachedArea;
+    juce::int64 cachedStart = 0, cachedLength = 0;
+    juce::Colour cachedColour;
+    float cachedScale = 0.0f;
+};
@@ -2,16 +2,22 @@
 #include "DescriptorWindow.h"
 #include "BatchWindow.h"
 #include "ResynthesisWindow.h"
+#include "SimilaritySearch.h"
 
 PluginEditor::PluginEditor (PluginProcessor& p)
-    : AudioProcessorEditor (&p), processor (p)
+    : AudioProcessorEditor (&p), outputMeterView (p.getOutputMeter()), processor (p)
 {
+    oversampling = processor.getLastParams().oversampling;
+    autoLength = processor.getLastParams().autoLength;
+
     setSize (600, 600);
     setResizable(true, true);
 	setResizeLimits(400, 400, 800, 800);
 
     // waveform
     addAndMakeVisible(waveform);
+    addAndMakeVisible(spectrogram);
+    addAndMakeVisible(outputMeterView);
 
     // generate button
     addAndMakeVisible(generateButton);
@@ -39,6 +45,8 @@ PluginEditor::PluginEditor (PluginProcessor& p)
 
     addAndMakeVisible(copySeedButton);
     copySeedButton.addListener(this);
+    addAndMakeVisible(pasteSeedButton);
+    pasteSeedButton.addListener(this);
 
     // tune knob (RegeneratingSlider) - detect mouseUp to regenerate once user finishes dragging
     tuneSlider.setSliderStyle(juce::Slider::RotaryVerticalDrag);
@@ -50,7 +58,8 @@ PluginEditor::PluginEditor (PluginProcessor& p)
 
     tuneSlider.setMouseUpCallback([this]()
     {
-        regenerateFromCurrentUI();
+        stopTimer();
+        startFullRender();
     });
 
     addAndMakeVisible(tuneLabel);
@@ -65,6 +74,7 @@ PluginEditor::PluginEditor (PluginProcessor& p)
     // create windows but don't open them yet
     descriptorWindow.reset(new DescriptorWindow(processor));
     batchWindow.reset(new BatchWindow(processor));
+    resynthesisWindow.reset(new ResynthesisWindow(processor));
 
     // colors & fonts
     setOpaque(true);
@@ -73,10 +83,12 @@ PluginEditor::PluginEditor (PluginProcessor& p)
 
 PluginEditor::~PluginEditor()
 {
+    stopTimer();
     generateButton.removeListener(this);
     exportButton.removeListener(this);
     previewToggle.removeListener(this);
     copySeedButton.removeListener(this);
+    pasteSeedButton.removeListener(this);
     tuneSlider.removeListener(this);
     mainMenuBtn.removeListener(this);
 }
@@ -117,7 +129,9 @@ void PluginEditor::resized()
     noteLabel.setBounds(leftCol.removeFromTop(80));
     generateButton.setBounds(leftCol.removeFromTop(48).reduced(0, 8));
     seedLabel.setBounds(leftCol.removeFromTop(24));
-    copySeedButton.setBounds(leftCol.removeFromTop(36).withSizeKeepingCentre(120, 24));
+    auto seedButtons = leftCol.removeFromTop(36);
+    copySeedButton.setBounds(seedButtons.removeFromLeft(seedButtons.getWidth() / 2).withSizeKeepingCentre(120, 24));
+    pasteSeedButton.setBounds(seedButtons.withSizeKeepingCentre(120, 24));
 
     tuneSlider.setBounds(rightCol.removeFromTop(160).reduced(24));
     tuneLabel.setBounds(rightCol.removeFromTop(24));
@@ -125,37 +139,143 @@ void PluginEditor::resized()
     // bottom area: preview toggle and export
     auto bottom = r.removeFromBottom(120);
     previewToggle.setBounds(bottom.removeFromLeft(120).reduced(8));
+    outputMeterView.setBounds(bottom.removeFromRight(160).reduced(8));
     exportButton.setBounds(bottom.reduced(8).withHeight(48).withWidth(160).withX(bottom.getCentreX()-80));
+
+    // whatever is left between the controls and the bottom row
+    spectrogram.setBounds(r.reduced(0, 4));
 }
 
 void PluginEditor::updateWaveformFromProcessor()
 {
-    currentGeneratedBufferPtr = processor.getGeneratedBufferSharedPtr();
+    // one read, so the peaks always belong to the buffer even if a render is published meanwhile
+    auto sound = processor.getGeneratedSound();
+    currentGeneratedBufferPtr = sound.buffer;
 
     if (currentGeneratedBufferPtr && currentGeneratedBufferPtr->getNumSamples() > 0)
     {
-        waveform.setBuffer(currentGeneratedBufferPtr.get());
-        seedLabel.setText("Seed: " + juce::String((int64_t)processor.getLastParams().seed), juce::dontSendNotification);
+        waveform.setBuffer(currentGeneratedBufferPtr.get(), std::move(sound.peaks));
+        spectrogram.setBuffer(std::shared_ptr<const juce::AudioBuffer<float>>(currentGeneratedBufferPtr), processor.getLastParams().sampleRate);
+        // Copy Seed copies this text, so the engine version travels with the seed (see Generator808::getEngineVersions)
+        seedLabel.setText(Generator808::formatSeed(processor.getLastParams().seed, processor.getLastParams().engineVersion), juce::dontSendNotification);
         noteLabel.setText("Tune " + juce::String(processor.getLastParams().tuneSemitones, 2) + " st", juce::dontSendNotification);
     }
     else
     {
         waveform.setBuffer(nullptr);
+        spectrogram.clear();
         seedLabel.setText("Seed: -", juce::dontSendNotification);
         noteLabel.setText("C1", juce::dontSendNotification);
     }
 }
 
 void PluginEditor::regenerateFromCurrentUI()
+{
+    generateAndShow(makeParamsFromUI(true));
+}
+
+void PluginEditor::generateAndShow(const GeneratorParams& params)
+{
+    ++renderGeneration; // a pending tune render must not overwrite this one
+
+    bool ok = processor.generate808AndStore(params);
+    if (ok)
+    {
+        updateWaveformFromProcessor();
+        if (previewToggle.getToggleState())
+            processor.startPreview();
+    }
+    else
+    {
+        juce::AlertWindow::showMessageBoxAsync(juce::AlertWindow::WarningIcon, "Error", "Generation failed.");
+    }
+}
+
+bool PluginEditor::parseSeed(const juce::String& text, int64_t& seed, int& engineVersion)
+{
+    auto rest = text.trim();
+    if (rest.startsWithIgnoreCase("Seed:"))
+        rest = rest.substring(5).trimStart();
+
+    const auto number = rest.initialSectionContainingOnly("-0123456789");
+    int64_t parsed = 0;
+    if (!Generator808::parseSeed(number, parsed))
+        return false;
+
+    // then "(engine vK)", or nothing for a seed copied before there were versions
+    rest = rest.substring(number.length()).trim();
+    int version = 1;
+    if (rest.isNotEmpty())
+    {
+        if (!rest.startsWithIgnoreCase("(engine v") || !rest.endsWithChar(')'))
+            return false;
+
+        const auto versionText = rest.substring(9).dropLastCharacters(1).trim();
+        if (versionText.isEmpty() || !versionText.containsOnly("0123456789") || versionText.length() > 6)
+            return false;
+        version = versionText.getIntValue();
+    }
+
+    seed = parsed;
+    engineVersion = version;
+    return true;
+}
+
+void PluginEditor::pasteSeed()
+{
+    int64_t seed = 0;
+    int engineVersion = 1;
+    if (!parseSeed(juce::SystemClipboard::getTextFromClipboard(), seed, engineVersion))
+    {
+        juce::AlertWindow::showMessageBoxAsync(juce::AlertWindow::WarningIcon, "Paste Seed",
+                                               "The clipboard doesn't hold a seed, like \"Seed: 12345 (engine v"
+                                               + juce::String(GeneratorParams::latestEngineVersion) + ")\".");
+        return;
+    }
+
+    if (engineVersion < 1 || engineVersion > GeneratorParams::latestEngineVersion)
+    {
+        juce::AlertWindow::showMessageBoxAsync(juce::AlertWindow::WarningIcon, "Paste Seed",
+                                               "That seed was made with engine v" + juce::String(engineVersion)
+                                               + "; this version of 808orade has v1 to v" + juce::String(GeneratorParams::latestEngineVersion) + ".");
+        return;
+    }
+
+    // the current settings, as for a retune, with the pasted seed and its engine
+    auto params = makeParamsFromUI(false);
+    params.seed = seed;
+    params.engineVersion = engineVersion;
+    generateAndShow(params);
+}
+
+GeneratorParams PluginEditor::makeParamsFromUI(bool newSeed)
 {
     GeneratorParams gp;
     const auto& last = processor.getLastParams();
     gp = last;
+
+    // A retune is the current 808 with only the knobs changed. Its keyword boosts are already
+    // in last; merging them again would add gain and sub on every tune edit
+    if (!newSeed)
+    {
+        gp.tuneSemitones = (float)tuneSlider.getValue();
+        gp.oversampling = oversampling;
+        gp.autoLength = autoLength;
+        if (gp.sampleRate <= 0.0)
+            gp.sampleRate = processor.getSampleRate() > 0.0 ? processor.getSampleRate() : 44100.0;
+        if (gp.lengthSeconds <= 0.0)
+            gp.lengthSeconds = 1.6;
+        return gp;
+    }
+
     gp.seed = (int64_t)std::chrono::high_resolution_clock::now().time_since_epoch().count();
+    gp.engineVersion = GeneratorParams::latestEngineVersion; // a new 808: the current engine
     gp.sampleRate = processor.getSampleRate() > 0.0 ? processor.getSampleRate() : 44100.0;
     gp.lengthSeconds = last.lengthSeconds > 0.0 ? last.lengthSeconds : 1.6;
     gp.tuneSemitones = (float)tuneSlider.getValue();
     gp.masterGainDb = last.masterGainDb;
+    gp.oversampling = oversampling;
+    gp.autoLength = autoLength;
 
     // If descriptor window exists and user has selected keywords, merge them into params
     if (descriptorWindow)
@@ -192,17 +312,57 @@ void PluginEditor::regenerateFromCurrentUI()
     if (std::isnan(gp.boomAmount) || gp.boomAmount < 0.0f) gp.boomAmount = 0.4f;
     if (std::isnan(gp.punch) || gp.punch < 0.0f) gp.punch = 0.55f;
 
-    bool ok = processor.generate808AndStore(gp);
-    if (ok)
-    {
-        updateWaveformFromProcessor();
-        if (previewToggle.getToggleState())
-            processor.startPreview();
-    }
-    else
+    return gp;
+}
+
+void PluginEditor::renderTuneDraft()
+{
+    // same seed as the current 808, so the draft is that 808 retuned
+    auto gp = makeParamsFromUI(false);
+    ++renderGeneration;
+
+    constexpr double draftSeconds = 1.0;
+    draftBufferPtr = draftContext.renderDraft(gp, draftSeconds);
+    waveform.setDraftBuffer(draftBufferPtr.get(), (float)juce::jmin(1.0, draftSeconds / juce::jmax(0.001, gp.lengthSeconds)));
+}
+
+void PluginEditor::timerCallback()
+{
+    stopTimer();
+    startFullRender();
+}
+
+void PluginEditor::startFullRender()
+{
+    if (processor.getGeneratedBufferSharedPtr() == nullptr)
+        return;
+
+    auto gp = makeParamsFromUI(false);
+    const auto generation = ++renderGeneration;
+
+    juce::Component::SafePointer<PluginEditor> safeThis(this);
+    juce::Thread::launch([safeThis, gp, generation, worker = workerContext]()
     {
-        juce::AlertWindow::showMessageBoxAsync(juce::AlertWindow::WarningIcon, "Error", "Generation failed.");
-    }
+        // the processor's context belongs to the message thread
+        std::shared_ptr<juce::AudioBuffer<float>> buf;
+        {
+            std::lock_guard<std::mutex> lock(worker->lock);
+            buf = worker->context.render(gp);
+        }
+
+        juce::MessageManager::callAsync([safeThis, gp, generation, buf]()
+        {
+            // a newer draft or render has been requested since: drop this one
+            if (safeThis == nullptr || safeThis->renderGeneration != generation)
+                return;
+
+            safeThis->processor.storeGenerated(gp, buf);
+            safeThis->draftBufferPtr.reset();
+            safeThis->updateWaveformFromProcessor();
+            if (safeThis->previewToggle.getToggleState())
+                safeThis->processor.startPreview();
+        });
+    });
 }
 
 void PluginEditor::buttonClicked(juce::Button* b)
@@ -240,6 +400,10 @@ void PluginEditor::buttonClicked(juce::Button* b)
     {
         juce::SystemClipboard::copyTextToClipboard(seedLabel.getText());
     }
+    else if (b == &pasteSeedButton)
+    {
+        pasteSeed();
+    }
     else if (b == &previewToggle)
     {
         if (previewToggle.getToggleState())
@@ -258,6 +422,13 @@ void PluginEditor::sliderValueChanged(juce::Slider* s)
     if (s == &tuneSlider)
     {
         noteLabel.setText("Tune " + juce::String(tuneSlider.getValue(), 2) + " st", juce::dontSendNotification);
+
+        // drafts only make sense once there is an 808 to retune
+        if (processor.getGeneratedBufferSharedPtr() != nullptr)
+        {
+            renderTuneDraft();
+            startTimer(settleMs);
+        }
     }
 }
 
@@ -268,6 +439,13 @@ void PluginEditor::showMainMenu()
     pm.addItem(2, "Resynthesis...");
     pm.addItem(3, "Batch Exporter...");
     pm.addItem(4, "Settings...");
+    pm.addItem(5, "Find Similar 808s...");
+
+    juce::PopupMenu oversamplingMenu;
+    for (int factor : { 1, 2, 4 })
+        oversamplingMenu.addItem(10 + factor, factor == 1 ? juce::String("Off") : juce::String(factor) + "x", true, oversampling == factor);
+    pm.addSubMenu("Oversampling", oversamplingMenu);
+    pm.addItem(6, "Trim Silent Tail", true, autoLength);
 
     pm.showMenuAsync(juce::PopupMenu::Options(),
         [this](int result)
@@ -284,11 +462,51 @@ void PluginEditor::showMainMenu()
         }
         else if (result == 2)
         {
-            juce::AlertWindow::showMessageBoxAsync(juce::AlertWindow::InfoIcon, "Resynthesis", "Open the Resynthesis window from the menu (coming soon).");
+            if (resynthesisWindow)
+                resynthesisWindow->open();
         }
         else if (result == 4)
         {
             juce::AlertWindow::showMessageBoxAsync(juce::AlertWindow::InfoIcon, "Settings", "Settings window not implemented yet.");
         }
+        else if (result == 5)
+        {
+            findSimilarToCurrent();
+        }
+        else if (result == 6)
+        {
+            autoLength = !autoLength;
+            startFullRender();
+        }
+        else if (result > 10 && result <= 14)
+        {
+            // re-render the current 808 with the new factor
+            oversampling = result - 10;
+            startFullRender();
+        }
+    });
+}
+
+void PluginEditor::findSimilarToCurrent()
+{
+    AudioFeatures query;
+    if (!processor.analyzeCurrentRender(query))
+    {
+        juce::AlertWindow::showMessageBoxAsync(juce::AlertWindow::WarningIcon, "Find Similar", "Generate an 808 first.");
+        return;
+    }
+
+    // library scan + seed bank run off the message thread; the seed bank dominates the time
+    auto seedParams = processor.getLastParams();
+    juce::Thread::launch([query, seedParams]()
+    {
+        FeatureIndex index;
+        auto results = SimilaritySearch::findSimilar(query, SimilaritySearch::fromFeatureIndex(index), seedParams, 256, 8);
+        auto text = results.describe(index);
+
+        juce::MessageManager::callAsync([text]()
+        {
+            juce::AlertWindow::showMessageBoxAsync(juce::AlertWindow::InfoIcon, "Similar 808s", text);
+        });
     });
 }
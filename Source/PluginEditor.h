@@ -1,44 +1,65 @@
 #pragma once
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "PeakPyramid.h"
+#include "SpectrogramComponent.h"
+#include "RenderContext.h"
 // forward-declare window types to avoid include cycles
 class DescriptorWindow;
 class BatchWindow;
 class ResynthesisWindow;
 #include <memory>
 #include <functional>
+#include <mutex>
 
-// Minimal WaveformComponent used by the editor.
-// Replace with your real waveform drawing implementation later.
+// WaveformComponent used by the editor.
+// Draws min/max/RMS columns from a PeakPyramid through a cached image, so a repaint is a blit.
 class WaveformComponent : public juce::Component
 {
 public:
     WaveformComponent() = default;
-    void setBuffer(juce::AudioBuffer<float>* b) { buf = b; repaint(); }
+
+    // pass the pyramid published with the buffer if there is one; otherwise it's built here
+    void setBuffer(juce::AudioBuffer<float>* b, std::shared_ptr<const PeakPyramid> p = nullptr)
+    {
+        buf = b;
+        peaks = std::move(p);
+        if (buf == nullptr)
+            peaks.reset();
+        else if (peaks == nullptr || peaks->getNumSamples() != buf->getNumSamples())
+            peaks = std::make_shared<const PeakPyramid>(*buf);
+        draftCoverage = 0.0f;
+        cache.invalidate();
+        repaint();
+    }
+
+    // a draft render: shown dimmed over the first `coverage` of the width (drafts may be shorter)
+    void setDraftBuffer(juce::AudioBuffer<float>* b, float coverage)
+    {
+        setBuffer(b);
+        draftCoverage = juce::jlimit(0.0f, 1.0f, coverage);
+    }
+
     void paint(juce::Graphics& g) override
     {
-        // draw a simple waveform without an opaque background rectangle
-        if (!buf || buf->getNumSamples() == 0) return;
-        g.setColour(juce::Colour(0xFF4DB6A9));
-        auto bounds = getLocalBounds().toFloat().reduced(4.0f);
-        const int w = bounds.getWidth();
-        const int h = bounds.getHeight();
-        const int numSamples = buf->getNumSamples();
-
-        juce::Path p;
-        p.startNewSubPath(bounds.getX(), bounds.getCentreY());
-        for (int x = 0; x < w; ++x)
+        // draw the waveform without an opaque background rectangle
+        if (!buf || !peaks || buf->getNumSamples() == 0) return;
+
+        auto area = getLocalBounds().reduced(4);
+        auto colour = juce::Colour(0xFF4DB6A9);
+        if (draftCoverage > 0.0f)
         {
-            int sampleIndex = juce::jlimit(0, numSamples - 1, (int)((double)x / (double)w * (double)numSamples));
-            float v = buf->getSample(0, sampleIndex);
-            float y = bounds.getCentreY() - v * (h * 0.45f);
-            p.lineTo(bounds.getX() + (float)x, y);
+            area = area.withWidth(juce::roundToInt((float)area.getWidth() * draftCoverage));
+            colour = colour.withMultipliedAlpha(0.6f);
         }
-        g.strokePath(p, juce::PathStrokeType(1.2f));
+        cache.draw(g, area, *peaks, buf, 0, buf->getNumSamples(), colour);
     }
 
 private:
     juce::AudioBuffer<float>* buf { nullptr };
+    std::shared_ptr<const PeakPyramid> peaks;
+    WaveformImageCache cache;
+    float draftCoverage = 0.0f; // 0 = not a draft
 };
 
 // RegeneratingSlider wraps juce::Slider and notifies when mouseUp occurs.
@@ -66,7 +87,8 @@ private:
 // The main plugin editor
 class PluginEditor  : public juce::AudioProcessorEditor,
                       private juce::Button::Listener,
-                      private juce::Slider::Listener
+                      private juce::Slider::Listener,
+                      private juce::Timer
 {
 public:
     PluginEditor (PluginProcessor&);
@@ -78,6 +100,8 @@ public:
 private:
     // UI controls (kept from previous implementation)
     WaveformComponent waveform;
+    SpectrogramComponent spectrogram;
+    OutputMeterComponent outputMeterView; // reads the processor's output FIFO on its own timer
     juce::Image logoImage;
     juce::TextButton generateButton { "GENERATE 808" };
     juce::TextButton exportButton { "EXPORT" };
@@ -85,6 +109,7 @@ private:
     juce::Label noteLabel;
     juce::Label seedLabel;
     juce::TextButton copySeedButton { "Copy Seed" };
+    juce::TextButton pasteSeedButton { "Paste Seed" };
     RegeneratingSlider tuneSlider;
     juce::Label tuneLabel;
     // ownership for popup windows (add to your editor class members)
@@ -126,6 +151,40 @@ private:
 
     // regenerate helper (collects UI values -> params -> generate)
     void regenerateFromCurrentUI();
+    void generateAndShow(const GeneratorParams& params);
+
+    // reads Copy Seed's text (Generator808::formatSeed), "Seed: N (engine vK)"; also takes "Seed: N"
+    // and a bare N, copied before engine versions existed, as v1; false if the text isn't a seed
+    static bool parseSeed(const juce::String& text, int64_t& seed, int& engineVersion);
+    // the clipboard's seed rendered with the current settings, by the engine it was made with
+    void pasteSeed();
+
+    // newSeed: a fresh 808 from the UI and keywords; otherwise the current one retuned
+    GeneratorParams makeParamsFromUI(bool newSeed);
+
+    // tune drag: a draft per change on the message thread, the full render on a worker once the
+    // value settles (mouse up, or no change for settleMs). Only the latest request may publish.
+    static constexpr int settleMs = 250;
+    void renderTuneDraft();
+    void startFullRender();
+    void timerCallback() override;
+
+    std::shared_ptr<juce::AudioBuffer<float>> draftBufferPtr;
+    RenderContext draftContext;
+    juce::uint32 renderGeneration = 0;
+
+    // full renders run on short-lived worker threads that take turns with one context, so its
+    // buffers and generator state carry over from render to render
+    struct WorkerRenderContext
+    {
+        std::mutex lock;
+        RenderContext context;
+    };
+    std::shared_ptr<WorkerRenderContext> workerContext = std::make_shared<WorkerRenderContext>();
+
+    // GeneratorParams::oversampling and autoLength for the next renders, picked from the main menu
+    int oversampling = 1;
+    bool autoLength = false;
 
     // handlers
     void buttonClicked(juce::Button* b) override;
@@ -133,6 +192,7 @@ private:
 
     // helper to show main menu
     void showMainMenu();
+    void findSimilarToCurrent();
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PluginEditor)
 };
@@ -1,8 +1,14 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "SimilaritySearch.h"
 
 PluginProcessor::PluginProcessor()
 {
+    // current + one the audio thread may still hold + one being filled
+    soundRecords.reserve(4);
+    retiredSounds.reserve(4);
+    spareSounds.reserve(4);
+    peakPool.reserve((size_t)maxPooledPeaks);
 }
 
 PluginProcessor::~PluginProcessor()
@@ -12,7 +18,8 @@ PluginProcessor::~PluginProcessor()
 void PluginProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
     // nothing fancy to prepare for generator (generator will be given sampleRate via params)
-    juce::ignoreUnused(sampleRate, samplesPerBlock);
+    juce::ignoreUnused(samplesPerBlock);
+    outputMeter.setSampleRate(sampleRate);
 }
 
 void PluginProcessor::releaseResources()
@@ -30,52 +37,82 @@ bool PluginProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
 void PluginProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
     juce::ignoreUnused (midiMessages);
+    juce::ScopedNoDenormals noDenormals;
+   #if ORADE808_TEST_HOOKS
+    RealtimeChecker::Scope realtime (realtimeChecker.load());
+   #endif
 
+    renderPreview(buffer);
+
+    // only a copy into the meter FIFO here; the metering itself runs on the consumer thread
+    outputMeter.push(buffer, buffer.getNumSamples());
+}
+
+void PluginProcessor::renderPreview (juce::AudioBuffer<float>& buffer)
+{
     const int numOutCh = buffer.getNumChannels();
     const int numSamples = buffer.getNumSamples();
 
-    // If previewing and we have a generated buffer, stream it to output.
-    if (isPreviewing())
+    // Not previewing: let go of the sound, so the message thread can release it.
+    if (!isPreviewing())
     {
-        std::shared_ptr<juce::AudioBuffer<float>> bufPtr;
-        {
-            std::lock_guard<std::mutex> lock(generatedBufferMutex);
-            bufPtr = generatedBufferPtr;
-        }
+        audioSound.store(nullptr);
+        buffer.clear();
+        return;
+    }
 
-        if (bufPtr && bufPtr->getNumSamples() > 0)
-        {
-            const int genCh = bufPtr->getNumChannels();
-            int pos = playPosition.load();
+    // If we have a generated buffer, stream it to output. The record stays valid for the
+    // whole block: it isn't released while audioSound points at it.
+    const auto* sound = acquirePublishedSound();
+    const auto* bufPtr = sound != nullptr ? sound->buffer.get() : nullptr;
 
-            for (int s = 0; s < numSamples; ++s)
+    if (bufPtr != nullptr && bufPtr->getNumSamples() > 0)
+    {
+        const int genCh = bufPtr->getNumChannels();
+        int pos = playPosition.load();
+
+        for (int s = 0; s < numSamples; ++s)
+        {
+            if (pos >= bufPtr->getNumSamples())
             {
-                if (pos >= bufPtr->getNumSamples())
-                {
-                    // reached end; stop preview
-                    previewing.store(false);
-                    playPosition.store(0);
-                    buffer.clear(s, numSamples - s);
-                    return;
-                }
-
-                for (int ch = 0; ch < numOutCh; ++ch)
-                {
-                    const float sample = bufPtr->getSample(juce::jmin(ch, genCh - 1), pos);
-                    buffer.setSample(ch, s, sample);
-                }
-                ++pos;
+                // reached end; stop preview
+                previewing.store(false);
+                playPosition.store(0);
+                buffer.clear(s, numSamples - s);
+                return;
             }
 
-            playPosition.store(pos);
-            return;
+            for (int ch = 0; ch < numOutCh; ++ch)
+            {
+                // a mono render feeds every output channel
+                const float sample = bufPtr->getSample(juce::jmin(ch, genCh - 1), pos);
+                buffer.setSample(ch, s, sample);
+            }
+            ++pos;
         }
+
+        playPosition.store(pos);
+        return;
     }
 
-    // Default: clear output (silence)
+    // Default: clear output (silence). Previewing with nothing to play is a dropout
+    numSilencedPreviewBlocks.fetch_add(1);
     buffer.clear();
 }
 
+const PluginProcessor::GeneratedSound* PluginProcessor::acquirePublishedSound() noexcept
+{
+    // publish-then-check: if publishedSound still holds the record after it was marked, any
+    // storeGenerated that replaces it afterwards sees the mark and keeps the record
+    for (;;)
+    {
+        const auto* sound = publishedSound.load();
+        audioSound.store(sound);
+        if (publishedSound.load() == sound)
+            return sound;
+    }
+}
+
 juce::AudioProcessorEditor* PluginProcessor::createEditor()
 {
     return new PluginEditor (*this);
@@ -94,28 +131,124 @@ void PluginProcessor::setStateInformation (const void* data, int sizeInBytes)
 // generate and store result in generatedBufferPtr
 bool PluginProcessor::generate808AndStore(const GeneratorParams& params)
 {
-    lastParams = params;
     GeneratorParams p = params;
     if (p.sampleRate <= 0.0) p.sampleRate = 44100.0;
 
-    auto buf = generator.renderToBuffer(p); // returns stereo buffer
+    return storeGenerated(params, renderContext.render(p)); // mono or stereo, see getNumOutputChannels
+}
 
-    auto newBuf = std::make_shared<juce::AudioBuffer<float>>(buf.getNumChannels(), buf.getNumSamples());
-    newBuf->makeCopyOf(buf);
+bool PluginProcessor::storeGenerated(const GeneratorParams& params, juce::AudioBuffer<float>&& buffer)
+{
+    return storeGenerated(params, std::make_shared<juce::AudioBuffer<float>>(std::move(buffer)));
+}
 
+bool PluginProcessor::storeGenerated(const GeneratorParams& params, std::shared_ptr<juce::AudioBuffer<float>> newBuf)
+{
+    lastParams = params;
+    if (newBuf == nullptr)
+        return false;
+
+    // summarise for the waveform displays here, so editors never walk the samples themselves
+    auto pyramid = acquirePeakPyramid();
+    pyramid->build(*newBuf);
+    std::shared_ptr<const PeakPyramid> newPeaks = std::move(pyramid);
+
+    const bool playable = newBuf->getNumSamples() > 0;
     {
-        std::lock_guard<std::mutex> lock(generatedBufferMutex);
-        generatedBufferPtr = newBuf;
+        const std::lock_guard<std::mutex> lock(publishLock);
+
+        GeneratedSound* sound = nullptr;
+        if (spareSounds.empty())
+        {
+            soundRecords.push_back(std::make_unique<GeneratedSound>());
+            sound = soundRecords.back().get();
+        }
+        else
+        {
+            sound = spareSounds.back();
+            spareSounds.pop_back();
+        }
+
+        // filled in before it is published, never written while published
+        sound->buffer = std::move(newBuf);
+        sound->peaks = std::move(newPeaks);
+
+        if (auto* previous = publishedSound.exchange(sound))
+            retiredSounds.push_back(previous);
     }
 
-    return (generatedBufferPtr && generatedBufferPtr->getNumSamples() > 0);
+    releaseRetiredSounds();
+    return playable;
+}
+
+void PluginProcessor::releaseRetiredSounds()
+{
+    const std::lock_guard<std::mutex> lock(publishLock);
+
+    // read after the exchange in storeGenerated: see acquirePublishedSound
+    const auto* inUse = audioSound.load();
+    for (size_t i = 0; i < retiredSounds.size();)
+    {
+        auto* sound = retiredSounds[i];
+        if (sound == inUse)
+        {
+            ++i;
+            continue;
+        }
+
+        sound->buffer.reset();
+        sound->peaks.reset();
+        spareSounds.push_back(sound);
+        retiredSounds.erase(retiredSounds.begin() + (std::ptrdiff_t)i);
+    }
+}
+
+std::shared_ptr<PeakPyramid> PluginProcessor::acquirePeakPyramid()
+{
+    // free = only the pool still holds it; the fence pairs with the last reader's release, as in
+    // RenderContext::acquire
+    for (auto& peaks : peakPool)
+    {
+        if (peaks.use_count() == 1)
+        {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return peaks;
+        }
+    }
+
+    if ((int)peakPool.size() >= maxPooledPeaks)
+        return std::make_shared<PeakPyramid>();
+
+    peakPool.push_back(std::make_shared<PeakPyramid>());
+    return peakPool.back();
+}
+
+// thread-safe getters used by editors
+PluginProcessor::GeneratedSound PluginProcessor::getGeneratedSound() const
+{
+    const std::lock_guard<std::mutex> lock(publishLock);
+    if (const auto* sound = publishedSound.load())
+        return *sound;
+    return {};
 }
 
-// thread-safe getter used by editors
 std::shared_ptr<juce::AudioBuffer<float>> PluginProcessor::getGeneratedBufferSharedPtr() const noexcept
 {
-    std::lock_guard<std::mutex> lock(generatedBufferMutex);
-    return generatedBufferPtr;
+    const std::lock_guard<std::mutex> lock(publishLock);
+    if (const auto* sound = publishedSound.load())
+        return sound->buffer;
+    return nullptr;
+}
+
+bool PluginProcessor::analyzeCurrentRender(AudioFeatures& result) const
+{
+    auto bufPtr = getGeneratedBufferSharedPtr();
+    if (!bufPtr || bufPtr->getNumSamples() == 0)
+        return false;
+
+    const double sr = lastParams.sampleRate > 0.0 ? lastParams.sampleRate : 44100.0;
+    result = SimilaritySearch::analyzeBuffer(*bufPtr, sr, (uint64_t)lastParams.seed);
+    return true;
 }
 
 // playback control
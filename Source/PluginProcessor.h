@@ -3,16 +3,26 @@
 #include <JuceHeader.h>
 #include "808Generator.h"
 #include "WavExporter.h"
+#include "FeatureIndex.h"
+#include "PeakPyramid.h"
+#include "OutputMeter.h"
+#include "RenderContext.h"
+#include "RealtimeChecker.h"
 #include <atomic>
 #include <memory>
 #include <mutex>
+#include <vector>
 
 //==============================================================================
 // Audio processor for 808orade with preview playback support.
-// generate808AndStore(...) stores a generated buffer into an atomically-published
-// shared_ptr that the audio thread will read and play when previewing.
+// generate808AndStore(...) publishes the generated buffer and its peak pyramid together
+// as one immutable GeneratedSound, through an atomic pointer the audio thread reads when
+// previewing.
 // NOTE: std::atomic<std::shared_ptr<T>> is not supported because std::shared_ptr
-// is not trivially copyable on MSVC. We use a mutex-protected shared_ptr instead.
+// is not trivially copyable on MSVC. We swap a plain pointer to the record instead. The
+// audio thread never locks and never owns a reference: it marks the record it plays as in
+// use (a hazard pointer), and the message thread only releases a replaced record once the
+// audio thread has moved on, so processBlock neither blocks nor frees (--check-realtime).
 class PluginProcessor  : public juce::AudioProcessor
 {
 public:
@@ -47,6 +57,25 @@ public:
     // Returns true on success.
     bool generate808AndStore(const GeneratorParams& params);
 
+    // Publish a buffer rendered elsewhere (e.g. on a worker) as if generate808AndStore had made it.
+    // The shared_ptr version publishes the buffer itself (e.g. one from a RenderContext), no copy.
+    // Message thread only. Once warmed up, generate808AndStore and the shared_ptr version don't
+    // allocate: the buffer, the peak pyramid and the record come from pools (--check-allocations).
+    bool storeGenerated(const GeneratorParams& params, juce::AudioBuffer<float>&& buffer);
+    bool storeGenerated(const GeneratorParams& params, std::shared_ptr<juce::AudioBuffer<float>> buffer);
+
+    // The generated buffer and the waveform summary built from it, published as a pair.
+    // Both are nullptr before the first render.
+    struct GeneratedSound
+    {
+        std::shared_ptr<juce::AudioBuffer<float>> buffer;
+        std::shared_ptr<const PeakPyramid> peaks;
+    };
+
+    // The current pair, read in one go (any thread but the audio thread). Use this whenever
+    // the peaks are needed: they always match the buffer they come with.
+    GeneratedSound getGeneratedSound() const;
+
     // Return a shared_ptr to the current generated buffer. May be nullptr if none generated.
     std::shared_ptr<juce::AudioBuffer<float>> getGeneratedBufferSharedPtr() const noexcept;
 
@@ -55,23 +84,65 @@ public:
     void stopPreview() noexcept;
     bool isPreviewing() const noexcept;
 
+    // Blocks processBlock filled with silence while the preview was on, because nothing playable
+    // was published: each one is a gap the user hears. Counts from construction (threadsafe)
+    int getNumSilencedPreviewBlocks() const noexcept { return numSilencedPreviewBlocks.load(); }
+
+    // Analyze the current render like a library sample (for "find 808s like this one").
+    // Returns false if nothing has been generated yet. Call from a non-audio thread.
+    bool analyzeCurrentRender(AudioFeatures& result) const;
+
+    // Tap on the final output of processBlock; the UI (or a headless check) calls update() on it
+    OutputMeter& getOutputMeter() noexcept { return outputMeter; }
+
     // Access last used params (for display / seed, etc.)
     const GeneratorParams& getLastParams() const noexcept { return lastParams; }
 
+    // Report allocations, frees and blocking locks made inside processBlock to checker
+    // (nullptr to stop). For tests, and ignored without ORADE808_TEST_HOOKS; the checker must
+    // outlive its use here.
+    void setRealtimeChecker(RealtimeChecker* checker) noexcept { realtimeChecker.store(checker); }
+
 private:
-    Generator808 generator;
+    // streams the generated buffer while previewing, silence otherwise
+    void renderPreview(juce::AudioBuffer<float>& buffer);
+
+    // audio thread: the published sound, marked as in use until the next call (or nullptr)
+    const GeneratedSound* acquirePublishedSound() noexcept;
 
-    // Publication of the generated buffer:
-    // Use a mutex-protected shared_ptr instead of std::atomic<std::shared_ptr<...>>
-    // to avoid the static_assert failure on MSVC.
-    mutable std::mutex generatedBufferMutex;
-    std::shared_ptr<juce::AudioBuffer<float>> generatedBufferPtr; // guarded by generatedBufferMutex
+    // message thread: replaced sounds the audio thread has moved on from drop their buffer and
+    // peaks (the last reference to them may go here) and become spare records
+    void releaseRetiredSounds();
+
+    // message thread: a pyramid from peakPool nobody else holds any more, to build the next one in
+    std::shared_ptr<PeakPyramid> acquirePeakPyramid();
+
+    RenderContext renderContext; // generate808AndStore's, message thread
+
+    // Publication of the generated sound. Records are reused rather than freed, so publishing
+    // doesn't allocate once a few exist; only publishedSound and audioSound are touched by the
+    // audio thread.
+    std::atomic<GeneratedSound*> publishedSound { nullptr };
+    std::atomic<const GeneratedSound*> audioSound { nullptr };          // the hazard pointer
+    mutable std::mutex publishLock;                                      // non-audio readers vs. storeGenerated
+    std::vector<std::unique_ptr<GeneratedSound>> soundRecords;           // guarded by publishLock
+    std::vector<GeneratedSound*> retiredSounds, spareSounds;             // guarded by publishLock
+
+    // pyramids for storeGenerated, reused once their readers have let go; beyond maxPooledPeaks
+    // held at once, extra ones are plain allocations
+    static constexpr int maxPooledPeaks = 8;
+    std::vector<std::shared_ptr<PeakPyramid>> peakPool;                  // message thread
 
     // playback state (audio thread reads/writes)
     std::atomic<int> playPosition { 0 };
     std::atomic<bool> previewing { false };
+    std::atomic<int> numSilencedPreviewBlocks { 0 };
+
+    std::atomic<RealtimeChecker*> realtimeChecker { nullptr };
 
     GeneratorParams lastParams;
 
+    OutputMeter outputMeter;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PluginProcessor)
 };
@@ -0,0 +1,103 @@
+#include "RealtimeChecker.h"
+
+#if ORADE808_LIBC_HOOKS
+ #include <cerrno>
+ #include <dlfcn.h>
+ #include <pthread.h>
+#endif
+
+using namespace juce;
+
+RealtimeChecker::Scope::Scope(RealtimeChecker* c) noexcept
+    : checker(c), previous(active)
+{
+    if (checker != nullptr)
+        active = checker;
+}
+
+RealtimeChecker::Scope::~Scope() noexcept
+{
+    if (checker != nullptr)
+        active = previous;
+}
+
+void RealtimeChecker::record(const char* what) noexcept
+{
+    // the backtrace and the list allocate: leave the scope while recording, or this would recurse
+    auto* const self = active;
+    active = nullptr;
+    {
+        const std::lock_guard<std::mutex> guard(lock);
+        violations.push_back({ what, SystemStats::getStackBacktrace() });
+    }
+    active = self;
+}
+
+std::vector<RealtimeChecker::Violation> RealtimeChecker::getViolations() const
+{
+    const std::lock_guard<std::mutex> guard(lock);
+    return violations;
+}
+
+int RealtimeChecker::getNumViolations() const
+{
+    const std::lock_guard<std::mutex> guard(lock);
+    return (int)violations.size();
+}
+
+void RealtimeChecker::clear()
+{
+    const std::lock_guard<std::mutex> guard(lock);
+    violations.clear();
+}
+
+//==============================================================================
+// glibc only: the C allocation functions and pthread_mutex_lock, defined in the executable so
+// they take the place of the library's, forward to glibc's own entry points. Calls glibc makes
+// internally don't come through here, so only our code and the libraries it calls are seen
+#if ORADE808_LIBC_HOOKS
+
+extern "C"
+{
+    void* __libc_malloc(std::size_t);
+    void* __libc_calloc(std::size_t, std::size_t);
+    void* __libc_realloc(void*, std::size_t);
+    void* __libc_memalign(std::size_t, std::size_t);
+    void __libc_free(void*);
+
+    void* malloc(std::size_t size)                      { RealtimeChecker::noteAllocation(); return __libc_malloc(size); }
+    void* calloc(std::size_t n, std::size_t size)       { RealtimeChecker::noteAllocation(); return __libc_calloc(n, size); }
+    void* realloc(void* p, std::size_t size)            { RealtimeChecker::noteAllocation(); return __libc_realloc(p, size); }
+    void* memalign(std::size_t align, std::size_t size) { RealtimeChecker::noteAllocation(); return __libc_memalign(align, size); }
+    void* aligned_alloc(std::size_t align, std::size_t size) { RealtimeChecker::noteAllocation(); return __libc_memalign(align, size); }
+
+    int posix_memalign(void** result, std::size_t align, std::size_t size)
+    {
+        RealtimeChecker::noteAllocation();
+        if (align % sizeof(void*) != 0 || (align & (align - 1)) != 0)
+            return EINVAL;
+        void* p = __libc_memalign(align, size);
+        if (p == nullptr)
+            return ENOMEM;
+        *result = p;
+        return 0;
+    }
+
+    void free(void* p)
+    {
+        if (p != nullptr)
+            RealtimeChecker::noteFree();
+        __libc_free(p);
+    }
+
+    // glibc exports no versioned alias to link against, so look the real one up once
+    int pthread_mutex_lock(pthread_mutex_t* mutex)
+    {
+        using LockFunction = int (*)(pthread_mutex_t*);
+        static const LockFunction next = (LockFunction) dlsym(RTLD_NEXT, "pthread_mutex_lock");
+        RealtimeChecker::noteBlockingLock();
+        return next(mutex);
+    }
+}
+
+#endif
@@ -0,0 +1,82 @@
+#pragma once
+#include <JuceHeader.h>
+#include "AllocationCounter.h"
+#include <cstdlib>
+#include <mutex>
+#include <vector>
+
+// On glibc the test hooks also wrap malloc / calloc / realloc / free (and the aligned variants)
+// and pthread_mutex_lock, forwarding to the C library (RealtimeChecker.cpp)
+#if ORADE808_TEST_HOOKS && defined(__GLIBC__)
+ #define ORADE808_LIBC_HOOKS 1
+#else
+ #define ORADE808_LIBC_HOOKS 0
+#endif
+
+/*
+ RealtimeChecker
+ - Test aid for code that has to be real-time safe (PluginProcessor::processBlock). While a Scope
+   is alive on a thread, every heap allocation and free and every blocking mutex lock on that
+   thread is recorded as a violation, with the stack backtrace of the call
+ - Needs ORADE808_TEST_HOOKS (see AllocationCounter.h); without it nothing is recorded and
+   processBlock doesn't open a Scope at all. Outside a Scope the cost is one thread_local read
+   per allocation, free or lock
+ - What it sees: everywhere, the global operator new / delete. On Linux (glibc) also malloc and
+   friends, so juce::HeapBlock / AudioBuffer storage, and pthread_mutex_lock, so std::mutex,
+   juce::CriticalSection and anything else built on it. seesMallocAndMutexes() says which
+ - What it doesn't: on Windows and macOS, malloc and every lock; anywhere, waits on condition
+   variables, semaphores and futexes, spinning on juce::SpinLock or other atomics, and system
+   calls such as file or socket I/O. A clean run is evidence, not proof
+ - --check-realtime drives processBlock through preview start/stop and buffer swaps in a Scope
+*/
+class RealtimeChecker
+{
+public:
+    struct Violation
+    {
+        juce::String what;      // "allocation", "free" or "blocking lock"
+        juce::String callSite;  // stack backtrace at the call
+    };
+
+    RealtimeChecker() = default;
+
+    // false if the hooks are compiled out: nothing is ever recorded
+    static constexpr bool isAvailable() noexcept { return ORADE808_TEST_HOOKS != 0; }
+
+    // whether malloc / free and mutex locks are seen as well as operator new / delete
+    static constexpr bool seesMallocAndMutexes() noexcept { return ORADE808_LIBC_HOOKS != 0; }
+
+    // marks the calling thread as real-time until destroyed; a null checker leaves it alone
+    class Scope
+    {
+    public:
+        explicit Scope(RealtimeChecker* checker) noexcept;
+        ~Scope() noexcept;
+
+    private:
+        RealtimeChecker* const checker;
+        RealtimeChecker* const previous;
+
+        JUCE_DECLARE_NON_COPYABLE(Scope)
+    };
+
+    // no-ops unless the calling thread is inside a Scope
+    static void noteAllocation() noexcept   { if (active != nullptr) active->record("allocation"); }
+    static void noteFree() noexcept         { if (active != nullptr) active->record("free"); }
+    static void noteBlockingLock() noexcept { if (active != nullptr) active->record("blocking lock"); }
+
+    std::vector<Violation> getViolations() const;
+    int getNumViolations() const;
+    void clear();
+
+private:
+    void record(const char* what) noexcept;
+
+    // the checker of the calling thread's innermost Scope (plain pointer: no dynamic thread_local init)
+    static inline thread_local RealtimeChecker* active = nullptr;
+
+    mutable std::mutex lock;
+    std::vector<Violation> violations;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RealtimeChecker)
+};
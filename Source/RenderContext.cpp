@@ -0,0 +1,74 @@
+#include "RenderContext.h"
+#include <atomic>
+
+using namespace juce;
+
+RenderContext::RenderContext(int maxPooledBuffers)
+    : maxPooled(jmax(1, maxPooledBuffers))
+{
+    pool.reserve((size_t)maxPooled);
+}
+
+RenderContext::BufferPtr RenderContext::render(const GeneratorParams& params)
+{
+    const int numSamples = (int)std::lround(params.lengthSeconds * params.sampleRate);
+    auto buffer = acquire(Generator808::getNumOutputChannels(params), numSamples);
+    workspace.scalar.render(params, *buffer);
+    return buffer;
+}
+
+RenderContext::BufferPtr RenderContext::renderDraft(const GeneratorParams& params, double maxSeconds)
+{
+    auto buffer = acquire(1, Generator808::getDraftNumSamples(params, maxSeconds));
+    workspace.scalar.renderDraft(params, *buffer, maxSeconds);
+    return buffer;
+}
+
+void RenderContext::renderAll(const std::vector<GeneratorParams>& voices, std::vector<BufferPtr>& results, int lanes)
+{
+    // the last batch's buffers go back to the pool first, so this one can reuse them
+    results.clear();
+    results.resize(voices.size());
+    batchResults.resize(voices.size());
+    for (size_t v = 0; v < voices.size(); ++v)
+    {
+        const int numSamples = (int)std::lround(voices[v].lengthSeconds * voices[v].sampleRate);
+        results[v] = acquire(Generator808::getNumOutputChannels(voices[v]), numSamples);
+        batchResults[v] = results[v].get();
+    }
+
+    BatchRender808::renderAll(voices.data(), (int)voices.size(), batchResults.data(), workspace, lanes);
+}
+
+RenderContext::BufferPtr RenderContext::acquire(int numChannels, int numSamples)
+{
+    const size_t needed = (size_t)numChannels * (size_t)numSamples;
+
+    // free = only the pool still holds it. The acquire fence pairs with the release in the last
+    // other holder's shared_ptr destructor, so its reads are done before the samples are reused
+    PooledBuffer* best = nullptr;
+    for (auto& entry : pool)
+    {
+        if (entry.buffer.use_count() != 1)
+            continue;
+
+        if (best == nullptr || (best->capacity < needed && entry.capacity > best->capacity))
+            best = &entry;
+        if (best->capacity >= needed)
+            break;
+    }
+
+    if (best == nullptr)
+    {
+        if ((int)pool.size() >= maxPooled)
+            return std::make_shared<AudioBuffer<float>>(numChannels, numSamples);
+
+        pool.push_back({ std::make_shared<AudioBuffer<float>>(), 0 });
+        best = &pool.back();
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    best->buffer->setSize(numChannels, numSamples, false, false, true);
+    best->capacity = jmax(best->capacity, needed);
+    return best->buffer;
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <JuceHeader.h>
+#include "808Generator.h"
+#include "BatchGenerator808.h"
+#include <memory>
+#include <vector>
+
+/*
+ RenderContext
+ - Everything one thread needs to render 808s without touching the heap once it has warmed up:
+   the generators (their look-ahead ring, chain block, oversamplers and SIMD lane buffers are
+   reused from render to render) and a pool of result buffers
+ - Results are handed out as shared_ptrs to pooled buffers. The pool keeps its own reference, so a
+   buffer is free again once everyone else (the processor, a waveform, a worker) has let go of it,
+   and its allocation is reused for the next result that fits
+ - Publishing a result is a shared_ptr move (PluginProcessor::storeGenerated): no copy and no new
+   control block
+ - Beyond maxPooledBuffers results in use at once, extra ones are plain allocations
+ - Not thread-safe: one per rendering thread, results may be read from anywhere.
+   --check-allocations counts what a warmed-up context allocates per render
+*/
+class RenderContext
+{
+public:
+    using BufferPtr = std::shared_ptr<juce::AudioBuffer<float>>;
+
+    explicit RenderContext(int maxPooledBuffers = 32);
+
+    // Generator808::render / renderDraft into a pooled buffer
+    BufferPtr render(const GeneratorParams& params);
+    BufferPtr renderDraft(const GeneratorParams& params, double maxSeconds = 1.0);
+
+    // BatchRender808::renderAll into pooled buffers. results is replaced (its previous buffers are
+    // released first, so a caller that renders chunk after chunk into the same vector reuses them)
+    void renderAll(const std::vector<GeneratorParams>& voices, std::vector<BufferPtr>& results, int lanes = 0);
+
+private:
+    struct PooledBuffer
+    {
+        BufferPtr buffer;
+        size_t capacity = 0; // floats the buffer has been sized for, so its allocation holds at least this
+    };
+
+    // a free pooled buffer sized numChannels x numSamples, preferring one whose allocation fits
+    BufferPtr acquire(int numChannels, int numSamples);
+
+    BatchRender808::Workspace workspace; // workspace.scalar is the context's Generator808
+    std::vector<PooledBuffer> pool;
+    std::vector<juce::AudioBuffer<float>*> batchResults;
+    const int maxPooled;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RenderContext)
+};
@@ -0,0 +1,536 @@
+#include "RenderDaemon.h"
+#include "ParallelJobs.h"
+#include "WavExporter.h"
+#include <algorithm>
+#include <chrono>
+#include <functional>
+
+using namespace juce;
+
+namespace
+{
+    constexpr size_t maxLineLength = 1 << 16;
+
+    String toJsonLine(DynamicObject::Ptr object)
+    {
+        return JSON::toString(var(object.get()), true);
+    }
+
+    bool isNumber(const var& v) { return v.isInt() || v.isInt64() || v.isDouble(); }
+}
+
+//==============================================================================
+var RenderDaemonStats::toJson() const
+{
+    DynamicObject::Ptr o = new DynamicObject();
+    o->setProperty("numRenders", numRenders);
+    o->setProperty("numFailed", numFailed);
+    o->setProperty("numBatches", numBatches);
+    o->setProperty("uptimeSeconds", uptimeSeconds);
+    o->setProperty("meanQueueMs", meanQueueMs);
+    o->setProperty("p95QueueMs", p95QueueMs);
+    o->setProperty("maxQueueMs", maxQueueMs);
+    o->setProperty("meanBatchMs", meanBatchMs);
+    o->setProperty("meanBatchSize", meanBatchSize);
+    o->setProperty("rendersPerSecond", rendersPerSecond);
+    o->setProperty("audioSecondsRendered", audioSecondsRendered);
+    return var(o.get());
+}
+
+String RenderDaemonStats::toString() const
+{
+    return String(numRenders) + " renders (" + String(numFailed) + " failed) in " + String(numBatches) + " batches, "
+         + String(meanBatchSize, 1) + " per batch, " + String(meanBatchMs, 2) + " ms per batch\n"
+         + "queue latency mean " + String(meanQueueMs, 2) + " ms, p95 " + String(p95QueueMs, 2) + " ms, max "
+         + String(maxQueueMs, 2) + " ms\n"
+         + String(rendersPerSecond, 1) + " renders/s, " + String(audioSecondsRendered, 1) + " s of audio in "
+         + String(uptimeSeconds, 1) + " s";
+}
+
+//==============================================================================
+RenderDaemon::RenderDaemon(const RenderDaemonOptions& o)
+    : options(o),
+      socketPath(o.socketPath != File() ? o.socketPath : getDefaultSocketPath()),
+      lanes(BatchRender808::getNativeLanes())
+{
+}
+
+RenderDaemon::~RenderDaemon()
+{
+    stop();
+}
+
+File RenderDaemon::getDefaultSocketPath()
+{
+    return File::getSpecialLocation(File::tempDirectory).getChildFile("808orade-render.sock");
+}
+
+bool RenderDaemon::start(String& error)
+{
+    jassert(!running);
+
+    listener = LocalSocket::listen(socketPath, error);
+    if (listener == nullptr)
+        return false;
+
+    const int maxBatch = jmax(1, options.maxBatchSize);
+    pool = std::make_unique<ThreadPool>(ParallelJobs::resolveThreadCount(options.numThreads));
+    workspaces.clear();
+    for (int c = 0; c < (maxBatch + lanes - 1) / lanes; ++c)
+        workspaces.push_back(std::make_unique<BatchRender808::Workspace>());
+
+    recentQueueMs.reserve(queueHistory);
+    startMs = Time::getMillisecondCounterHiRes();
+    stopping = false;
+    shutdownAsked = false;
+    running = true;
+
+    batchThread = std::thread([this] { batchLoop(); });
+    acceptThread = std::thread([this] { acceptLoop(); });
+    return true;
+}
+
+void RenderDaemon::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(queueLock);
+        if (!running)
+            return;
+        running = false;
+        stopping = true;
+    }
+    queueChanged.notify_all();
+    shutdownRequested.notify_all();
+
+    // a connection wakes the accept loop up if closing the listener didn't
+    listener->close();
+    {
+        String ignored;
+        LocalSocket::connect(socketPath, ignored);
+    }
+    acceptThread.join();
+
+    // fails whatever is still queued, so no connection is left waiting for a render
+    batchThread.join();
+
+    {
+        std::lock_guard<std::mutex> lock(connectionsLock);
+        for (auto& c : connections)
+            c->socket->close();
+        for (auto& c : connections)
+            c->thread.join();
+        connections.clear();
+    }
+
+    listener.reset();
+    socketPath.deleteFile();
+    pool.reset();
+}
+
+void RenderDaemon::waitForShutdownRequest()
+{
+    std::unique_lock<std::mutex> lock(queueLock);
+    shutdownRequested.wait(lock, [this] { return shutdownAsked || stopping; });
+}
+
+void RenderDaemon::requestShutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(queueLock);
+        shutdownAsked = true;
+    }
+    shutdownRequested.notify_all();
+}
+
+//==============================================================================
+void RenderDaemon::acceptLoop()
+{
+    while (auto socket = listener->accept())
+    {
+        std::lock_guard<std::mutex> lock(connectionsLock);
+
+        // connections the client has closed since the last one arrived
+        for (auto& c : connections)
+            if (c->finished && c->thread.joinable())
+                c->thread.join();
+        connections.erase(std::remove_if(connections.begin(), connections.end(),
+                                         [](const std::unique_ptr<Connection>& c) { return !c->thread.joinable(); }),
+                          connections.end());
+
+        auto connection = std::make_unique<Connection>();
+        connection->socket = std::move(socket);
+        auto* c = connection.get();
+        connection->thread = std::thread([this, c] { serve(*c); });
+        connections.push_back(std::move(connection));
+    }
+}
+
+void RenderDaemon::serve(Connection& connection)
+{
+    auto& socket = *connection.socket;
+    std::string line;
+    bool keepGoing = true;
+
+    while (keepGoing && socket.readLine(line, maxLineLength))
+    {
+        if (line.find_first_not_of(" \t\r") == std::string::npos)
+            continue;
+
+        const auto reply = handleLine(line, socket, keepGoing);
+        if (reply.isNotEmpty() && !socket.writeLine(reply))
+            break;
+    }
+
+    connection.finished = true;
+}
+
+String RenderDaemon::handleLine(const std::string& line, LocalSocket& socket, bool& keepGoing)
+{
+    const auto json = JSON::parse(String::fromUTF8(line.data(), (int)line.size()));
+    auto* object = json.getDynamicObject();
+    const auto id = object != nullptr ? object->getProperty("id") : var();
+
+    auto failure = [&id](const String& message)
+    {
+        DynamicObject::Ptr o = new DynamicObject();
+        o->setProperty("id", id);
+        o->setProperty("ok", false);
+        o->setProperty("error", message);
+        return toJsonLine(o);
+    };
+
+    if (object == nullptr)
+        return failure("Expected one JSON object per line");
+
+    for (const auto& property : object->getProperties())
+        if (!StringArray { "id", "cmd", "params", "output", "bitsPerSample", "mono" }.contains(property.name.toString()))
+            return failure("Unknown field \"" + property.name.toString() + "\"");
+
+    const auto cmd = object->getProperty("cmd").toString();
+    if (cmd == "stats")
+    {
+        DynamicObject::Ptr o = new DynamicObject();
+        o->setProperty("id", id);
+        o->setProperty("ok", true);
+        o->setProperty("stats", getStats().toJson());
+        return toJsonLine(o);
+    }
+    if (cmd == "shutdown")
+    {
+        DynamicObject::Ptr o = new DynamicObject();
+        o->setProperty("id", id);
+        o->setProperty("ok", true);
+        socket.writeLine(toJsonLine(o));
+        requestShutdown();
+        keepGoing = false;
+        return {};
+    }
+    if (cmd.isNotEmpty())
+        return failure("Unknown cmd \"" + cmd + "\"");
+
+    auto request = std::make_shared<Request>();
+    String error;
+    if (!parseParams(object->getProperty("params"), request->params, error))
+        return failure(error);
+
+    if (object->hasProperty("output"))
+    {
+        const auto path = object->getProperty("output").toString();
+        if (!File::isAbsolutePath(path))
+            return failure("output must be an absolute path");
+        request->output = File(path);
+    }
+
+    if (object->hasProperty("bitsPerSample"))
+    {
+        const auto bits = object->getProperty("bitsPerSample");
+        if (!bits.isInt() || ((int)bits != 16 && (int)bits != 24 && (int)bits != 32))
+            return failure("bitsPerSample must be 16, 24 or 32");
+        request->bitsPerSample = (int)bits;
+    }
+
+    request->keepMono = (bool)object->getProperty("mono");
+
+    if (!submitAndWait(request))
+        return failure(request->error);
+
+    const auto& result = request->result;
+    DynamicObject::Ptr o = new DynamicObject();
+    o->setProperty("id", id);
+    o->setProperty("ok", true);
+    o->setProperty("numChannels", result.getNumChannels());
+    o->setProperty("numSamples", result.getNumSamples());
+    o->setProperty("sampleRate", request->params.sampleRate);
+    o->setProperty("queueMs", request->queueMs);
+    o->setProperty("renderMs", request->renderMs);
+    o->setProperty("batchSize", request->batchSize);
+
+    if (request->output != File())
+    {
+        o->setProperty("output", request->output.getFullPathName());
+        return toJsonLine(o);
+    }
+
+    // inline: the header line, then the samples interleaved
+    const int numChannels = result.getNumChannels(), numSamples = result.getNumSamples();
+    std::vector<float> interleaved((size_t)numChannels * (size_t)numSamples);
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        const float* src = result.getReadPointer(ch);
+        for (int i = 0; i < numSamples; ++i)
+            interleaved[(size_t)i * (size_t)numChannels + (size_t)ch] = src[i];
+    }
+
+    o->setProperty("pcmBytes", (int64)(interleaved.size() * sizeof(float)));
+    if (!socket.writeLine(toJsonLine(o)) || !socket.write(interleaved.data(), interleaved.size() * sizeof(float)))
+        keepGoing = false;
+    return {};
+}
+
+bool RenderDaemon::submitAndWait(const std::shared_ptr<Request>& request)
+{
+    std::unique_lock<std::mutex> lock(queueLock);
+    if (stopping)
+    {
+        request->error = "The daemon is shutting down";
+        return false;
+    }
+
+    request->arrivalMs = Time::getMillisecondCounterHiRes();
+    queue.push_back(request);
+    queueChanged.notify_all();
+
+    finished.wait(lock, [&request] { return request->done; });
+    return request->ok;
+}
+
+//==============================================================================
+void RenderDaemon::batchLoop()
+{
+    const int maxBatch = jmax(1, options.maxBatchSize);
+    std::vector<std::shared_ptr<Request>> batch;
+    std::unique_lock<std::mutex> lock(queueLock);
+
+    for (;;)
+    {
+        queueChanged.wait(lock, [this] { return stopping || !queue.empty(); });
+        if (stopping)
+            break;
+
+        // the oldest request waits up to batchWindowMs for others to join it, unless the batch is full
+        const double waitMs = queue.front()->arrivalMs + options.batchWindowMs - Time::getMillisecondCounterHiRes();
+        if (waitMs > 0.0)
+            queueChanged.wait_for(lock, std::chrono::duration<double, std::milli>(waitMs),
+                                  [this, maxBatch] { return stopping || (int)queue.size() >= maxBatch; });
+        if (stopping)
+            break;
+
+        const size_t n = jmin(queue.size(), (size_t)maxBatch);
+        batch.assign(queue.begin(), queue.begin() + (std::ptrdiff_t)n);
+        queue.erase(queue.begin(), queue.begin() + (std::ptrdiff_t)n);
+
+        lock.unlock();
+        const double t0 = Time::getMillisecondCounterHiRes();
+        renderBatch(batch);
+        const double batchMs = Time::getMillisecondCounterHiRes() - t0;
+        lock.lock();
+
+        ++totals.numBatches;
+        sumBatchMs += batchMs;
+        sumBatchSizes += (double)n;
+
+        for (auto& r : batch)
+        {
+            if (r->ok)
+            {
+                ++totals.numRenders;
+                totals.audioSecondsRendered += (double)r->result.getNumSamples() / r->params.sampleRate;
+            }
+            else
+            {
+                ++totals.numFailed;
+            }
+
+            sumQueueMs += r->queueMs;
+            totals.maxQueueMs = jmax(totals.maxQueueMs, r->queueMs);
+            if (recentQueueMs.size() < (size_t)queueHistory)
+                recentQueueMs.push_back(r->queueMs);
+            else
+                recentQueueMs[nextQueueSlot] = r->queueMs;
+            nextQueueSlot = (nextQueueSlot + 1) % (size_t)queueHistory;
+
+            r->done = true;
+        }
+
+        batch.clear();
+        finished.notify_all();
+    }
+
+    for (auto& r : queue)
+    {
+        r->error = "The daemon is shutting down";
+        r->done = true;
+    }
+    queue.clear();
+    finished.notify_all();
+}
+
+void RenderDaemon::renderBatch(std::vector<std::shared_ptr<Request>>& batch)
+{
+    const int numVoices = (int)batch.size();
+    const double batchStart = Time::getMillisecondCounterHiRes();
+
+    std::vector<GeneratorParams> voices;
+    std::vector<AudioBuffer<float>*> results;
+    for (auto& r : batch)
+    {
+        r->queueMs = batchStart - r->arrivalMs;
+        r->batchSize = numVoices;
+        voices.push_back(r->params);
+        results.push_back(&r->result);
+    }
+
+    // a SIMD-width chunk per job, each with its own workspace
+    const int numChunks = (numVoices + lanes - 1) / lanes;
+    ParallelJobs::run(*pool, numChunks, [&](int chunk)
+    {
+        const int first = chunk * lanes;
+        const int count = jmin(lanes, numVoices - first);
+        BatchRender808::renderAll(voices.data() + first, count, results.data() + first, *workspaces[(size_t)chunk], lanes);
+
+        // a long voice leaves the workspace's scratch that long; don't keep it for the daemon's lifetime
+        int longest = 0;
+        for (int v = first; v < first + count; ++v)
+            longest = jmax(longest, results[(size_t)v]->getNumSamples());
+        if (longest > workspaceKeepSamples)
+            workspaces[(size_t)chunk] = std::make_unique<BatchRender808::Workspace>();
+
+        for (int v = first; v < first + count; ++v)
+        {
+            auto& r = *batch[(size_t)v];
+            r.ok = true;
+
+            if (r.output != File())
+            {
+                r.output.getParentDirectory().createDirectory();
+                if (!WavExporter::saveBufferToWav(r.result, r.params.sampleRate, r.output, r.bitsPerSample, -1, r.keepMono))
+                {
+                    r.ok = false;
+                    r.error = "Could not write " + r.output.getFullPathName();
+                }
+            }
+
+            r.renderMs = Time::getMillisecondCounterHiRes() - batchStart;
+        }
+    });
+}
+
+//==============================================================================
+RenderDaemonStats RenderDaemon::getStats() const
+{
+    std::lock_guard<std::mutex> lock(queueLock);
+
+    auto stats = totals;
+    const auto numRequests = (double)(totals.numRenders + totals.numFailed);
+    stats.uptimeSeconds = (Time::getMillisecondCounterHiRes() - startMs) / 1000.0;
+    stats.meanQueueMs = numRequests > 0.0 ? sumQueueMs / numRequests : 0.0;
+    stats.meanBatchMs = totals.numBatches > 0 ? sumBatchMs / (double)totals.numBatches : 0.0;
+    stats.meanBatchSize = totals.numBatches > 0 ? sumBatchSizes / (double)totals.numBatches : 0.0;
+    stats.rendersPerSecond = stats.uptimeSeconds > 0.0 ? (double)totals.numRenders / stats.uptimeSeconds : 0.0;
+
+    if (!recentQueueMs.empty())
+    {
+        auto sorted = recentQueueMs;
+        const auto p95 = sorted.begin() + (std::ptrdiff_t)((sorted.size() - 1) * 95 / 100);
+        std::nth_element(sorted.begin(), p95, sorted.end());
+        stats.p95QueueMs = *p95;
+    }
+
+    return stats;
+}
+
+bool RenderDaemon::parseParams(const var& json, GeneratorParams& params, String& error)
+{
+    auto* object = json.getDynamicObject();
+    if (object == nullptr)
+    {
+        error = "params must be a JSON object";
+        return false;
+    }
+
+    struct NumberField
+    {
+        const char* name;
+        double minimum, maximum;
+        std::function<void(GeneratorParams&, double)> set;
+    };
+
+    static const NumberField numberFields[] = {
+        { "sampleRate",     8000.0, 384000.0, [](GeneratorParams& p, double v) { p.sampleRate = v; } },
+        { "lengthSeconds",  0.001,  60.0,     [](GeneratorParams& p, double v) { p.lengthSeconds = v; } },
+        { "tuneSemitones",  -48.0,  48.0,     [](GeneratorParams& p, double v) { p.tuneSemitones = (float)v; } },
+        { "masterGainDb",   -300.0, 24.0,     [](GeneratorParams& p, double v) { p.masterGainDb = (float)v; } },
+        { "subAmount",      0.0,    1.0,      [](GeneratorParams& p, double v) { p.subAmount = (float)v; } },
+        { "boomAmount",     0.0,    1.0,      [](GeneratorParams& p, double v) { p.boomAmount = (float)v; } },
+        { "shortness",      0.0,    1.0,      [](GeneratorParams& p, double v) { p.shortness = (float)v; } },
+        { "punch",          0.0,    1.0,      [](GeneratorParams& p, double v) { p.punch = (float)v; } },
+        { "growl",          0.0,    1.0,      [](GeneratorParams& p, double v) { p.growl = (float)v; } },
+        { "detune",         0.0,    1.0,      [](GeneratorParams& p, double v) { p.detune = (float)v; } },
+        { "analog",         0.0,    1.0,      [](GeneratorParams& p, double v) { p.analog = (float)v; } },
+        { "clean",          0.0,    1.0,      [](GeneratorParams& p, double v) { p.clean = (float)v; } },
+        { "silenceFloorDb", -160.0, -20.0,    [](GeneratorParams& p, double v) { p.silenceFloorDb = (float)v; } },
+    };
+
+    for (const auto& property : object->getProperties())
+    {
+        const auto name = property.name.toString();
+        const auto& value = property.value;
+
+        if (name == "seed")
+        {
+            // a string for clients whose JSON numbers are doubles
+            if (value.isInt() || value.isInt64())
+                params.seed = (int64)value;
+            else if (!value.isString() || !Generator808::parseSeed(value.toString().trim(), params.seed))
+                return (error = "seed must be an integer or a string of digits, within 64 bits", false);
+            continue;
+        }
+
+        if (name == "oversampling" || name == "engineVersion")
+        {
+            const int v = value.isInt() || value.isInt64() ? (int)value : 0;
+            if (name == "oversampling" && v != 1 && v != 2 && v != 4)
+                return (error = "oversampling must be 1, 2 or 4", false);
+            if (name == "engineVersion" && (v < 1 || v > GeneratorParams::latestEngineVersion))
+                return (error = "engineVersion must be between 1 and " + String(GeneratorParams::latestEngineVersion), false);
+
+            (name == "oversampling" ? params.oversampling : params.engineVersion) = v;
+            continue;
+        }
+
+        if (name == "autoLength")
+        {
+            if (!value.isBool())
+                return (error = "autoLength must be true or false", false);
+            params.autoLength = (bool)value;
+            continue;
+        }
+
+        auto field = std::find_if(std::begin(numberFields), std::end(numberFields),
+                                  [&name](const NumberField& f) { return name == f.name; });
+        if (field == std::end(numberFields))
+            return (error = "Unknown param \"" + name + "\"", false);
+
+        const double v = (double)value;
+        if (!isNumber(value) || !(v >= field->minimum && v <= field->maximum))
+            return (error = name + " must be a number from " + String(field->minimum) + " to " + String(field->maximum), false);
+
+        field->set(params, v);
+    }
+
+    // each field is in range, but not every product of them: the batch scratch grows with the longest voice
+    if (params.lengthSeconds * params.sampleRate > (double)maxRequestSamples)
+        return (error = "lengthSeconds * sampleRate must be at most " + String(maxRequestSamples) + " samples", false);
+
+    return true;
+}
@@ -0,0 +1,143 @@
+#pragma once
+#include <JuceHeader.h>
+#include "808Generator.h"
+#include "BatchGenerator808.h"
+#include "LocalSocket.h"
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ RenderDaemon
+ - Long-running render server for other tools: listens on a UNIX domain socket (LocalSocket) and
+   renders 808s on request, so a pipeline doesn't start a process per file
+ - Protocol: one JSON object per line each way. Each connection has one request in flight; open
+   several connections to render in parallel
+     {"id": 1, "params": {"seed": 42, "detune": 0.3, ...}}            -> inline PCM
+     {"id": 2, "params": {...}, "output": "/abs/path.wav", "bitsPerSample": 24, "mono": true}
+     {"cmd": "stats"}      {"cmd": "shutdown"}
+   params takes any GeneratorParams field by name (unknown names are an error; seed may be a string
+   for clients without 64-bit integers; lengthSeconds * sampleRate is at most maxRequestSamples). Without "engineVersion" a request renders with engine v1,
+   as GeneratorParams does, so old clients keep their sound; new ones name the version. A render answers {"id", "ok", "numChannels", "numSamples",
+   "sampleRate", "queueMs", "renderMs", "batchSize"} plus "output", or "pcmBytes": N followed by N
+   bytes of interleaved native float32. Failures answer {"id", "ok": false, "error"}
+ - Requests that arrive within batchWindowMs of each other (up to maxBatchSize) are rendered as one
+   batch: split into SIMD-width chunks for BatchRender808 across a thread pool kept for the
+   daemon's lifetime, each chunk with its own workspace
+ - getStats: queue latency (arrival to batch start), render time, batch sizes and throughput
+*/
+struct RenderDaemonOptions
+{
+    juce::File socketPath;          // default: RenderDaemon::getDefaultSocketPath()
+    int numThreads = 0;             // render threads, 0 = one per CPU core
+    int maxBatchSize = 64;          // requests rendered together at most
+    double batchWindowMs = 2.0;     // how long the first request of a batch waits for others
+};
+
+struct RenderDaemonStats
+{
+    juce::int64 numRenders = 0;
+    juce::int64 numFailed = 0;
+    juce::int64 numBatches = 0;
+    double uptimeSeconds = 0.0;
+    double meanQueueMs = 0.0, p95QueueMs = 0.0, maxQueueMs = 0.0;  // p95 over the last queueHistory renders
+    double meanBatchMs = 0.0;       // batch start to every render in it finished
+    double meanBatchSize = 0.0;
+    double rendersPerSecond = 0.0;  // over the uptime
+    double audioSecondsRendered = 0.0;
+
+    juce::var toJson() const;
+    juce::String toString() const;
+};
+
+class RenderDaemon
+{
+public:
+    explicit RenderDaemon(const RenderDaemonOptions& options);
+    ~RenderDaemon();
+
+    // binds the socket and starts serving; false with error set if the socket can't be opened
+    bool start(juce::String& error);
+
+    // stops accepting, closes every connection and waits for the threads; pending requests fail
+    void stop();
+
+    // blocks until a client sends {"cmd": "shutdown"} (or stop() is called elsewhere)
+    void waitForShutdownRequest();
+
+    RenderDaemonStats getStats() const;
+    const juce::File& getSocketPath() const noexcept { return socketPath; }
+
+    // <temp folder>/808orade-render.sock
+    static juce::File getDefaultSocketPath();
+
+    // GeneratorParams from a JSON object of field name -> value; false with error set on an unknown
+    // field, a value of the wrong type or a value out of range
+    static bool parseParams(const juce::var& json, GeneratorParams& params, juce::String& error);
+
+private:
+    struct Request
+    {
+        GeneratorParams params;
+        juce::File output;              // empty: answer with inline PCM
+        int bitsPerSample = 24;
+        bool keepMono = false;
+
+        juce::AudioBuffer<float> result;
+        bool ok = false;
+        juce::String error;
+        double arrivalMs = 0.0, queueMs = 0.0, renderMs = 0.0;
+        int batchSize = 0;
+        bool done = false;              // guarded by queueLock, signalled through finished
+    };
+
+    struct Connection
+    {
+        std::unique_ptr<LocalSocket> socket;
+        std::thread thread;
+        std::atomic<bool> finished{ false };
+    };
+
+    void acceptLoop();
+    void serve(Connection& connection);
+    juce::String handleLine(const std::string& line, LocalSocket& socket, bool& keepGoing);
+    bool submitAndWait(const std::shared_ptr<Request>& request);
+    void batchLoop();
+    void renderBatch(std::vector<std::shared_ptr<Request>>& batch);
+    void requestShutdown();
+
+    const RenderDaemonOptions options;
+    const juce::File socketPath;
+    const int lanes;                // voices per chunk: the native SIMD width
+
+    std::unique_ptr<LocalSocket> listener;
+    std::thread acceptThread, batchThread;
+    std::mutex connectionsLock;
+    std::vector<std::unique_ptr<Connection>> connections;
+
+    // the queue, batch state and stats
+    mutable std::mutex queueLock;
+    std::condition_variable queueChanged, finished, shutdownRequested;
+    std::deque<std::shared_ptr<Request>> queue;
+    bool stopping = false, shutdownAsked = false, running = false;
+
+    std::unique_ptr<juce::ThreadPool> pool;
+    std::vector<std::unique_ptr<BatchRender808::Workspace>> workspaces;  // one per chunk of a batch
+
+    // the longest render a request may ask for (60 s at 48 kHz), and the longest a workspace keeps
+    // its scratch for after a batch (10 s at 48 kHz); a longer one is replaced by a fresh workspace
+    static constexpr int maxRequestSamples = 60 * 48000;
+    static constexpr int workspaceKeepSamples = 10 * 48000;
+
+    static constexpr int queueHistory = 1024;
+    double startMs = 0.0;
+    RenderDaemonStats totals;           // numRenders, numFailed, numBatches, audioSecondsRendered
+    double sumQueueMs = 0.0, sumBatchMs = 0.0, sumBatchSizes = 0.0;
+    std::vector<double> recentQueueMs;  // ring of the last queueHistory queue latencies
+    size_t nextQueueSlot = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RenderDaemon)
+};
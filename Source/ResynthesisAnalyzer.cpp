@@ -0,0 +1,179 @@
+#include "ResynthesisAnalyzer.h"
+#include <cmath>
+#include <algorithm>
+
+using namespace juce;
+
+namespace
+{
+    // the generator's comfortable 808 range; detected roots are folded into it
+    constexpr double minRootMidi = 28.0;
+    constexpr double maxRootMidi = 48.0;
+
+    double hzToMidi(double hz) { return 69.0 + 12.0 * std::log2(hz / 440.0); }
+}
+
+ResynthesisAnalyzer::ResynthesisAnalyzer(int order)
+    : fftOrder(order),
+      fftSize(1 << order)
+{
+    fft.reset(new dsp::FFT(fftOrder));
+    fftWindow.assign(fftSize, 0.0f);
+    for (int i = 0; i < fftSize; ++i)
+        fftWindow[i] = 0.5f * (1.0f - std::cos(2.0 * MathConstants<double>::pi * i / (fftSize - 1)));
+
+    fftData.assign(fftSize * 2, 0.0f);
+}
+
+bool ResynthesisAnalyzer::loadMono(AudioFormatManager& formatManager, const File& file,
+                                   AudioBuffer<float>& dest, double& sampleRate)
+{
+    std::unique_ptr<AudioFormatReader> reader(formatManager.createReaderFor(file));
+    if (reader == nullptr || reader->lengthInSamples <= 0)
+        return false;
+
+    sampleRate = reader->sampleRate;
+    const int numSamples = (int)reader->lengthInSamples;
+    const int numChannels = (int)reader->numChannels;
+
+    AudioBuffer<float> decoded(numChannels, numSamples);
+    reader->read(&decoded, 0, numSamples, 0, true, true);
+
+    dest.setSize(1, numSamples);
+    dest.clear();
+    for (int ch = 0; ch < numChannels; ++ch)
+        dest.addFrom(0, 0, decoded, ch, 0, numSamples, 1.0f / (float)numChannels);
+
+    return true;
+}
+
+ResynthesisAnalysis ResynthesisAnalyzer::analyze(const AudioBuffer<float>& mono, double sampleRate)
+{
+    ResynthesisAnalysis result;
+    result.sampleRate = sampleRate;
+    result.lengthSeconds = sampleRate > 0.0 ? mono.getNumSamples() / sampleRate : 0.0;
+
+    computeRMSAndEnvelope(mono, sampleRate, result);
+
+    analyzeSpectrum(mono, sampleRate, result.dominantHz, result.spectralCentroidHz);
+    const double hz = result.dominantHz > 0.0 ? result.dominantHz : 40.0;
+    result.rootMidiNote = roundToInt(jlimit(minRootMidi, maxRootMidi, hzToMidi(hz)));
+    return result;
+}
+
+double ResynthesisAnalyzer::detectDominantFrequency(const AudioBuffer<float>& mono, double sampleRate)
+{
+    double dominantHz = 0.0, centroidHz = 0.0;
+    analyzeSpectrum(mono, sampleRate, dominantHz, centroidHz);
+    return dominantHz;
+}
+
+void ResynthesisAnalyzer::analyzeSpectrum(const AudioBuffer<float>& mono, double sampleRate, double& dominantHz, double& centroidHz)
+{
+    dominantHz = centroidHz = 0.0;
+    if (mono.getNumSamples() < 64) return;
+
+    const int numSamples = mono.getNumSamples();
+    int segLen = jmin(fftSize, numSamples);
+    int start = jlimit(0, numSamples - segLen, numSamples / 2 - segLen / 2);
+
+    // prepare windowed buffer
+    std::fill(fftData.begin(), fftData.end(), 0.0f);
+    const float* rd = mono.getReadPointer(0);
+    for (int i = 0; i < segLen; ++i)
+        fftData[i] = rd[start + i] * fftWindow[i];
+
+    // performRealOnlyForwardTransform expects a non-const float*
+    fft->performRealOnlyForwardTransform(fftData.data());
+
+    int maxBin = 1;
+    float maxVal = 0.0f;
+    double magSum = 0.0, weightedSum = 0.0;
+    int nyquist = fftSize / 2;
+    for (int b = 1; b < nyquist; ++b)
+    {
+        float re = fftData[b * 2];
+        float im = fftData[b * 2 + 1];
+        float mag = std::sqrt(re * re + im * im);
+        if (mag > maxVal)
+        {
+            maxVal = mag;
+            maxBin = b;
+        }
+        magSum += mag;
+        weightedSum += mag * (double)b;
+    }
+
+    const double binHz = sampleRate / (double)fftSize;
+    dominantHz = binHz * (double)maxBin;
+    centroidHz = magSum > 0.0 ? binHz * weightedSum / magSum : 0.0;
+}
+
+void ResynthesisAnalyzer::computeRMSAndEnvelope(const AudioBuffer<float>& mono, double sampleRate, ResynthesisAnalysis& result)
+{
+    const float* d = mono.getReadPointer(0);
+    int N = mono.getNumSamples();
+    if (N <= 0 || sampleRate <= 0.0) return;
+
+    double sum = 0.0;
+    float peak = 0.0f;
+    int peakIndex = 0;
+    for (int i = 0; i < N; ++i)
+    {
+        float s = d[i];
+        sum += s * s;
+        if (std::abs(s) > peak) { peak = std::abs(s); peakIndex = i; }
+    }
+    result.rms = std::sqrt(sum / (double)N);
+    result.peak = peak;
+
+    double thr = peak * 0.1;
+    int attackStart = 0;
+    for (int i = 0; i < peakIndex; ++i)
+        if (std::abs(d[i]) >= thr) { attackStart = i; break; }
+    result.attackSeconds = (peakIndex - attackStart) / sampleRate;
+
+    int releaseIndex = peakIndex;
+    for (int i = peakIndex; i < N; ++i)
+        if (std::abs(d[i]) <= peak * 0.05f) { releaseIndex = i; break; }
+    result.releaseSeconds = (releaseIndex - peakIndex) / sampleRate;
+}
+
+GeneratorParams ResynthesisAnalyzer::makeParams(const ResynthesisAnalysis& analysis, const ResynthesisSettings& settings,
+                                                int64_t seed, double lengthSeconds)
+{
+    // map dominant frequency to a friendly 808 range
+    double domHz = analysis.dominantHz > 0.0 ? analysis.dominantHz : 40.0;
+    double baseMidi = jlimit(minRootMidi, maxRootMidi, hzToMidi(domHz));
+
+    GeneratorParams gp;
+    gp.seed = seed;
+    gp.engineVersion = GeneratorParams::latestEngineVersion;
+    gp.sampleRate = analysis.sampleRate > 0.0 ? analysis.sampleRate : 44100.0;
+    gp.lengthSeconds = lengthSeconds;
+    gp.tuneSemitones = (float)(baseMidi - 36.0); // map generator base to desired midi
+
+    // map knobs to generator params
+    gp.subAmount = settings.subWeight;
+    gp.boomAmount = settings.harmonicSmooth;
+    gp.growl = settings.distortion;
+    gp.punch = settings.transient;
+    gp.detune = settings.glide * 0.4f;
+    gp.analog = settings.noiseBlend * 0.6f;
+    gp.masterGainDb = -1.5f;
+    gp.clean = 1.0f - settings.accuracy;
+    return gp;
+}
+
+int ResynthesisAnalyzer::frequencyToMidiNote(double hz)
+{
+    return hz > 0.0 ? (int)std::round(hzToMidi(hz)) : 0;
+}
+
+String ResynthesisAnalyzer::midiNoteName(int midiNote)
+{
+    static const char* names[] = { "C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B" };
+    int nameIdx = (midiNote + 120) % 12;
+    int octave = (midiNote / 12) - 1;
+    return String(names[nameIdx]) + String(octave);
+}
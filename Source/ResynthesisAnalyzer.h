@@ -0,0 +1,70 @@
+#pragma once
+#include <JuceHeader.h>
+#include <juce_dsp/juce_dsp.h>
+#include "808Generator.h"
+
+// What we measure on a reference sample before resynthesizing it.
+struct ResynthesisAnalysis
+{
+    double dominantHz = 0.0;      // strongest FFT bin around the middle of the file (0 = no pitch found)
+    double spectralCentroidHz = 0.0; // magnitude-weighted mean frequency of the same frame
+    int rootMidiNote = 36;        // detected root clamped to the generator's 808 range (28..48)
+    double rms = 0.0;
+    float peak = 0.0f;
+    double attackSeconds = 0.0;   // 10% of peak -> peak
+    double releaseSeconds = 0.0;  // peak -> 5% of peak
+    double lengthSeconds = 0.0;
+    double sampleRate = 44100.0;
+};
+
+// The resynthesis knob values (all 0..1), mirrored from ResynthesisWindow so the
+// headless / folder paths map an analysis to GeneratorParams exactly like the GUI does.
+struct ResynthesisSettings
+{
+    float harmonicSmooth = 0.5f;
+    float envelopeSmooth = 0.5f;
+    float subWeight = 0.5f;
+    float transient = 0.5f;
+    float distortion = 0.5f;
+    float noiseBlend = 0.5f;
+    float glide = 0.5f;
+    float accuracy = 0.5f;
+};
+
+// Decode + analysis helpers shared by ResynthesisWindow and the folder resynthesizer.
+// One instance owns an FFT and its scratch buffers, so use one instance per thread.
+class ResynthesisAnalyzer
+{
+public:
+    explicit ResynthesisAnalyzer(int fftOrder = 11);
+
+    // Decode a file and downmix it to a single channel. Returns false if the file can't be read.
+    static bool loadMono(juce::AudioFormatManager& formatManager, const juce::File& file,
+                         juce::AudioBuffer<float>& dest, double& sampleRate);
+
+    // Pitch + level + envelope of a mono buffer.
+    ResynthesisAnalysis analyze(const juce::AudioBuffer<float>& mono, double sampleRate);
+
+    // Strongest bin of one Hann-windowed frame taken from the middle of the buffer (0 if too short).
+    double detectDominantFrequency(const juce::AudioBuffer<float>& mono, double sampleRate);
+
+    // Fill RMS / peak / attack / release fields of the analysis.
+    static void computeRMSAndEnvelope(const juce::AudioBuffer<float>& mono, double sampleRate, ResynthesisAnalysis& result);
+
+    // Map an analysis + knob settings onto generator params (same mapping the window has always used).
+    static GeneratorParams makeParams(const ResynthesisAnalysis& analysis, const ResynthesisSettings& settings,
+                                      int64_t seed, double lengthSeconds = 1.6);
+
+    static int frequencyToMidiNote(double hz);
+    static juce::String midiNoteName(int midiNote); // e.g. "C1"
+
+private:
+    // one windowed FFT frame from the middle of the buffer -> strongest bin + centroid
+    void analyzeSpectrum(const juce::AudioBuffer<float>& mono, double sampleRate, double& dominantHz, double& centroidHz);
+
+    int fftOrder;
+    int fftSize;
+    std::unique_ptr<juce::dsp::FFT> fft;
+    std::vector<float> fftWindow;
+    std::vector<float> fftData;
+};
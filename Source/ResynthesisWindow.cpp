@@ -1,17 +1,69 @@
 #include "ResynthesisWindow.h"
+#include "FolderResynthesizer.h"
 #include <cmath>
 #include <algorithm>
 
 using namespace juce;
 
 //
-// SimpleWaveDisplay paint implementation
+// SimpleWaveDisplay implementation
 //
+void ResynthesisWindow::SimpleWaveDisplay::setBuffer(const AudioBuffer<float>* b, std::shared_ptr<const PeakPyramid> p)
+{
+    buf = b;
+    peaks = std::move(p);
+    if (buf == nullptr)
+        peaks.reset();
+    else if (peaks == nullptr || peaks->getNumSamples() != buf->getNumSamples())
+        peaks = std::make_shared<const PeakPyramid>(*buf);
+
+    viewStart = 0;
+    cache.invalidate();
+    repaint();
+}
+
+void ResynthesisWindow::SimpleWaveDisplay::setZoom(double newZoom)
+{
+    // keep the centre of the view where it is
+    const int64 centre = viewStart + getVisibleLength() / 2;
+    zoom = jmax(1.0, newZoom);
+    setViewStart(centre - getVisibleLength() / 2);
+}
+
+int64 ResynthesisWindow::SimpleWaveDisplay::getVisibleLength() const
+{
+    if (!buf) return 0;
+    return jmax<int64>(1, (int64)((double)buf->getNumSamples() / zoom));
+}
+
+void ResynthesisWindow::SimpleWaveDisplay::setViewStart(int64 newStart)
+{
+    const int64 maxStart = buf ? jmax<int64>(0, buf->getNumSamples() - getVisibleLength()) : 0;
+    newStart = jlimit<int64>(0, maxStart, newStart);
+    if (newStart != viewStart)
+    {
+        viewStart = newStart;
+        repaint();
+    }
+}
+
+void ResynthesisWindow::SimpleWaveDisplay::mouseDown(const MouseEvent&)
+{
+    dragStartView = viewStart;
+}
+
+void ResynthesisWindow::SimpleWaveDisplay::mouseDrag(const MouseEvent& e)
+{
+    const int w = jmax(1, getWidth() - 16);
+    const double samplesPerPixel = (double)getVisibleLength() / (double)w;
+    setViewStart(dragStartView - (int64)(e.getDistanceFromDragStartX() * samplesPerPixel));
+}
+
 void ResynthesisWindow::SimpleWaveDisplay::paint(Graphics& g)
 {
     g.fillAll(Colour(0xFF1B1F23));
 
-    if (!buf || buf->getNumSamples() == 0)
+    if (!buf || !peaks || buf->getNumSamples() == 0)
     {
         g.setColour(Colour(0xFF2B2F33));
         g.fillRoundedRectangle(getLocalBounds().toFloat().reduced(6.0f), 6.0f);
@@ -22,26 +74,8 @@ void ResynthesisWindow::SimpleWaveDisplay::paint(Graphics& g)
     g.setColour(Colour(0xFF2B2F33));
     g.fillRoundedRectangle(bounds.toFloat(), 6.0f);
 
-    g.setColour(Colour(0xFF4DB6A9));
-    const int w = bounds.getWidth();
-    const int h = bounds.getHeight();
-    const float* data = buf->getReadPointer(0);
-    const int numSamples = buf->getNumSamples();
-    double step = (double)numSamples / (double)w;
-
-    Path p;
-    p.preallocateSpace(w * 3);
-    for (int x = 0; x < w; ++x)
-    {
-        int si = (int)(x * step);
-        si = jlimit(0, numSamples - 1, si);
-        float v = data[si];
-        float y = jmap(v, -1.0f, 1.0f, (float)bounds.getBottom(), (float)bounds.getY());
-        if (x == 0) p.startNewSubPath(bounds.getX() + x, y);
-        else p.lineTo(bounds.getX() + x, y);
-    }
-
-    g.strokePath(p, PathStrokeType(1.6f));
+    // min/max/RMS columns from the pyramid; only redrawn when the view changes
+    cache.draw(g, bounds, *peaks, buf, viewStart, getVisibleLength(), Colour(0xFF4DB6A9));
 }
 
 //
@@ -72,6 +106,8 @@ ResynthesisWindow::ResynthesisWindow(PluginProcessor& ownerProcessor)
 
     addAndMakeVisible(&originalWave);
     addAndMakeVisible(&resynthWave);
+    addAndMakeVisible(&originalSpectrogram);
+    addAndMakeVisible(&resynthSpectrogram);
 
     addAndMakeVisible(&detectedNoteLabel);
     detectedNoteLabel.setColour(Label::textColourId, Colour(0xffd6dce0));
@@ -112,16 +148,14 @@ ResynthesisWindow::ResynthesisWindow(PluginProcessor& ownerProcessor)
     replaceMainBtn.addListener(this);
     addAndMakeVisible(&exportWavBtn);
     exportWavBtn.addListener(this);
+    addAndMakeVisible(&resynthFolderBtn);
+    resynthFolderBtn.addListener(this);
+    addAndMakeVisible(&indexLibraryBtn);
+    indexLibraryBtn.addListener(this);
+    addAndMakeVisible(&findSimilarBtn);
+    findSimilarBtn.addListener(this);
 
-    // FFT
-    fftOrder = 11; // 2048
-    fftSize = 1 << fftOrder;
-    fft.reset(new dsp::FFT(fftOrder));
-    fftWindow.assign(fftSize, 0.0f);
-    for (int i = 0; i < fftSize; ++i)
-        fftWindow[i] = 0.5f * (1.0f - std::cos(2.0 * MathConstants<double>::pi * i / (fftSize - 1)));
-
-    fftData.assign(fftSize * 2, 0.0f);
+    featureIndex = std::make_shared<FeatureIndex>();
 
     setContentNonOwned(new Component(), true);
     setVisible(false);
@@ -138,6 +172,13 @@ ResynthesisWindow::~ResynthesisWindow()
     playResynthBtn.removeListener(this);
     replaceMainBtn.removeListener(this);
     exportWavBtn.removeListener(this);
+    resynthFolderBtn.removeListener(this);
+    indexLibraryBtn.removeListener(this);
+    findSimilarBtn.removeListener(this);
+
+    // let a running folder job finish its current files and stop
+    if (folderJobCancel)
+        folderJobCancel->store(true);
 }
 
 void ResynthesisWindow::open()
@@ -175,26 +216,16 @@ void ResynthesisWindow::buttonClicked(Button* b)
             {
                 fileNameLabel.setText(f.getFileName(), dontSendNotification);
 
-                std::unique_ptr<AudioFormatReader> reader (formatManager.createReaderFor(f));
-                if (reader != nullptr)
+                if (ResynthesisAnalyzer::loadMono(formatManager, f, loadedBuffer, loadedSampleRate))
                 {
-                    loadedSampleRate = reader->sampleRate;
-                    loadedBuffer.setSize((int)reader->numChannels, (int)reader->lengthInSamples);
-                    reader->read(&loadedBuffer, 0, (int)reader->lengthInSamples, 0, true, true);
-
-                    if (loadedBuffer.getNumChannels() > 1)
-                    {
-                        AudioBuffer<float> mono(1, loadedBuffer.getNumSamples());
-                        mono.clear();
-                        for (int ch = 0; ch < loadedBuffer.getNumChannels(); ++ch)
-                            mono.addFrom(0, 0, loadedBuffer, ch, 0, loadedBuffer.getNumSamples(), 1.0f / (float)loadedBuffer.getNumChannels());
-                        loadedBuffer = mono;
-                    }
-
                     originalWave.setBuffer(&loadedBuffer);
+                    originalWave.setZoom(zoomSlider.getValue());
+                    originalSpectrogram.setBuffer(loadedBuffer, loadedSampleRate);
                     hasLoaded = true;
+                    loadedFile = f;
+                    hasClosestSeed = false;
 
-                    analyzeLoadedFile();
+                    analyzeLoadedFile(true);
                 }
                 else
                 {
@@ -216,41 +247,22 @@ void ResynthesisWindow::buttonClicked(Button* b)
             return;
         }
 
-        // detect dominant frequency and map to a friendly 808 range
-        double domHz = detectDominantFrequency();
-        if (domHz <= 0.0) domHz = 40.0;
-
-        double midi = 69.0 + 12.0 * std::log2(domHz / 440.0);
-        double baseMidi = midi;
-        if (baseMidi > 48.0) baseMidi = 48.0;
-        if (baseMidi < 28.0) baseMidi = jlimit(28.0, 48.0, baseMidi);
-
-        GeneratorParams gp;
-        gp.seed = (int64_t)std::chrono::high_resolution_clock::now().time_since_epoch().count();
-        gp.sampleRate = loadedSampleRate > 0.0 ? loadedSampleRate : 44100.0;
-        gp.lengthSeconds = 1.6;
-        gp.tuneSemitones = (float)(baseMidi - 36.0); // map generator base to desired midi
-
-        // map knobs to generator params
-        gp.subAmount = (float)subWeightKnob.getValue();
-        gp.boomAmount = (float)harmonicSmoothKnob.getValue();
-        gp.growl = (float)distortionKnob.getValue();
-        gp.punch = (float)transientKnob.getValue();
-        gp.detune = (float)(glideKnob.getValue() * 0.4);
-        gp.analog = (float)(noiseBlendKnob.getValue() * 0.6);
-        gp.masterGainDb = -1.5f;
-        gp.clean = (float)(1.0f - accuracyKnob.getValue());
+        // the dominant frequency from the last analysis is mapped to a friendly 808 range
+        // a seed picked by Find Similar wins over a fresh random one
+        auto seed = hasClosestSeed ? closestSeed
+                                   : (int64_t)std::chrono::high_resolution_clock::now().time_since_epoch().count();
+        GeneratorParams gp = ResynthesisAnalyzer::makeParams(lastAnalysis, getCurrentSettings(), seed);
 
         // generate using the PluginProcessor API so main window can display it
         bool ok = owner.generate808AndStore(gp);
         if (ok)
         {
-            // get buffer published by owner
-            auto p = owner.getGeneratedBufferSharedPtr();
-            if (p)
+            // get buffer published by owner, with the peaks built from that same buffer
+            auto sound = owner.getGeneratedSound();
+            if (sound.buffer)
             {
-                generatedPtr = p;
-                resynthWave.setBuffer(generatedPtr.get());
+                generatedPtr = sound.buffer;
+                resynthWave.setBuffer(generatedPtr.get(), sound.peaks);
             }
             else
             {
@@ -261,6 +273,8 @@ void ResynthesisWindow::buttonClicked(Button* b)
                 generatedPtr->makeCopyOf(buf);
                 resynthWave.setBuffer(generatedPtr.get());
             }
+            resynthWave.setZoom(zoomSlider.getValue());
+            resynthSpectrogram.setBuffer(std::shared_ptr<const AudioBuffer<float>>(generatedPtr), gp.sampleRate);
 
             // start preview if the processor supports it
             try
@@ -302,105 +316,232 @@ void ResynthesisWindow::buttonClicked(Button* b)
 
             juce::File out = f;
             if (! out.hasFileExtension("wav")) out = out.withFileExtension(".wav");
-            bool saved = WavExporter::saveBufferToWav(*generatedPtr, loadedSampleRate > 0.0 ? loadedSampleRate : 44100.0, out, 24);
+            bool saved = WavExporter::saveBufferToWav(*generatedPtr, loadedSampleRate > 0.0 ? loadedSampleRate : 44100.0, out, 24,
+                                                      hasLoaded ? lastAnalysis.rootMidiNote : -1);
             if (saved)
                 AlertWindow::showMessageBoxAsync(AlertWindow::InfoIcon, "Saved", "WAV exported: " + out.getFullPathName());
             else
                 AlertWindow::showMessageBoxAsync(AlertWindow::WarningIcon, "Error", "Failed to write WAV.");
         });
     }
+    else if (b == &resynthFolderBtn)
+    {
+        chooseFoldersAndResynthesize();
+    }
+    else if (b == &indexLibraryBtn)
+    {
+        chooseAndIndexLibrary();
+    }
+    else if (b == &findSimilarBtn)
+    {
+        findSimilar();
+    }
 }
 
 void ResynthesisWindow::sliderValueChanged(Slider* s)
 {
     if (s == &zoomSlider)
-        originalWave.repaint();
+    {
+        originalWave.setZoom(s->getValue());
+        resynthWave.setZoom(s->getValue());
+    }
 }
 
-void ResynthesisWindow::analyzeLoadedFile()
+void ResynthesisWindow::analyzeLoadedFile(bool useIndex)
 {
     if (!hasLoaded) return;
 
-    computeRMSAndEnvelope();
+    // library files that were indexed before don't need another FFT pass
+    AudioFeatures indexed;
+    if (useIndex && featureIndex->lookupFile(loadedFile, indexed))
+        lastAnalysis = FeatureIndex::toAnalysis(indexed);
+    else
+        lastAnalysis = analyzer.analyze(loadedBuffer, loadedSampleRate);
 
-    double domHz = detectDominantFrequency();
-    if (domHz <= 0.0) domHz = 40.0;
+    double domHz = lastAnalysis.dominantHz > 0.0 ? lastAnalysis.dominantHz : 40.0;
+    detectedNoteLabel.setText(ResynthesisAnalyzer::midiNoteName(ResynthesisAnalyzer::frequencyToMidiNote(domHz)), dontSendNotification);
 
-    pitchHzLabel.setText(String(domHz, 2) + " Hz", dontSendNotification);
-
-    double midi = 69.0 + 12.0 * std::log2(domHz / 440.0);
-    int midiInt = (int)std::round(midi);
-    static const char* names[] = { "C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B" };
-    int nameIdx = (midiInt + 120) % 12;
-    int octave = (midiInt / 12) - 1;
-    detectedNoteLabel.setText(String(names[nameIdx]) + String(octave), dontSendNotification);
+    String info = "RMS: " + String(lastAnalysis.rms, 4) + "  A: " + String(lastAnalysis.attackSeconds, 3)
+                + "s  R: " + String(lastAnalysis.releaseSeconds, 3) + "s";
+    pitchHzLabel.setText(String(domHz, 2) + " Hz  |  " + info, dontSendNotification);
 }
 
-double ResynthesisWindow::detectDominantFrequency()
+ResynthesisSettings ResynthesisWindow::getCurrentSettings() const
 {
-    if (!hasLoaded || loadedBuffer.getNumSamples() < 64) return 0.0;
+    ResynthesisSettings st;
+    st.harmonicSmooth = (float)harmonicSmoothKnob.getValue();
+    st.envelopeSmooth = (float)envelopeSmoothKnob.getValue();
+    st.subWeight = (float)subWeightKnob.getValue();
+    st.transient = (float)transientKnob.getValue();
+    st.distortion = (float)distortionKnob.getValue();
+    st.noiseBlend = (float)noiseBlendKnob.getValue();
+    st.glide = (float)glideKnob.getValue();
+    st.accuracy = (float)accuracyKnob.getValue();
+    return st;
+}
 
-    const int numSamples = loadedBuffer.getNumSamples();
-    int segLen = jmin(fftSize, numSamples);
-    int start = jlimit(0, numSamples - segLen, numSamples / 2 - segLen / 2);
+void ResynthesisWindow::chooseFoldersAndResynthesize()
+{
+    if (folderJobCancel)
+    {
+        AlertWindow::showMessageBoxAsync(AlertWindow::InfoIcon, "Busy", "A folder resynthesis is already running.");
+        return;
+    }
 
-    // prepare windowed buffer
-    std::fill(fftData.begin(), fftData.end(), 0.0f);
-    const float* rd = loadedBuffer.getReadPointer(0);
-    for (int i = 0; i < segLen; ++i)
-        fftData[i] = rd[start + i] * fftWindow[i];
+    // pick the source folder, then the destination folder
+    folderChooser.reset(new FileChooser("Select folder of 808s to resynthesize",
+                                        File::getSpecialLocation(File::userDesktopDirectory), ""));
+    folderChooser->launchAsync(FileBrowserComponent::openMode | FileBrowserComponent::canSelectDirectories,
+        [this](const FileChooser& fc)
+    {
+        File in = fc.getResult();
+        if (!in.isDirectory()) return;
 
-    // performRealOnlyForwardTransform expects a non-const float*
-    fft->performRealOnlyForwardTransform(fftData.data());
+        folderChooser.reset(new FileChooser("Select destination folder", in.getParentDirectory(), ""));
+        folderChooser->launchAsync(FileBrowserComponent::openMode | FileBrowserComponent::canSelectDirectories,
+            [this, in](const FileChooser& fc2)
+        {
+            File out = fc2.getResult();
+            if (out.isDirectory())
+                startFolderResynthesis(in, out);
+        });
+    });
+}
 
-    int maxBin = 1;
-    float maxVal = 0.0f;
-    int nyquist = fftSize / 2;
-    for (int b = 1; b < nyquist; ++b)
+void ResynthesisWindow::startFolderResynthesis(const File& inputFolder, const File& outputFolder)
+{
+    FolderResynthesisOptions options;
+    options.inputFolder = inputFolder;
+    options.outputFolder = outputFolder;
+    options.settings = getCurrentSettings();
+    options.baseSeed = (int64_t)std::chrono::high_resolution_clock::now().time_since_epoch().count();
+    options.featureIndex = featureIndex.get();
+
+    auto cancel = std::make_shared<std::atomic<bool>>(false);
+    folderJobCancel = cancel;
+    resynthFolderBtn.setEnabled(false);
+    fileNameLabel.setText("Resynthesizing " + inputFolder.getFileName() + "...", dontSendNotification);
+
+    Component::SafePointer<ResynthesisWindow> safeThis(this);
+
+    // the index is captured only to keep options.featureIndex alive while the job runs
+    Thread::launch([options, cancel, safeThis, index = featureIndex]()
     {
-        float re = fftData[b * 2];
-        float im = fftData[b * 2 + 1];
-        float mag = std::sqrt(re * re + im * im);
-        if (mag > maxVal)
+        auto report = FolderResynthesizer::run(options,
+            [safeThis](const FolderResynthesisFileResult&, int done, int total)
+            {
+                MessageManager::callAsync([safeThis, done, total]()
+                {
+                    if (safeThis != nullptr)
+                        safeThis->fileNameLabel.setText("Resynthesizing " + String(done) + " / " + String(total), dontSendNotification);
+                });
+            },
+            cancel.get());
+
+        auto summary = report.summary();
+        juce::Logger::writeToLog("Folder resynthesis:\n" + summary);
+
+        MessageManager::callAsync([safeThis, report, summary]()
         {
-            maxVal = mag;
-            maxBin = b;
-        }
+            if (safeThis == nullptr) return;
+            safeThis->folderJobCancel.reset();
+            safeThis->resynthFolderBtn.setEnabled(true);
+            safeThis->fileNameLabel.setText("Folder done: " + String(report.numSucceeded) + " / " + String((int)report.files.size()), dontSendNotification);
+
+            // the alert only shows the totals line; the per-file timings go to the log
+            AlertWindow::showMessageBoxAsync(AlertWindow::InfoIcon, "Folder Resynthesis",
+                                             summary.fromLastOccurrenceOf("\n", false, false));
+        });
+    });
+}
+
+void ResynthesisWindow::chooseAndIndexLibrary()
+{
+    if (indexJobRunning)
+    {
+        AlertWindow::showMessageBoxAsync(AlertWindow::InfoIcon, "Busy", "The library is already being indexed.");
+        return;
     }
 
-    double binFreq = (double)loadedSampleRate * (double)maxBin / (double)fftSize;
-    return binFreq;
+    folderChooser.reset(new FileChooser("Select reference library folder to index",
+                                        File::getSpecialLocation(File::userDocumentsDirectory), ""));
+    folderChooser->launchAsync(FileBrowserComponent::openMode | FileBrowserComponent::canSelectDirectories,
+        [this](const FileChooser& fc)
+    {
+        File folder = fc.getResult();
+        if (!folder.isDirectory()) return;
+
+        indexJobRunning = true;
+        indexLibraryBtn.setEnabled(false);
+
+        Component::SafePointer<ResynthesisWindow> safeThis(this);
+        Thread::launch([folder, safeThis, index = featureIndex]()
+        {
+            auto stats = index->update(folder, true, 0, [safeThis](int done, int total)
+            {
+                if (done % 64 != 0 && done != total)
+                    return; // libraries can be huge; don't flood the message queue
+
+                MessageManager::callAsync([safeThis, done, total]()
+                {
+                    if (safeThis != nullptr)
+                        safeThis->fileNameLabel.setText("Indexing " + String(done) + " / " + String(total), dontSendNotification);
+                });
+            });
+
+            MessageManager::callAsync([safeThis, stats, index]()
+            {
+                if (safeThis == nullptr) return;
+                safeThis->indexJobRunning = false;
+                safeThis->indexLibraryBtn.setEnabled(true);
+                safeThis->fileNameLabel.setText(String(index->getNumRecords()) + " samples indexed", dontSendNotification);
+                AlertWindow::showMessageBoxAsync(AlertWindow::InfoIcon, "Library Index", stats.toString());
+            });
+        });
+    });
 }
 
-void ResynthesisWindow::computeRMSAndEnvelope()
+void ResynthesisWindow::findSimilar()
 {
-    if (!hasLoaded) return;
+    if (!hasLoaded)
+    {
+        AlertWindow::showMessageBoxAsync(AlertWindow::WarningIcon, "No file", "Upload a file first.");
+        return;
+    }
+    if (similarJobRunning)
+        return;
 
-    const float* d = loadedBuffer.getReadPointer(0);
-    int N = loadedBuffer.getNumSamples();
+    similarJobRunning = true;
+    findSimilarBtn.setEnabled(false);
 
-    double sum = 0.0;
-    float peak = 0.0f;
-    int peakIndex = 0;
-    for (int i = 0; i < N; ++i)
+    const auto query = FeatureIndex::makeFeatures(0, lastAnalysis);
+    const auto seedParams = ResynthesisAnalyzer::makeParams(lastAnalysis, getCurrentSettings(), 0);
+
+    Component::SafePointer<ResynthesisWindow> safeThis(this);
+    Thread::launch([safeThis, query, seedParams, index = featureIndex, cached = librarySearch]()
     {
-        float s = d[i];
-        sum += s * s;
-        if (std::abs(s) > peak) { peak = std::abs(s); peakIndex = i; }
-    }
-    double rms = std::sqrt(sum / (double)N);
+        // rebuilding is O(n) and only needed after the library was (re)indexed
+        auto search = cached;
+        if (search == nullptr || search->size() != index->getNumRecords())
+            search = std::make_shared<const SimilaritySearch>(SimilaritySearch::fromFeatureIndex(*index));
 
-    double thr = peak * 0.1;
-    int attackStart = 0;
-    for (int i = 0; i < peakIndex; ++i)
-        if (std::abs(d[i]) >= thr) { attackStart = i; break; }
-    double attackTime = (peakIndex - attackStart) / loadedSampleRate;
+        auto results = SimilaritySearch::findSimilar(query, *search, seedParams, 256, 8);
+        auto text = results.describe(*index);
 
-    int releaseIndex = peakIndex;
-    for (int i = peakIndex; i < N; ++i)
-        if (std::abs(d[i]) <= peak * 0.05f) { releaseIndex = i; break; }
-    double releaseTime = (releaseIndex - peakIndex) / loadedSampleRate;
+        MessageManager::callAsync([safeThis, search, results, text]()
+        {
+            if (safeThis == nullptr) return;
+            safeThis->librarySearch = search;
+            safeThis->similarJobRunning = false;
+            safeThis->findSimilarBtn.setEnabled(true);
 
-    String info = "RMS: " + String(rms, 4) + "  A: " + String(attackTime, 3) + "s  R: " + String(releaseTime, 3) + "s";
-    pitchHzLabel.setText(pitchHzLabel.getText() + "  |  " + info, dontSendNotification);
+            if (!results.seeds.empty())
+            {
+                safeThis->hasClosestSeed = true;
+                safeThis->closestSeed = (int64_t)results.seeds.front().id;
+            }
+
+            AlertWindow::showMessageBoxAsync(AlertWindow::InfoIcon, "Similar 808s", text);
+        });
+    });
 }
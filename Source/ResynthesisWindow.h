@@ -4,10 +4,20 @@
 #include "PluginProcessor.h"   // need concrete type here
 #include "808Generator.h"
 #include "WavExporter.h"
+#include "ResynthesisAnalyzer.h"
+#include "FeatureIndex.h"
+#include "SimilaritySearch.h"
+#include "PeakPyramid.h"
+#include "SpectrogramComponent.h"
+#include <atomic>
 
 // ResynthesisWindow
 // - Upload-only resynthesis UI
 // - Calls PluginProcessor::generate808AndStore(...) so the generated result is visible in main window
+// - "Resynthesize Folder..." runs FolderResynthesizer over a whole folder in the background
+// - "Index Library..." adds a reference folder to the on-disk FeatureIndex; indexed files skip the FFT
+// - "Find Similar" lists the closest indexed samples and generator seeds to the loaded file;
+//   the closest seed is used by the next Generate Resynth
 class ResynthesisWindow : public juce::DocumentWindow,
     private juce::Button::Listener,
     private juce::Slider::Listener
@@ -33,20 +43,33 @@ private:
     juce::Label fileNameLabel;
     juce::TextButton analyzeBtn{ "Analyze" };
 
-    // simple waveform display (left)
+    // simple waveform display (left); zoom shows 1/zoom of the buffer, drag pans
     class SimpleWaveDisplay : public juce::Component
     {
     public:
         SimpleWaveDisplay() = default;
-        void setBuffer(const juce::AudioBuffer<float>* b) { buf = b; repaint(); }
+        void setBuffer(const juce::AudioBuffer<float>* b, std::shared_ptr<const PeakPyramid> p = nullptr);
+        void setZoom(double newZoom);
         void paint(juce::Graphics& g) override;
+        void mouseDown(const juce::MouseEvent& e) override;
+        void mouseDrag(const juce::MouseEvent& e) override;
 
     private:
+        juce::int64 getVisibleLength() const;
+        void setViewStart(juce::int64 newStart);
+
         const juce::AudioBuffer<float>* buf = nullptr;
+        std::shared_ptr<const PeakPyramid> peaks;
+        WaveformImageCache cache;
+        double zoom = 1.0;
+        juce::int64 viewStart = 0;
+        juce::int64 dragStartView = 0;
     };
 
     SimpleWaveDisplay originalWave;
     SimpleWaveDisplay resynthWave;
+    SpectrogramComponent originalSpectrogram;
+    SpectrogramComponent resynthSpectrogram;
 
     juce::Label detectedNoteLabel;
     juce::Label pitchHzLabel;
@@ -66,30 +89,45 @@ private:
     juce::TextButton playResynthBtn{ "Play Resynth" };
     juce::TextButton replaceMainBtn{ "Replace Main Window 808" };
     juce::TextButton exportWavBtn{ "Export Resynth (WAV)" };
+    juce::TextButton resynthFolderBtn{ "Resynthesize Folder..." };
+    juce::TextButton indexLibraryBtn{ "Index Library..." };
+    juce::TextButton findSimilarBtn{ "Find Similar" };
 
     // Internals
     juce::AudioFormatManager formatManager;
     juce::AudioBuffer<float> loadedBuffer;
+    juce::File loadedFile;
     double loadedSampleRate = 44100.0;
     bool hasLoaded = false;
 
     std::shared_ptr<juce::AudioBuffer<float>> generatedPtr;
 
     // FFT / analysis
-    int fftOrder = 11;
-    int fftSize = 1 << fftOrder;
-    std::unique_ptr<juce::dsp::FFT> fft;
+    ResynthesisAnalyzer analyzer;
+    ResynthesisAnalysis lastAnalysis;
+    std::shared_ptr<FeatureIndex> featureIndex; // shared with background jobs so it outlives the window
+
+    // folder mode (chooser must outlive launchAsync; flag is shared with the worker thread)
+    std::unique_ptr<juce::FileChooser> folderChooser;
+    std::shared_ptr<std::atomic<bool>> folderJobCancel;
+    bool indexJobRunning = false;
 
-    std::vector<float> fftWindow;
-    std::vector<float> fftData;
+    // similarity search over the index, rebuilt when the record count changes
+    std::shared_ptr<const SimilaritySearch> librarySearch;
+    bool similarJobRunning = false;
+    bool hasClosestSeed = false;
+    int64_t closestSeed = 0;
 
     // helpers
     void buildUI();
     void layoutChildren();
 
-    void analyzeLoadedFile();
-    double detectDominantFrequency(); // removed const - method mutates fftData
-    void computeRMSAndEnvelope();
+    void analyzeLoadedFile(bool useIndex = false);
+    ResynthesisSettings getCurrentSettings() const;
+    void chooseFoldersAndResynthesize();
+    void startFolderResynthesis(const juce::File& inputFolder, const juce::File& outputFolder);
+    void chooseAndIndexLibrary();
+    void findSimilar();
 
     // listeners
     void buttonClicked(juce::Button* b) override;
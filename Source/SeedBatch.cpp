@@ -0,0 +1,181 @@
+#include "SeedBatch.h"
+#include "BatchGenerator808.h"
+#include "FolderResynthesizer.h"
+#include "ParallelJobs.h"
+#include "WavExporter.h"
+
+using namespace juce;
+
+namespace
+{
+    // voices handed to BatchRender808::renderAll at once: a few batches of the widest lane count,
+    // small enough that a chunk's buffers don't pile up in memory
+    constexpr int renderChunk = 64;
+
+    // what every shard of one batch has to agree on
+    var optionsToJson(const SeedBatchOptions& o)
+    {
+        const auto& p = o.params;
+        DynamicObject::Ptr j = new DynamicObject();
+        j->setProperty("firstSeed", String(o.firstSeed));
+        j->setProperty("count", o.count);
+        j->setProperty("engineVersion", GeneratorParams::latestEngineVersion);
+        j->setProperty("sampleRate", p.sampleRate);
+        j->setProperty("lengthSeconds", p.lengthSeconds);
+        j->setProperty("autoLength", p.autoLength);
+        j->setProperty("silenceFloorDb", p.silenceFloorDb);
+        j->setProperty("oversampling", p.oversampling);
+        j->setProperty("tuneSemitones", p.tuneSemitones);
+        j->setProperty("masterGainDb", p.masterGainDb);
+        j->setProperty("subAmount", p.subAmount);
+        j->setProperty("boomAmount", p.boomAmount);
+        j->setProperty("shortness", p.shortness);
+        j->setProperty("punch", p.punch);
+        j->setProperty("growl", p.growl);
+        j->setProperty("detune", p.detune);
+        j->setProperty("analog", p.analog);
+        j->setProperty("clean", p.clean);
+        j->setProperty("bitsPerSample", o.bitsPerSample);
+        j->setProperty("monoFiles", o.monoFiles);
+        return var(j.get());
+    }
+}
+
+Range<int> SeedBatch::getShardRange(int count, int shard, int numShards)
+{
+    numShards = jmax(1, numShards);
+    shard = jlimit(1, numShards, shard);
+    const auto boundary = [count, numShards](int k) { return (int)((int64)count * k / numShards); };
+    return { boundary(shard - 1), boundary(shard) };
+}
+
+int SeedBatch::shardOfIndex(int index, int count, int numShards)
+{
+    if (index < 0 || index >= count)
+        return 0;
+
+    // the first shard k whose range ends past index: count * k / numShards > index
+    numShards = jmax(1, numShards);
+    return (int)(((int64)(index + 1) * numShards + count - 1) / count);
+}
+
+SeedBatchReport SeedBatch::run(const SeedBatchOptions& options)
+{
+    SeedBatchReport report;
+
+    const auto range = getShardRange(jmax(0, options.count), options.shard, options.numShards);
+    report.items.resize((size_t)range.getLength());
+    for (int i = 0; i < range.getLength(); ++i)
+    {
+        auto& item = report.items[(size_t)i];
+        item.index = range.getStart() + i;
+        item.seed = seedAt(options.firstSeed, item.index);
+        item.output = options.outputFolder.getChildFile("seed_" + String((int64)item.seed) + ".wav");
+    }
+
+    if (report.items.empty())
+        return report;
+
+    if (!options.outputFolder.isDirectory() && options.outputFolder.createDirectory().failed())
+    {
+        for (auto& item : report.items)
+            item.error = "could not create " + options.outputFolder.getFullPathName();
+        return report;
+    }
+
+    report.numThreads = ParallelJobs::resolveThreadCount(options.numThreads);
+
+    const double start = Time::getMillisecondCounterHiRes();
+    const int numChunks = (range.getLength() + renderChunk - 1) / renderChunk;
+
+    ParallelJobs::run(numChunks, report.numThreads, [&](int c)
+    {
+        const int first = c * renderChunk;
+        const int last = jmin(range.getLength(), first + renderChunk);
+
+        std::vector<GeneratorParams> voices;
+        voices.reserve((size_t)(last - first));
+        for (int i = first; i < last; ++i)
+        {
+            auto p = options.params;
+            p.seed = report.items[(size_t)i].seed;
+            p.engineVersion = GeneratorParams::latestEngineVersion;
+            voices.push_back(p);
+        }
+
+        // same output as Generator808::renderToBuffer per voice
+        const auto buffers = BatchRender808::renderAll(voices);
+
+        for (int i = first; i < last; ++i)
+        {
+            auto& item = report.items[(size_t)i];
+            const auto& buf = buffers[(size_t)(i - first)];
+            item.renderedSeconds = buf.getNumSamples() / options.params.sampleRate;
+            item.ok = buf.getNumSamples() > 0
+                && WavExporter::saveBufferToWav(buf, options.params.sampleRate, item.output, options.bitsPerSample, -1, options.monoFiles);
+            if (!item.ok)
+                item.error = "could not write " + item.output.getFullPathName();
+        }
+    });
+
+    report.wallSeconds = (Time::getMillisecondCounterHiRes() - start) / 1000.0;
+    for (auto& item : report.items)
+        if (item.ok) ++report.numSucceeded;
+
+    return report;
+}
+
+String SeedBatchReport::summary() const
+{
+    String s;
+    for (auto& item : items)
+        if (!item.ok)
+            s << "seed " << String((int64)item.seed) << ": FAILED (" << item.error << ")\n";
+
+    s << numSucceeded << " / " << (int)items.size() << " seeds";
+    if (!items.empty())
+        s << " (" << items.front().index << " .. " << items.back().index << ")";
+    s << " in " << String(wallSeconds, 2) << " s on " << numThreads << " threads: "
+      << String(wallSeconds > 0.0 ? (double)items.size() / wallSeconds : 0.0, 1) << " renders/s";
+    return s;
+}
+
+bool SeedBatch::writeShardManifest(const SeedBatchOptions& options, const SeedBatchReport& report, String& error)
+{
+    Array<var> items;
+    for (auto& item : report.items)
+    {
+        DynamicObject::Ptr json = new DynamicObject();
+        json->setProperty("index", item.index);
+        json->setProperty("ok", item.ok);
+        json->setProperty("seed", String((int64)item.seed));
+        if (item.ok)
+        {
+            json->setProperty("output", item.output.getFileName());
+            json->setProperty("seconds", item.renderedSeconds);
+        }
+        else
+        {
+            json->setProperty("error", item.error);
+        }
+        items.add(var(json.get()));
+    }
+
+    DynamicObject::Ptr root = new DynamicObject();
+    root->setProperty("formatVersion", FolderResynthesizer::manifestFormatVersion);
+    root->setProperty("kind", "seeds");
+    root->setProperty("shard", options.shard);
+    root->setProperty("numShards", options.numShards);
+    root->setProperty("options", optionsToJson(options));
+    root->setProperty("numSucceeded", report.numSucceeded);
+    root->setProperty("wallSeconds", report.wallSeconds);
+    root->setProperty("files", items);
+
+    const auto file = FolderResynthesizer::getShardManifestFile(options.outputFolder, options.shard, options.numShards);
+    if (options.outputFolder.createDirectory().failed() || !FolderResynthesizer::writeJsonAtomically(var(root.get()), file))
+    {
+        error = "could not write " + file.getFullPathName();
+        return false;
+    }
+    return true;
+}
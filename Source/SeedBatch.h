@@ -0,0 +1,65 @@
+#pragma once
+#include <JuceHeader.h>
+#include "808Generator.h"
+#include <vector>
+
+/*
+ SeedBatch
+ - The headless seed batch (--render-seeds): count consecutive seeds from firstSeed, rendered with
+   otherwise fixed params through the SIMD batch renderer (BatchRender808) on a thread pool and
+   written as <outputFolder>/seed_<seed>.wav
+ - Sharding spreads one batch over several processes or machines sharing a filesystem: the items
+   are split into numShards contiguous index ranges (getShardRange), so every process knows its
+   seeds from count, shard and numShards alone and no two shards render the same seed
+ - Each shard writes a manifest in the --resynth-folder format (kind "seeds", one item per index);
+   FolderResynthesizer::mergeShardManifests checks and combines them into one pack index
+*/
+
+struct SeedBatchOptions
+{
+    juce::File outputFolder;
+    GeneratorParams params;        // everything but the seed (and the engine version: the latest)
+    int64_t firstSeed = 0;         // item i renders firstSeed + i, wrapping past INT64_MAX
+    int count = 0;                 // items of the whole batch, over all shards
+    int numThreads = 0;            // 0 = one per CPU core
+    int bitsPerSample = 24;
+    bool monoFiles = false;        // write renders without stereo width as mono WAVs (half the size)
+    int shard = 1, numShards = 1;  // 1-based: render only the index range of shard `shard` of numShards
+};
+
+struct SeedBatchItemResult
+{
+    int index = 0;
+    int64_t seed = 0;
+    juce::File output;
+    bool ok = false;
+    juce::String error;
+    double renderedSeconds = 0.0;
+};
+
+struct SeedBatchReport
+{
+    std::vector<SeedBatchItemResult> items; // this shard's, by index
+    int numSucceeded = 0;
+    double wallSeconds = 0.0;
+    int numThreads = 0;
+
+    juce::String summary() const;
+};
+
+class SeedBatch
+{
+public:
+    static SeedBatchReport run(const SeedBatchOptions& options);
+
+    // the indices [start, end) shard `shard` (1-based) of numShards renders out of count
+    static juce::Range<int> getShardRange(int count, int shard, int numShards);
+
+    // the shard whose range holds index, 0 if index is outside [0, count)
+    static int shardOfIndex(int index, int count, int numShards);
+
+    static int64_t seedAt(int64_t firstSeed, int index) { return (int64_t)((uint64_t)firstSeed + (uint64_t)index); }
+
+    // the manifest of the shard run() just rendered (FolderResynthesizer::getShardManifestFile)
+    static bool writeShardManifest(const SeedBatchOptions& options, const SeedBatchReport& report, juce::String& error);
+};
@@ -0,0 +1,260 @@
+#include "SimilaritySearch.h"
+#include "ParallelJobs.h"
+#include <algorithm>
+#include <limits>
+
+using namespace juce;
+
+namespace
+{
+    // padding items sit far outside any z-scored range so they never make the top K
+    constexpr float padValue = 1.0e15f;
+
+    bool closer(const SimilaritySearch::Match& a, const SimilaritySearch::Match& b) { return a.distance < b.distance; }
+}
+
+SimilaritySearch::FeatureVector SimilaritySearch::makeVector(const AudioFeatures& f)
+{
+    const float rmsLog = std::log10(f.rms + 1.0e-6f);
+    const float peakLog = std::log10(f.peak + 1.0e-6f);
+
+    FeatureVector v;
+    v[0] = std::log2(jmax(1.0f, f.f0Hz));                  // octaves
+    v[1] = std::log10(f.attackSeconds * 1000.0f + 1.0f);   // log ms
+    v[2] = std::log10(f.releaseSeconds * 1000.0f + 1.0f);
+    v[3] = std::log2(jmax(1.0f, f.spectralCentroidHz));
+    v[4] = rmsLog;
+    v[5] = peakLog;
+    v[6] = std::log10(f.lengthSeconds + 1.0e-3f);
+    v[7] = peakLog - rmsLog;                               // crest factor
+    return v;
+}
+
+void SimilaritySearch::clear()
+{
+    ids.clear();
+    raw.clear();
+    storage.clear();
+    numItems = 0;
+    stride = 0;
+}
+
+void SimilaritySearch::reserve(int n)
+{
+    ids.reserve((size_t)n);
+    raw.reserve((size_t)n);
+}
+
+void SimilaritySearch::add(uint64_t id, const FeatureVector& v)
+{
+    ids.push_back(id);
+    raw.push_back(v);
+}
+
+void SimilaritySearch::build()
+{
+    numItems = (int)raw.size();
+
+   #if JUCE_USE_SIMD
+    const int lanes = (int)dsp::SIMDRegister<float>::SIMDNumElements;
+   #else
+    const int lanes = 4;
+   #endif
+    stride = jmax(lanes, (numItems + lanes - 1) / lanes * lanes);
+
+    // z-score each dimension so no single feature dominates the distance
+    for (int d = 0; d < numDimensions; ++d)
+    {
+        double sum = 0.0, sumSq = 0.0;
+        for (auto& v : raw)
+        {
+            sum += v[(size_t)d];
+            sumSq += (double)v[(size_t)d] * v[(size_t)d];
+        }
+
+        const double n = jmax(1, numItems);
+        const double m = sum / n;
+        const double var = jmax(0.0, sumSq / n - m * m);
+        mean[(size_t)d] = (float)m;
+        invStdDev[(size_t)d] = var > 1.0e-12 ? (float)(1.0 / std::sqrt(var)) : 1.0f;
+    }
+
+    storage.assign((size_t)numDimensions * (size_t)stride, padValue);
+    for (int d = 0; d < numDimensions; ++d)
+    {
+        float* col = storage.data() + (size_t)d * (size_t)stride;
+        for (int i = 0; i < numItems; ++i)
+            col[i] = (raw[(size_t)i][(size_t)d] - mean[(size_t)d]) * invStdDev[(size_t)d];
+    }
+}
+
+std::vector<SimilaritySearch::Match> SimilaritySearch::findNearest(const FeatureVector& query, int k) const
+{
+    std::vector<Match> heap; // max-heap on distance holding the best k so far
+    if (numItems == 0 || k <= 0 || storage.empty())
+        return heap;
+
+    k = jmin(k, numItems);
+    heap.reserve((size_t)k + 1);
+
+    FeatureVector q;
+    for (int d = 0; d < numDimensions; ++d)
+        q[(size_t)d] = (query[(size_t)d] - mean[(size_t)d]) * invStdDev[(size_t)d];
+
+    float worst = std::numeric_limits<float>::max();
+    auto consider = [&](int index, float dist)
+    {
+        if (dist >= worst || index >= numItems)
+            return;
+
+        heap.push_back({ ids[(size_t)index], dist });
+        std::push_heap(heap.begin(), heap.end(), closer);
+        if ((int)heap.size() > k)
+        {
+            std::pop_heap(heap.begin(), heap.end(), closer);
+            heap.pop_back();
+        }
+        if ((int)heap.size() == k)
+            worst = heap.front().distance;
+    };
+
+   #if JUCE_USE_SIMD
+    using Reg = dsp::SIMDRegister<float>;
+    constexpr int lanes = (int)Reg::SIMDNumElements;
+
+    if (Reg::isSIMDAligned(storage.data()))
+    {
+        Reg qv[numDimensions], wv[numDimensions];
+        for (int d = 0; d < numDimensions; ++d)
+        {
+            qv[d] = Reg::expand(q[(size_t)d]);
+            wv[d] = Reg::expand(weights[(size_t)d]);
+        }
+
+        alignas(Reg::SIMDRegisterSize) float dist[lanes];
+        for (int i = 0; i < stride; i += lanes)
+        {
+            Reg acc = Reg::expand(0.0f);
+            for (int d = 0; d < numDimensions; ++d)
+            {
+                Reg t = Reg::fromRawArray(column(d) + i) - qv[d];
+                acc += wv[d] * t * t;
+            }
+
+            acc.copyToRawArray(dist);
+            for (int l = 0; l < lanes; ++l)
+                consider(i + l, dist[l]);
+        }
+    }
+    else
+   #endif
+    {
+        for (int i = 0; i < numItems; ++i)
+        {
+            float acc = 0.0f;
+            for (int d = 0; d < numDimensions; ++d)
+            {
+                float t = column(d)[i] - q[(size_t)d];
+                acc += weights[(size_t)d] * t * t;
+            }
+            consider(i, acc);
+        }
+    }
+
+    std::sort_heap(heap.begin(), heap.end(), closer);
+    for (auto& m : heap)
+        m.distance = std::sqrt(m.distance);
+    return heap;
+}
+
+SimilaritySearch SimilaritySearch::fromFeatureIndex(const FeatureIndex& index)
+{
+    SimilaritySearch search;
+    auto records = index.getAllRecords();
+    search.reserve((int)records.size());
+    for (auto& r : records)
+        search.add(r.contentHash, makeVector(r));
+    search.build();
+    return search;
+}
+
+AudioFeatures SimilaritySearch::analyzeBuffer(const AudioBuffer<float>& buffer, double sampleRate, uint64_t id)
+{
+    const int numChannels = buffer.getNumChannels();
+    const int numSamples = buffer.getNumSamples();
+
+    AudioBuffer<float> mono(1, numSamples);
+    mono.clear();
+    for (int ch = 0; ch < numChannels; ++ch)
+        mono.addFrom(0, 0, buffer, ch, 0, numSamples, 1.0f / (float)numChannels);
+
+    ResynthesisAnalyzer analyzer;
+    return FeatureIndex::makeFeatures(id, analyzer.analyze(mono, sampleRate));
+}
+
+std::vector<AudioFeatures> SimilaritySearch::analyzeSeeds(const GeneratorParams& base, int64_t firstSeed, int count, int numThreads)
+{
+    std::vector<AudioFeatures> result((size_t)jmax(0, count));
+
+    ParallelJobs::run(count, numThreads, [&](int i)
+    {
+        GeneratorParams p = base;
+        p.seed = (int64_t)((uint64_t)firstSeed + (uint64_t)i); // wraps: firstSeed may be anything
+        if (p.sampleRate <= 0.0) p.sampleRate = 44100.0;
+
+        Generator808 gen; // not shareable between threads
+        auto buf = gen.renderToBuffer(p);
+        result[(size_t)i] = analyzeBuffer(buf, p.sampleRate, (uint64_t)p.seed);
+    });
+
+    return result;
+}
+
+SimilaritySearch::Results SimilaritySearch::findSimilar(const AudioFeatures& query, const SimilaritySearch& library,
+                                                        const GeneratorParams& seedParams, int numSeeds, int k)
+{
+    Results r;
+
+    double t0 = Time::getMillisecondCounterHiRes();
+    r.samples = library.findNearest(query, k);
+
+    double t1 = Time::getMillisecondCounterHiRes();
+    if (numSeeds > 0)
+    {
+        SimilaritySearch seedBank;
+        seedBank.reserve(numSeeds);
+        const int64_t firstSeed = Random::getSystemRandom().nextInt64();
+        r.seedEngineVersion = Generator808::resolveEngineVersion(seedParams.engineVersion);
+        for (auto& f : analyzeSeeds(seedParams, firstSeed, numSeeds))
+            seedBank.add(f.contentHash, makeVector(f));
+        seedBank.build();
+        r.seeds = seedBank.findNearest(query, k);
+    }
+    double t2 = Time::getMillisecondCounterHiRes();
+
+    r.sampleQueryMs = t1 - t0;
+    r.seedBankMs = t2 - t1;
+    return r;
+}
+
+String SimilaritySearch::Results::describe(const FeatureIndex& index) const
+{
+    String s;
+    if (samples.empty())
+        s << "No indexed library samples (use Index Library first).\n";
+    for (auto& m : samples)
+    {
+        auto f = index.getFileForHash(m.id);
+        s << (f == File() ? String::toHexString((int64)m.id) : f.getFileName()) << "  (" << String(m.distance, 2) << ")\n";
+    }
+
+    if (!seeds.empty())
+    {
+        s << "\nClosest seeds:\n";
+        for (auto& m : seeds)
+            s << Generator808::formatSeed((int64_t)m.id, seedEngineVersion) << "  (" << String(m.distance, 2) << ")\n";
+    }
+
+    s << "\nLibrary query " << String(sampleQueryMs, 2) << " ms, seed bank " << String(seedBankMs, 0) << " ms";
+    return s;
+}
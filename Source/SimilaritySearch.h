@@ -0,0 +1,82 @@
+#pragma once
+#include <JuceHeader.h>
+#include <juce_dsp/juce_dsp.h>
+#include "FeatureIndex.h"
+#include <array>
+
+/*
+ SimilaritySearch
+ - "find 808s like this one": K nearest neighbours over AudioFeatures vectors
+ - Items are either library samples (id = content hash, see fromFeatureIndex) or
+   generator seeds (id = seed, see analyzeSeeds)
+ - Storage is structure-of-arrays, one z-scored column per dimension, padded to the SIMD width;
+   a query is a single flat juce::dsp::SIMDRegister scan with a bounded max-heap for the top K
+ - build() must be called after adding items; queries are const and can run from any thread
+*/
+class SimilaritySearch
+{
+public:
+    static constexpr int numDimensions = 8;
+    using FeatureVector = std::array<float, numDimensions>;
+
+    struct Match
+    {
+        uint64_t id = 0;
+        float distance = 0.0f;
+    };
+
+    // log-scaled pitch, attack, release, centroid, rms, peak, length and crest factor
+    static FeatureVector makeVector(const AudioFeatures& features);
+
+    void clear();
+    void reserve(int numItems);
+    void add(uint64_t id, const FeatureVector& v);
+
+    // normalise columns (z-score per dimension) and pad for the SIMD scan
+    void build();
+
+    int size() const { return numItems; }
+
+    // per-dimension importance, applied on top of the normalisation (pitch counts double by default)
+    void setWeights(const FeatureVector& w) { weights = w; }
+
+    std::vector<Match> findNearest(const FeatureVector& query, int k) const;
+    std::vector<Match> findNearest(const AudioFeatures& query, int k) const { return findNearest(makeVector(query), k); }
+
+    // every record of a feature index, id = content hash
+    static SimilaritySearch fromFeatureIndex(const FeatureIndex& index);
+
+    // render + analyze count seeds starting at firstSeed with otherwise fixed params (contentHash = seed);
+    // seeds past INT64_MAX wrap around to INT64_MIN
+    static std::vector<AudioFeatures> analyzeSeeds(const GeneratorParams& base, int64_t firstSeed, int count, int numThreads = 0);
+
+    // analyze a rendered buffer (any channel count) the same way library files are analyzed
+    static AudioFeatures analyzeBuffer(const juce::AudioBuffer<float>& buffer, double sampleRate, uint64_t id = 0);
+
+    // nearest library samples + nearest of numSeeds freshly analyzed seeds around the given params
+    struct Results
+    {
+        std::vector<Match> samples;
+        std::vector<Match> seeds;
+        int seedEngineVersion = 0;      // the engine the seed bank was rendered with; a seed only sounds the same under it
+        double sampleQueryMs = 0.0;
+        double seedBankMs = 0.0;
+
+        // readable list; library ids are resolved to file names through the index
+        juce::String describe(const FeatureIndex& index) const;
+    };
+
+    static Results findSimilar(const AudioFeatures& query, const SimilaritySearch& library,
+                               const GeneratorParams& seedParams, int numSeeds, int k);
+
+private:
+    const float* column(int d) const { return storage.data() + (size_t)d * (size_t)stride; }
+
+    std::vector<uint64_t> ids;
+    std::vector<FeatureVector> raw;      // un-normalised vectors, kept so build() can be re-run after more adds
+    std::vector<float> storage;          // numDimensions columns of `stride` floats, z-scored
+    int numItems = 0;
+    int stride = 0;
+    FeatureVector mean{}, invStdDev{};
+    FeatureVector weights{ { 2.0f, 1.0f, 1.0f, 1.0f, 1.0f, 0.5f, 1.0f, 0.5f } };
+};
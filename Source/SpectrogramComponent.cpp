@@ -0,0 +1,291 @@
+#include "SpectrogramComponent.h"
+#include "FastMath.h"
+#include <array>
+#include <cmath>
+
+using namespace juce;
+
+namespace
+{
+    constexpr float floorDb = -90.0f;
+
+    // dark -> theme teal -> yellow -> white, as native ARGB pixels
+    const std::array<uint32, 256>& getColourTable()
+    {
+        static const std::array<uint32, 256> table = []()
+        {
+            ColourGradient grad(Colour(0xFF1B1F23), 0.0f, 0.0f, Colour(0xFFFFFFFF), 1.0f, 0.0f, false);
+            grad.addColour(0.35, Colour(0xFF1E4D6B));
+            grad.addColour(0.6, Colour(0xFF4DB6A9));
+            grad.addColour(0.85, Colour(0xFFE8D44D));
+
+            std::array<uint32, 256> t{};
+            for (int i = 0; i < 256; ++i)
+                t[(size_t)i] = grad.getColourAtPosition(i / 255.0).getPixelARGB().getNativeARGB();
+            return t;
+        }();
+        return table;
+    }
+
+    float rowToHz(float row, float lowHz, float highHz)
+    {
+        return lowHz * std::pow(highHz / lowHz, row / (float)SpectrogramComponent::numRows);
+    }
+}
+
+SpectrogramComponent::SpectrogramComponent()
+    : generation(std::make_shared<std::atomic<uint32_t>>(0))
+{
+    setOpaque(true);
+}
+
+SpectrogramComponent::~SpectrogramComponent()
+{
+    // a running worker sees the new generation and stops at its next frame
+    ++(*generation);
+}
+
+void SpectrogramComponent::setBuffer(std::shared_ptr<const AudioBuffer<float>> buffer, double sampleRate)
+{
+    source = std::move(buffer);
+    sourceSampleRate = sampleRate > 0.0 ? sampleRate : 44100.0;
+    restart();
+}
+
+void SpectrogramComponent::setBuffer(const AudioBuffer<float>& buffer, double sampleRate)
+{
+    auto copy = std::make_shared<AudioBuffer<float>>();
+    copy->makeCopyOf(buffer);
+    setBuffer(std::shared_ptr<const AudioBuffer<float>>(std::move(copy)), sampleRate);
+}
+
+void SpectrogramComponent::clear()
+{
+    source.reset();
+    restart();
+}
+
+void SpectrogramComponent::setFrequencyRange(float newLowHz, float newHighHz)
+{
+    lowHz = jmax(1.0f, newLowHz);
+    highHz = jmax(lowHz * 2.0f, newHighHz);
+    restart();
+}
+
+void SpectrogramComponent::restart()
+{
+    const uint32_t myGeneration = ++(*generation);
+    tiles.reset();
+    viewStart = 0.0;
+    viewFrames = 0.0;
+    computing = source != nullptr && source->getNumSamples() > 0;
+    repaint();
+
+    if (!computing)
+        return;
+
+    Component::SafePointer<SpectrogramComponent> safeThis(this);
+    Thread::launch([safeThis, buffer = source, sr = sourceSampleRate, lo = lowHz, hi = highHz,
+                    gen = generation, myGeneration]()
+    {
+        auto result = computeTiles(*buffer, sr, lo, hi, *gen, myGeneration);
+        if (result == nullptr)
+            return; // superseded
+
+        MessageManager::callAsync([safeThis, result, gen, myGeneration]()
+        {
+            if (safeThis == nullptr || gen->load() != myGeneration)
+                return;
+
+            safeThis->tiles = result;
+            safeThis->computing = false;
+            safeThis->repaint();
+        });
+    });
+}
+
+std::shared_ptr<const SpectrogramComponent::Tiles> SpectrogramComponent::computeTiles(const AudioBuffer<float>& buffer, double sampleRate,
+                                                                                      float lowHz, float highHz,
+                                                                                      const std::atomic<uint32_t>& generation, uint32_t myGeneration)
+{
+    const int fftSize = 1 << fftOrder;
+    const int numSamples = buffer.getNumSamples();
+    const int numChannels = buffer.getNumChannels();
+    const int hop = jmax(minHopSize, (numSamples + maxFrames - 1) / maxFrames);
+    const int numFrames = jmax(1, (numSamples + hop - 1) / hop);
+
+    auto result = std::make_shared<Tiles>();
+    result->numFrames = numFrames;
+    result->secondsPerFrame = (double)hop / sampleRate;
+    result->lowHz = lowHz;
+    result->highHz = highHz;
+
+    // each display row covers a log-spaced bin range; narrow low rows still read at least one bin
+    const double binHz = sampleRate / (double)fftSize;
+    std::vector<int> rowFirstBin(numRows), rowLastBin(numRows);
+    for (int r = 0; r < numRows; ++r)
+    {
+        const int b0 = (int)std::floor(rowToHz((float)r, lowHz, highHz) / binHz);
+        const int b1 = (int)std::ceil(rowToHz((float)(r + 1), lowHz, highHz) / binHz);
+        rowFirstBin[(size_t)r] = jlimit(0, fftSize / 2, b0);
+        rowLastBin[(size_t)r] = jlimit(rowFirstBin[(size_t)r], fftSize / 2, b1 - 1);
+    }
+
+    dsp::FFT fft(fftOrder);
+    dsp::WindowingFunction<float> window((size_t)fftSize, dsp::WindowingFunction<float>::hann, false);
+    std::vector<float> fftData((size_t)fftSize * 2);
+    std::vector<float> rowLevel(numRows);
+    const auto& colours = getColourTable();
+
+    // magnitude -> 0..255: dB over [floorDb, 0], full-scale sine at 0 dB (hann coherent gain 0.5)
+    const float magnitudeScale = 4.0f / (float)fftSize;
+    const float dbToLevel = 255.0f / -floorDb;
+    const float log10Of2 = std::log10(2.0f);
+
+    const int numTiles = (numFrames + tileWidth - 1) / tileWidth;
+    for (int t = 0; t < numTiles; ++t)
+    {
+        const int firstFrame = t * tileWidth;
+        const int width = jmin(tileWidth, numFrames - firstFrame);
+
+        Image tile(Image::ARGB, width, numRows, false, SoftwareImageType());
+        Image::BitmapData pixels(tile, Image::BitmapData::writeOnly);
+
+        for (int x = 0; x < width; ++x)
+        {
+            if (generation.load() != myGeneration)
+                return nullptr;
+
+            // frames are centred on frame * hop
+            const int centre = (firstFrame + x) * hop;
+            const int start = centre - fftSize / 2;
+
+            FloatVectorOperations::clear(fftData.data(), fftSize * 2);
+            const int from = jmax(0, start);
+            const int to = jmin(numSamples, start + fftSize);
+            if (to > from)
+            {
+                for (int ch = 0; ch < numChannels; ++ch)
+                    FloatVectorOperations::add(fftData.data() + (from - start), buffer.getReadPointer(ch, from), to - from);
+                if (numChannels > 1)
+                    FloatVectorOperations::multiply(fftData.data(), 1.0f / (float)numChannels, fftSize);
+            }
+
+            window.multiplyWithWindowingTable(fftData.data(), (size_t)fftSize);
+            fft.performFrequencyOnlyForwardTransform(fftData.data(), true);
+
+            // peak bin per row, then scale + dB + clamp into table indices
+            for (int r = 0; r < numRows; ++r)
+                rowLevel[(size_t)r] = FloatVectorOperations::findMaximum(fftData.data() + rowFirstBin[(size_t)r],
+                                                                         rowLastBin[(size_t)r] - rowFirstBin[(size_t)r] + 1);
+
+            FloatVectorOperations::multiply(rowLevel.data(), magnitudeScale, numRows);
+            FloatVectorOperations::clip(rowLevel.data(), rowLevel.data(), 1.0e-9f, 1.0e9f, numRows);
+            // draft log2 is off by < 1e-3 dB, far below one colour step
+            FastMath::log2(rowLevel.data(), rowLevel.data(), numRows, FastMath::draftAccuracy);
+            FloatVectorOperations::multiply(rowLevel.data(), 20.0f * log10Of2 * dbToLevel, numRows);
+            FloatVectorOperations::add(rowLevel.data(), 255.0f, numRows);
+            FloatVectorOperations::clip(rowLevel.data(), rowLevel.data(), 0.0f, 255.0f, numRows);
+
+            // row 0 is the lowest frequency, drawn at the bottom
+            for (int r = 0; r < numRows; ++r)
+                *reinterpret_cast<uint32*>(pixels.getPixelPointer(x, numRows - 1 - r)) = colours[(size_t)rowLevel[(size_t)r]];
+        }
+
+        result->images.push_back(tile);
+    }
+
+    return result;
+}
+
+void SpectrogramComponent::paint(Graphics& g)
+{
+    g.fillAll(Colour(0xFF1B1F23));
+    auto bounds = getLocalBounds();
+
+    if (tiles == nullptr)
+    {
+        if (computing)
+        {
+            g.setColour(Colour(0xFF9AA0A6));
+            g.drawText("Computing spectrogram...", bounds, Justification::centred);
+        }
+        return;
+    }
+
+    const double total = (double)tiles->numFrames;
+    const double visible = viewFrames > 0.0 ? viewFrames : total;
+    const double pixelsPerFrame = (double)bounds.getWidth() / visible;
+
+    // just rescale whichever cached tiles overlap the view
+    for (int t = 0; t < (int)tiles->images.size(); ++t)
+    {
+        const double tileStart = (double)t * tileWidth;
+        const auto& img = tiles->images[(size_t)t];
+        if (tileStart + img.getWidth() < viewStart || tileStart > viewStart + visible)
+            continue;
+
+        const float x = (float)((tileStart - viewStart) * pixelsPerFrame);
+        const float w = (float)(img.getWidth() * pixelsPerFrame);
+        g.drawImage(img, Rectangle<float>(x, (float)bounds.getY(), w, (float)bounds.getHeight()));
+    }
+
+    // frequency guides where 808 fundamentals and their first harmonics live
+    g.setFont(11.0f);
+    for (float hz : { 50.0f, 100.0f, 200.0f, 500.0f, 1000.0f })
+    {
+        if (hz <= tiles->lowHz || hz >= tiles->highHz)
+            continue;
+
+        const float frac = std::log(hz / tiles->lowHz) / std::log(tiles->highHz / tiles->lowHz);
+        const float y = (float)bounds.getBottom() - frac * (float)bounds.getHeight();
+        g.setColour(Colours::white.withAlpha(0.15f));
+        g.drawHorizontalLine(roundToInt(y), (float)bounds.getX(), (float)bounds.getRight());
+        g.setColour(Colours::white.withAlpha(0.5f));
+        g.drawText(hz >= 1000.0f ? String(hz / 1000.0f, 0) + "k" : String((int)hz), bounds.getX() + 4, roundToInt(y) - 13, 40, 12,
+                   Justification::left);
+    }
+}
+
+void SpectrogramComponent::setView(double newStartFrame, double newNumFrames)
+{
+    if (tiles == nullptr)
+        return;
+
+    const double total = (double)tiles->numFrames;
+    viewFrames = jlimit(jmin(total, 16.0), total, newNumFrames);
+    viewStart = jlimit(0.0, total - viewFrames, newStartFrame);
+    repaint();
+}
+
+void SpectrogramComponent::mouseDown(const MouseEvent&)
+{
+    dragStartView = viewStart;
+}
+
+void SpectrogramComponent::mouseDrag(const MouseEvent& e)
+{
+    if (tiles == nullptr || getWidth() <= 0)
+        return;
+
+    const double visible = viewFrames > 0.0 ? viewFrames : (double)tiles->numFrames;
+    setView(dragStartView - e.getDistanceFromDragStartX() * visible / getWidth(), visible);
+}
+
+void SpectrogramComponent::mouseDoubleClick(const MouseEvent&)
+{
+    if (tiles != nullptr)
+        setView(0.0, (double)tiles->numFrames);
+}
+
+void SpectrogramComponent::mouseWheelMove(const MouseEvent& e, const MouseWheelDetails& wheel)
+{
+    if (tiles == nullptr || getWidth() <= 0)
+        return;
+
+    // zoom around the frame under the mouse
+    const double visible = viewFrames > 0.0 ? viewFrames : (double)tiles->numFrames;
+    const double anchor = viewStart + visible * e.x / getWidth();
+    const double newVisible = visible * std::pow(0.8, wheel.deltaY * 4.0);
+    setView(anchor - newVisible * e.x / getWidth(), newVisible);
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <JuceHeader.h>
+#include <juce_dsp/juce_dsp.h>
+#include <atomic>
+#include <vector>
+
+/*
+ SpectrogramComponent
+ - Log-frequency spectrogram (20 Hz .. 5 kHz by default, so the sub region gets most of the height)
+ - setBuffer() starts the STFT on a worker thread; the result is a row of image tiles, tileWidth
+   frames each, at one pixel per frame and one pixel per frequency row
+ - Painting only scales the visible tiles into place, so zoom (mouse wheel) and pan (drag) never
+   recompute anything; double-click shows the whole buffer again
+ - Tiles are thrown away only when a new buffer is set
+*/
+class SpectrogramComponent : public juce::Component
+{
+public:
+    static constexpr int fftOrder = 12;      // 4096 points: ~11 Hz bins at 44.1 kHz, enough to split sub partials
+    static constexpr int minHopSize = 512;
+    static constexpr int maxFrames = 16384;  // long files get a larger hop instead of more tiles
+    static constexpr int numRows = 256;
+    static constexpr int tileWidth = 256;
+
+    SpectrogramComponent();
+    ~SpectrogramComponent() override;
+
+    // the buffer is shared with the worker, so it must not be modified afterwards
+    void setBuffer(std::shared_ptr<const juce::AudioBuffer<float>> buffer, double sampleRate);
+    void setBuffer(const juce::AudioBuffer<float>& buffer, double sampleRate); // copies
+    void clear();
+
+    void setFrequencyRange(float lowHz, float highHz);
+
+    void paint(juce::Graphics& g) override;
+    void mouseDown(const juce::MouseEvent& e) override;
+    void mouseDrag(const juce::MouseEvent& e) override;
+    void mouseDoubleClick(const juce::MouseEvent& e) override;
+    void mouseWheelMove(const juce::MouseEvent& e, const juce::MouseWheelDetails& wheel) override;
+
+private:
+    struct Tiles
+    {
+        std::vector<juce::Image> images;
+        int numFrames = 0;
+        double secondsPerFrame = 0.0;
+        float lowHz = 20.0f, highHz = 5000.0f;
+    };
+
+    static std::shared_ptr<const Tiles> computeTiles(const juce::AudioBuffer<float>& buffer, double sampleRate,
+                                                     float lowHz, float highHz,
+                                                     const std::atomic<uint32_t>& generation, uint32_t myGeneration);
+    void restart();
+    void setView(double newStartFrame, double newNumFrames);
+
+    std::shared_ptr<const juce::AudioBuffer<float>> source;
+    double sourceSampleRate = 44100.0;
+    float lowHz = 20.0f, highHz = 5000.0f;
+
+    // bumped for every new buffer; workers compare against it and give up when stale
+    std::shared_ptr<std::atomic<uint32_t>> generation;
+    std::shared_ptr<const Tiles> tiles;
+    bool computing = false;
+
+    double viewStart = 0.0;   // in frames
+    double viewFrames = 0.0;  // 0 = everything
+    double dragStartView = 0.0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpectrogramComponent)
+};
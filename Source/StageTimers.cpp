@@ -0,0 +1,279 @@
+#include "StageTimers.h"
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using namespace juce;
+
+namespace
+{
+    // written only by its own thread (relaxed load + store, no read-modify-write); read by getStats
+    struct StageCounters
+    {
+        std::atomic<int64> count{ 0 }, totalTicks{ 0 }, minTicks{ 0 }, maxTicks{ 0 };
+        std::array<std::atomic<int64>, StageTimers::Stats::numBuckets> histogram {};
+
+        static void add(std::atomic<int64>& a, int64 n) noexcept { a.store(a.load(std::memory_order_relaxed) + n, std::memory_order_relaxed); }
+    };
+
+    struct TraceEvent
+    {
+        StageTimers::Stage stage;
+        int64 startTicks, durationTicks;
+    };
+
+    struct ThreadTimers
+    {
+        int index = 0;
+        std::array<StageCounters, StageTimers::numStages> stages;
+
+        SpinLock traceLock;                 // the owner appends, writeChromeTrace and reset read / clear
+        std::vector<TraceEvent> events;
+    };
+
+    struct Registry
+    {
+        std::mutex lock;
+        std::vector<std::shared_ptr<ThreadTimers>> threads;     // kept after their thread ends
+
+        std::atomic<bool> tracing{ false };
+        std::atomic<int> maxEventsPerThread{ 1 << 20 };
+        const int64 epochTicks = Time::getHighResolutionTicks();
+        const double nsPerTick = 1.0e9 / (double)Time::getHighResolutionTicksPerSecond();
+    };
+
+    Registry& getRegistry()
+    {
+        static Registry registry;
+        return registry;
+    }
+
+    // allocates once per thread, the first time it times something
+    ThreadTimers& getThreadTimers()
+    {
+        thread_local std::shared_ptr<ThreadTimers> mine;
+        if (mine == nullptr)
+        {
+            auto& registry = getRegistry();
+            mine = std::make_shared<ThreadTimers>();
+            const std::lock_guard<std::mutex> guard(registry.lock);
+            mine->index = (int)registry.threads.size();
+            registry.threads.push_back(mine);
+        }
+        return *mine;
+    }
+
+    int bucketOf(double ns) noexcept
+    {
+        int b = 0;
+        while (b < StageTimers::Stats::numBuckets - 1 && ns >= (double)((int64)2 << b))
+            ++b;
+        return b;
+    }
+}
+
+const char* StageTimers::getName(Stage stage) noexcept
+{
+    switch (stage)
+    {
+        case Stage::render:     return "render";
+        case Stage::draft:      return "draft";
+        case Stage::oscillator: return "oscillator";
+        case Stage::filter:     return "filter";
+        case Stage::width:      return "width";
+        case Stage::output:     return "gain + clip";
+        case Stage::trim:       return "trim";
+        case Stage::batch:      return "batch";
+        case Stage::exportWav:  return "export";
+        case Stage::numStages:  break;
+    }
+    return "?";
+}
+
+double StageTimers::Stats::getPercentileUs(double fraction) const noexcept
+{
+    if (count <= 0)
+        return 0.0;
+
+    const auto rank = (int64)std::ceil(jlimit(0.0, 1.0, fraction) * (double)count);
+    int64 seen = 0;
+    for (int b = 0; b < numBuckets; ++b)
+    {
+        seen += histogram[(size_t)b];
+        if (seen >= jmax((int64)1, rank))
+            return jmin(maxUs, (double)((int64)2 << b) * 1.0e-3);
+    }
+    return maxUs;
+}
+
+void StageTimers::setEnabled(bool shouldBeEnabled) noexcept
+{
+    // the trace's epoch is taken when the registry is created: before any scope can read its start
+    if (shouldBeEnabled)
+        getRegistry();
+    enabled.store(shouldBeEnabled, std::memory_order_relaxed);
+}
+
+void StageTimers::setTracing(bool shouldTrace, int maxEventsPerThread) noexcept
+{
+    auto& registry = getRegistry();
+    registry.maxEventsPerThread.store(jmax(0, maxEventsPerThread));
+    registry.tracing.store(shouldTrace);
+    if (shouldTrace)
+        setEnabled(true);
+}
+
+void StageTimers::record(Stage stage, int64 startTicks, int64 endTicks) noexcept
+{
+    auto& registry = getRegistry();
+    auto& timers = getThreadTimers();
+    auto& c = timers.stages[(size_t)stage];
+    const int64 ticks = endTicks - startTicks;
+
+    const bool first = c.count.load(std::memory_order_relaxed) == 0;
+    StageCounters::add(c.count, 1);
+    StageCounters::add(c.totalTicks, ticks);
+    if (first || ticks < c.minTicks.load(std::memory_order_relaxed))
+        c.minTicks.store(ticks, std::memory_order_relaxed);
+    if (ticks > c.maxTicks.load(std::memory_order_relaxed))
+        c.maxTicks.store(ticks, std::memory_order_relaxed);
+    StageCounters::add(c.histogram[(size_t)bucketOf((double)ticks * registry.nsPerTick)], 1);
+
+    if (registry.tracing.load(std::memory_order_relaxed))
+    {
+        const SpinLock::ScopedLockType lock(timers.traceLock);
+        if ((int)timers.events.size() < registry.maxEventsPerThread.load(std::memory_order_relaxed))
+            timers.events.push_back({ stage, startTicks, ticks });
+    }
+}
+
+std::array<StageTimers::Stats, StageTimers::numStages> StageTimers::getStats()
+{
+    auto& registry = getRegistry();
+    const double usPerTick = registry.nsPerTick * 1.0e-3;
+    std::array<Stats, numStages> stats;
+
+    const std::lock_guard<std::mutex> guard(registry.lock);
+    for (auto& timers : registry.threads)
+    {
+        for (int s = 0; s < numStages; ++s)
+        {
+            const auto& c = timers->stages[(size_t)s];
+            auto& out = stats[(size_t)s];
+            const auto n = c.count.load(std::memory_order_relaxed);
+            if (n == 0)
+                continue;
+
+            const double minUs = (double)c.minTicks.load(std::memory_order_relaxed) * usPerTick;
+            out.minUs = out.count == 0 ? minUs : jmin(out.minUs, minUs);
+            out.maxUs = jmax(out.maxUs, (double)c.maxTicks.load(std::memory_order_relaxed) * usPerTick);
+            out.count += n;
+            out.totalUs += (double)c.totalTicks.load(std::memory_order_relaxed) * usPerTick;
+            for (int b = 0; b < Stats::numBuckets; ++b)
+                out.histogram[(size_t)b] += c.histogram[(size_t)b].load(std::memory_order_relaxed);
+        }
+    }
+
+    return stats;
+}
+
+void StageTimers::reset()
+{
+    auto& registry = getRegistry();
+    const std::lock_guard<std::mutex> guard(registry.lock);
+    for (auto& timers : registry.threads)
+    {
+        for (auto& c : timers->stages)
+        {
+            c.count.store(0);
+            c.totalTicks.store(0);
+            c.minTicks.store(0);
+            c.maxTicks.store(0);
+            for (auto& b : c.histogram)
+                b.store(0);
+        }
+
+        const SpinLock::ScopedLockType lock(timers->traceLock);
+        timers->events.clear();
+    }
+}
+
+String StageTimers::formatStats()
+{
+    if (!isCompiledIn())
+        return "Stage timers are compiled out of this build (set ORADE808_STAGE_TIMERS=1)";
+
+    String text;
+    text << String("stage").paddedRight(' ', 12) << String("count").paddedLeft(' ', 10) << String("total ms").paddedLeft(' ', 12)
+         << String("mean us").paddedLeft(' ', 10) << String("p50 us").paddedLeft(' ', 10) << String("p99 us").paddedLeft(' ', 10)
+         << String("max us").paddedLeft(' ', 10) << "\n";
+
+    const auto stats = getStats();
+    for (int s = 0; s < numStages; ++s)
+    {
+        const auto& st = stats[(size_t)s];
+        if (st.count == 0)
+            continue;
+
+        text << String(getName((Stage)s)).paddedRight(' ', 12) << String(st.count).paddedLeft(' ', 10)
+             << String(st.totalUs * 1.0e-3, 2).paddedLeft(' ', 12) << String(st.getMeanUs(), 2).paddedLeft(' ', 10)
+             << String(st.getPercentileUs(0.5), 2).paddedLeft(' ', 10) << String(st.getPercentileUs(0.99), 2).paddedLeft(' ', 10)
+             << String(st.maxUs, 2).paddedLeft(' ', 10) << "\n";
+    }
+
+    return text.trimEnd();
+}
+
+bool StageTimers::writeChromeTrace(const File& file, String& error)
+{
+    auto& registry = getRegistry();
+    const double usPerTick = registry.nsPerTick * 1.0e-3;
+
+    TemporaryFile temp(file);
+    {
+        FileOutputStream out(temp.getFile());
+        if (!out.openedOk())
+        {
+            error = "Could not write " + file.getFullPathName();
+            return false;
+        }
+
+        // complete ("X") events, timestamps in microseconds from the first use of the timers
+        out << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n";
+        bool firstEvent = true;
+        auto writeEvent = [&](const String& json)
+        {
+            out << (firstEvent ? "  " : ",\n  ") << json;
+            firstEvent = false;
+        };
+
+        const std::lock_guard<std::mutex> guard(registry.lock);
+        for (auto& timers : registry.threads)
+        {
+            const String tid(timers->index + 1);
+            writeEvent("{\"ph\": \"M\", \"name\": \"thread_name\", \"pid\": 1, \"tid\": " + tid
+                       + ", \"args\": {\"name\": \"render thread " + tid + "\"}}");
+
+            const SpinLock::ScopedLockType lock(timers->traceLock);
+            for (const auto& e : timers->events)
+                writeEvent("{\"ph\": \"X\", \"cat\": \"render\", \"name\": \"" + String(getName(e.stage)) + "\", \"pid\": 1, \"tid\": " + tid
+                           + ", \"ts\": " + String((double)jmax((int64)0, e.startTicks - registry.epochTicks) * usPerTick, 3)
+                           + ", \"dur\": " + String((double)e.durationTicks * usPerTick, 3) + "}");
+        }
+
+        out << "\n]}\n";
+        out.flush();
+        if (out.getStatus().failed())
+        {
+            error = "Could not write " + file.getFullPathName() + ": " + out.getStatus().getErrorMessage();
+            return false;
+        }
+    }
+
+    if (!temp.overwriteTargetFileWithTemporary())
+    {
+        error = "Could not replace " + file.getFullPathName();
+        return false;
+    }
+    return true;
+}
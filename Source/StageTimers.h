@@ -0,0 +1,119 @@
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+
+/*
+ StageTimers
+ - Scoped timers on the render hot path, so a slow render can be pinned on a stage: the oscillator,
+   the filter / saturation, the stereo width and the gain / soft clip of each block renderStages
+   runs (and the matching stage functions StagedGenerator calls), the auto-length trim, whole
+   renders and drafts, SIMD batches and WAV export
+ - Compiled in only when ORADE808_STAGE_TIMERS is 1, which is the default in debug builds. Add
+   ORADE808_STAGE_TIMERS=1 to the Projucer's preprocessor definitions to have them in a release
+   build. Compiled out, STAGE_TIMER expands to nothing
+ - Compiled in, they still do nothing until setEnabled(true): one relaxed atomic load per scope
+ - Each thread adds into counters of its own (count, total, min, max and a log2 histogram of
+   durations), so render threads don't contend; getStats sums them over every thread so far
+ - With tracing on, each timed scope is also kept as an event (up to maxEventsPerThread per thread)
+   for writeChromeTrace: a Trace Event Format file for chrome://tracing or ui.perfetto.dev
+ - --stats on the render commands prints the table, --trace=<file.json> writes the timeline
+*/
+#ifndef ORADE808_STAGE_TIMERS
+ #if JUCE_DEBUG
+  #define ORADE808_STAGE_TIMERS 1
+ #else
+  #define ORADE808_STAGE_TIMERS 0
+ #endif
+#endif
+
+class StageTimers
+{
+public:
+    enum class Stage
+    {
+        render,         // Generator808::render, whole
+        draft,          // Generator808::renderDraft, whole
+        oscillator,
+        filter,         // lowpass, shelf and saturation
+        width,          // copy to the output layout + stereo width
+        output,         // master gain + soft clip
+        trim,           // auto length: finding the tail and fading it out
+        batch,          // BatchGenerator808::render, whole
+        exportWav,      // WavExporter::saveBufferToWav
+        numStages
+    };
+
+    static constexpr int numStages = (int)Stage::numStages;
+    static const char* getName(Stage stage) noexcept;
+
+    struct Stats
+    {
+        // bucket b counts the scopes that took [2^b, 2^(b+1)) ns; the first and last are open-ended
+        static constexpr int numBuckets = 40;
+
+        juce::int64 count = 0;
+        double totalUs = 0.0, minUs = 0.0, maxUs = 0.0;
+        std::array<juce::int64, numBuckets> histogram {};
+
+        double getMeanUs() const noexcept { return count > 0 ? totalUs / (double)count : 0.0; }
+
+        // upper bound of the bucket the fraction-th scope falls in, so within a factor of 2
+        double getPercentileUs(double fraction) const noexcept;
+    };
+
+    static constexpr bool isCompiledIn() noexcept { return ORADE808_STAGE_TIMERS != 0; }
+
+    // process-wide; scopes started before setEnabled(true) aren't counted
+    static void setEnabled(bool shouldBeEnabled) noexcept;
+    static bool isEnabled() noexcept { return enabled.load(std::memory_order_relaxed); }
+
+    // also keep every timed scope for writeChromeTrace; turns the timers on
+    static void setTracing(bool shouldTrace, int maxEventsPerThread = 1 << 20) noexcept;
+
+    // summed over every thread that has timed anything
+    static std::array<Stats, numStages> getStats();
+
+    // forget the counts and the trace events; call while nothing is being timed
+    static void reset();
+
+    // one line per stage that ran: count, total, mean, p50 / p99 (from the histogram) and max
+    static juce::String formatStats();
+
+    // the events kept since tracing started (or the last reset), one timeline row per thread.
+    // False with error set if the file can't be written
+    static bool writeChromeTrace(const juce::File& file, juce::String& error);
+
+    // times its lifetime as one run of stage, if the timers are enabled
+    class Scope
+    {
+    public:
+        explicit Scope(Stage s) noexcept
+            : stage(s), startTicks(isEnabled() ? juce::Time::getHighResolutionTicks() : -1)
+        {
+        }
+
+        ~Scope() noexcept
+        {
+            if (startTicks >= 0)
+                record(stage, startTicks, juce::Time::getHighResolutionTicks());
+        }
+
+    private:
+        const Stage stage;
+        const juce::int64 startTicks;
+
+        JUCE_DECLARE_NON_COPYABLE(Scope)
+    };
+
+private:
+    static void record(Stage stage, juce::int64 startTicks, juce::int64 endTicks) noexcept;
+
+    static inline std::atomic<bool> enabled { false };
+};
+
+#if ORADE808_STAGE_TIMERS
+ #define STAGE_TIMER(stageName) const StageTimers::Scope JUCE_JOIN_MACRO(stageTimer_, __LINE__)(StageTimers::Stage::stageName)
+#else
+ #define STAGE_TIMER(stageName)
+#endif
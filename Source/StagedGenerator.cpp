@@ -0,0 +1,158 @@
+#include "StagedGenerator.h"
+#include <cstring>
+
+using namespace juce;
+
+namespace
+{
+    uint64_t bitsOf(double v)
+    {
+        uint64_t bits;
+        std::memcpy(&bits, &v, sizeof(bits));
+        return bits;
+    }
+}
+
+StagedGenerator::StagedGenerator(int numEntriesPerStage)
+    : entriesPerStage(jmax(1, numEntriesPerStage))
+{
+}
+
+const char* StagedGenerator::getStageName(Stage s)
+{
+    switch (s)
+    {
+        case oscillatorStage: return "oscillator";
+        case filterStage:     return "filter";
+        case widthStage:      return "width";
+        case outputStage:     return "output";
+        default:              return "?";
+    }
+}
+
+StagedGenerator::Key StagedGenerator::makeStageKey(Stage s, const GeneratorParams& p)
+{
+    // keep in step with what the matching Generator808 stage actually reads
+    switch (s)
+    {
+        case oscillatorStage:
+            return { (uint64_t)p.seed, bitsOf(p.sampleRate), bitsOf(p.lengthSeconds), bitsOf(p.tuneSemitones),
+                     bitsOf(p.subAmount), bitsOf(p.boomAmount), bitsOf(p.shortness), bitsOf(p.punch),
+                     bitsOf(p.growl), bitsOf(p.analog), (uint64_t)Generator808::resolveEngineVersion(p.engineVersion) };
+        case filterStage:
+            return { bitsOf(p.sampleRate), bitsOf(p.boomAmount), bitsOf(p.analog), (uint64_t)p.oversampling };
+        case widthStage:
+            return { bitsOf(p.sampleRate), bitsOf(p.detune) };
+        case outputStage:
+            return { bitsOf(p.masterGainDb), (uint64_t)p.oversampling };
+        default:
+            return {};
+    }
+}
+
+void StagedGenerator::clear()
+{
+    for (auto& entries : cache)
+        entries.clear();
+}
+
+AudioBuffer<float> StagedGenerator::renderToBuffer(const GeneratorParams& params)
+{
+    ChainKeys keys;
+    for (int s = 0; s < (int)keys.size(); ++s)
+    {
+        keys[(size_t)s] = s > 0 ? keys[(size_t)s - 1] : Key();
+        auto own = makeStageKey((Stage)s, params);
+        keys[(size_t)s].insert(keys[(size_t)s].end(), own.begin(), own.end());
+    }
+
+    AudioBuffer<float> out;
+    out.makeCopyOf(getStage(widthStage, params, keys));
+
+    generator.renderOutputStage(params, out);
+    Generator808::trimToTail(params, out);
+    ++stats.misses[outputStage];
+    return out;
+}
+
+const AudioBuffer<float>& StagedGenerator::getStage(Stage s, const GeneratorParams& params, const ChainKeys& keys)
+{
+    const auto& key = keys[(size_t)s];
+    for (auto& e : cache[(size_t)s])
+    {
+        if (e.key == key)
+        {
+            e.lastUse = ++useCounter;
+            ++stats.hits[s];
+            return e.buffer;
+        }
+    }
+
+    ++stats.misses[s];
+
+    // upstream first: it lives in another stage's list, so inserting here can't move it
+    if (s == oscillatorStage)
+    {
+        auto& e = insert(s, key);
+        const int numSamples = (int)std::lround(params.lengthSeconds * params.sampleRate);
+        e.buffer.setSize(1, numSamples, false, false, true);
+        generator.renderOscillatorStage(params, e.buffer);
+        return e.buffer;
+    }
+
+    const auto& input = getStage((Stage)(s - 1), params, keys);
+    auto& e = insert(s, key);
+
+    if (s == filterStage)
+    {
+        e.buffer.makeCopyOf(input, true);
+        generator.renderFilterStage(params, e.buffer);
+    }
+    else
+    {
+        generator.renderWidthStage(params, input, e.buffer);
+    }
+
+    return e.buffer;
+}
+
+StagedGenerator::Entry& StagedGenerator::insert(Stage s, const Key& key)
+{
+    auto& entries = cache[(size_t)s];
+
+    Entry* slot = nullptr;
+    if ((int)entries.size() < entriesPerStage)
+    {
+        entries.emplace_back();
+        slot = &entries.back();
+    }
+    else
+    {
+        // reuse the least recently used entry (and its allocation)
+        slot = &entries.front();
+        for (auto& e : entries)
+            if (e.lastUse < slot->lastUse)
+                slot = &e;
+    }
+
+    slot->key = key;
+    slot->lastUse = ++useCounter;
+    return *slot;
+}
+
+double StagedGenerator::Stats::getHitRate(Stage s) const
+{
+    const auto total = hits[s] + misses[s];
+    return total > 0 ? (double)hits[s] / (double)total : 0.0;
+}
+
+String StagedGenerator::Stats::toString() const
+{
+    String s;
+    for (int i = 0; i < outputStage; ++i)
+        s << getStageName((Stage)i) << ": " << hits[i] << " hits / " << (hits[i] + misses[i]) << " ("
+          << String(getHitRate((Stage)i) * 100.0, 1) << "%)\n";
+
+    s << getStageName(outputStage) << ": " << misses[outputStage] << " runs";
+    return s;
+}
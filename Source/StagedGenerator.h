@@ -0,0 +1,71 @@
+#pragma once
+#include <JuceHeader.h>
+#include "808Generator.h"
+#include <array>
+#include <vector>
+
+/*
+ StagedGenerator
+ - Generator808::renderToBuffer with memoized intermediate stages, for parameter sweeps
+ - Stages and the GeneratorParams fields each one reads (see makeStageKey):
+     oscillator  seed, sampleRate, lengthSeconds, tuneSemitones, subAmount, boomAmount, shortness, punch, growl, analog,
+                 engineVersion
+     filter      sampleRate, boomAmount, analog, oversampling        (lowpass, shelf, saturation)
+     width       sampleRate, detune                                  (copy out + width; mono stays one channel)
+     output      masterGainDb, oversampling                          (gain + soft clip, always run)
+ - A stage result is reused when its own fields and every upstream stage's fields are unchanged,
+   so sweeping masterGainDb or detune only re-runs the tail of the chain
+ - Output is bit-identical to Generator808::renderToBuffer. autoLength renders are trimmed after the
+   output stage, so the cached stages are always full length and the saving is disk/memory, not CPU
+ - Each cached stage keeps the last entriesPerStage results (LRU). Not thread-safe: one per thread.
+*/
+class StagedGenerator
+{
+public:
+    enum Stage { oscillatorStage, filterStage, widthStage, outputStage, numStages };
+
+    explicit StagedGenerator(int entriesPerStage = 4);
+
+    juce::AudioBuffer<float> renderToBuffer(const GeneratorParams& params);
+
+    struct Stats
+    {
+        juce::int64 hits[numStages] = {};
+        juce::int64 misses[numStages] = {};
+
+        double getHitRate(Stage s) const;
+        juce::String toString() const;
+    };
+
+    const Stats& getStats() const noexcept { return stats; }
+    void resetStats() { stats = {}; }
+    void clear();
+
+    static const char* getStageName(Stage s);
+
+    // the values of the params fields a stage depends on (bit patterns, so comparison is exact)
+    using Key = std::vector<uint64_t>;
+    static Key makeStageKey(Stage s, const GeneratorParams& params);
+
+private:
+    struct Entry
+    {
+        Key key;                        // this stage's key appended to all upstream keys
+        juce::AudioBuffer<float> buffer;
+        juce::uint64 lastUse = 0;
+    };
+
+    using ChainKeys = std::array<Key, 3>; // cumulative keys of the cached stages
+
+    // cached result for stage s, rendering it (and whatever upstream is missing) if needed
+    const juce::AudioBuffer<float>& getStage(Stage s, const GeneratorParams& params, const ChainKeys& keys);
+    Entry& insert(Stage s, const Key& key);
+
+    Generator808 generator;
+    const int entriesPerStage;
+    std::array<std::vector<Entry>, outputStage> cache; // the output stage isn't cached, it is the result
+    juce::uint64 useCounter = 0;
+    Stats stats;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(StagedGenerator)
+};
@@ -1,10 +1,19 @@
 #include "WavExporter.h"
+#include "StageTimers.h"
 
 bool WavExporter::saveBufferToWav(const juce::AudioBuffer<float>& buffer,
     double sampleRate,
     const juce::File& file,
-    int bitsPerSample)
+    int bitsPerSample,
+    int rootMidiNote,
+    bool keepMono)
 {
+    STAGE_TIMER(exportWav);
+    if (buffer.getNumChannels() == 0)
+        return false;
+
+    const bool expandMono = buffer.getNumChannels() == 1 && !keepMono;
+
     if (file.existsAsFile())
     {
         if (!file.deleteFile())
@@ -21,14 +30,29 @@ bool WavExporter::saveBufferToWav(const juce::AudioBuffer<float>& buffer,
         return false;
 
     juce::WavAudioFormat wavFormat;
+
+    juce::StringPairArray metadata;
+    if (rootMidiNote >= 0)
+    {
+        metadata.set("MidiUnityNote", juce::String(juce::jlimit(0, 127, rootMidiNote)));
+        metadata.set("SamplePeriod", juce::String((juce::int64)std::llround(1.0e9 / sampleRate)));
+    }
+
     // createWriterFor takes ownership of the stream pointer. We'll hand it the raw pointer from our unique_ptr.release()
     std::unique_ptr<juce::AudioFormatWriter> writer(
         wavFormat.createWriterFor(stream.release(), sampleRate,
-            (unsigned int)buffer.getNumChannels(),
-            bitsPerSample, {}, 0));
+            (unsigned int)(expandMono ? 2 : buffer.getNumChannels()),
+            bitsPerSample, metadata, 0));
     if (!writer)
         return false;
 
+    // a mono buffer is written to both channels of a stereo file from the same samples
+    if (expandMono)
+    {
+        const float* channels[] = { buffer.getReadPointer(0), buffer.getReadPointer(0) };
+        return writer->writeFromFloatArrays(channels, 2, buffer.getNumSamples());
+    }
+
     // writeFromAudioSampleBuffer will write the samples
     writer->writeFromAudioSampleBuffer(buffer, 0, buffer.getNumSamples());
     // writer destructor will delete the stream now
@@ -4,8 +4,13 @@
 class WavExporter
 {
 public:
+    // rootMidiNote >= 0 is written as the unity note of a 'smpl' chunk so samplers map the file correctly.
+    // Mono renders (one channel, see Generator808::getNumOutputChannels) are written as stereo files
+    // with the channel duplicated, unless keepMono asks for a mono file (half the size).
     static bool saveBufferToWav(const juce::AudioBuffer<float>& buffer,
                                 double sampleRate,
                                 const juce::File& file,
-                                int bitsPerSample = 24);
+                                int bitsPerSample = 24,
+                                int rootMidiNote = -1,
+                                bool keepMono = false);
 };